@@ -0,0 +1,82 @@
+import struct
+import sys
+
+# 从带符号表的kernel.elf中提取函数符号，生成填入.ksyms段的内核符号表
+# 用法: python ksym-gen.py kernel.elf kernel.sym
+# 格式: 头部(magic, count)，count个按地址排序的(addr, name_off)，然后是以0结尾的名称
+# name_off为名称相对符号表起始的偏移，总大小补0到.ksyms段的大小
+
+KSYM_MAGIC = 0x4D59534B
+SHT_SYMTAB = 2
+STT_FUNC = 2
+USER_BASE = 0x80000000
+
+if len(sys.argv) != 3:
+    print("usage: ksym-gen.py kernel.elf kernel.sym")
+    sys.exit(1)
+
+with open(sys.argv[1], "rb") as f:
+    elf = f.read()
+
+e_shoff, = struct.unpack_from("<I", elf, 0x20)
+e_shentsize, e_shnum, e_shstrndx = struct.unpack_from("<HHH", elf, 0x2E)
+
+sections = []
+for i in range(e_shnum):
+    sections.append(struct.unpack_from("<IIIIIIIIII", elf, e_shoff + i * e_shentsize))
+
+def section_name(sh):
+    strtab = sections[e_shstrndx]
+    start = strtab[4] + sh[0]
+    return elf[start:elf.index(b"\0", start)].decode()
+
+area = [sh for sh in sections if section_name(sh) == ".ksyms"]
+if not area:
+    print("ksym-gen: no .ksyms section in %s" % sys.argv[1])
+    sys.exit(1)
+area_size = area[0][5]
+
+# 只保留内核中的函数，first_task等用户态代码链接在0x80000000以上
+symbols = {}
+for sh in sections:
+    if sh[1] != SHT_SYMTAB:
+        continue
+
+    strtab = sections[sh[6]]
+    for off in range(sh[4], sh[4] + sh[5], sh[9]):
+        st_name, st_value, st_size, st_info, st_other, st_shndx = struct.unpack_from("<IIIBBH", elf, off)
+        if (st_info & 0xF) != STT_FUNC or st_shndx == 0 or st_value >= USER_BASE:
+            continue
+
+        start = strtab[4] + st_name
+        name = elf[start:elf.index(b"\0", start)]
+        if st_value not in symbols:
+            symbols[st_value] = name
+
+addrs = sorted(symbols)
+
+# 空间不足时丢弃地址最高的符号，这些地址查找时会归到前一个函数上
+while True:
+    count = len(addrs)
+    size = 8 + count * 8 + sum(len(symbols[a]) + 1 for a in addrs)
+    if size <= area_size:
+        break
+    addrs.pop()
+
+if count < len(symbols):
+    print("ksym-gen: .ksyms too small, %d of %d symbols kept" % (count, len(symbols)))
+
+table = struct.pack("<II", KSYM_MAGIC, count)
+names = b""
+name_base = 8 + count * 8
+for addr in addrs:
+    table += struct.pack("<II", addr, name_base + len(names))
+    names += symbols[addr] + b"\0"
+
+data = table + names
+data += b"\0" * (area_size - len(data))
+
+with open(sys.argv[2], "wb") as f:
+    f.write(data)
+
+print("ksym-gen: %d symbols, %d of %d bytes" % (count, size, area_size))
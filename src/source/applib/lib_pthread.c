@@ -0,0 +1,231 @@
+#include "lib_pthread.h"
+#include "lib_syscall.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <malloc.h>
+
+/**
+ * @brief 线程的启动信息，放在线程栈的顶部
+ * @param start 线程函数
+ * @param arg 线程函数的参数
+ * @param stack 线程栈的起始地址，回收线程时释放
+ * @param tid 线程的pid
+ * @param next 已创建未回收的线程链表
+ */
+typedef struct _pthread_rec_t{
+    void* (*start)(void*);
+    void* arg;
+    void* stack;
+    pthread_t tid;
+    struct _pthread_rec_t* next;
+}pthread_rec_t;
+
+/// @brief 互斥锁的状态
+#define MUTEX_UNLOCKED          0
+#define MUTEX_LOCKED            1
+#define MUTEX_CONTENDED         2
+
+/// @brief 已创建未回收的线程
+static pthread_rec_t* thread_list;
+
+/// @brief 保护thread_list
+static pthread_mutex_t list_mutex=PTHREAD_MUTEX_INITIALIZER;
+
+/// @brief 是否创建过线程，在此之前malloc不需要加锁
+static int thread_started;
+
+/// @brief malloc的递归锁
+static pthread_mutex_t malloc_mutex=PTHREAD_MUTEX_INITIALIZER;
+static pthread_t malloc_owner;
+static int malloc_count;
+
+static inline pthread_mutex_t atomic_xchg(volatile pthread_mutex_t* addr,pthread_mutex_t value){
+    __asm__ __volatile__("xchgl %0,%1":"+r"(value),"+m"(*addr)::"memory");
+    return value;
+}
+
+static inline pthread_mutex_t atomic_cmpxchg(volatile pthread_mutex_t* addr,pthread_mutex_t old,pthread_mutex_t value){
+    __asm__ __volatile__("lock cmpxchgl %2,%1":"+a"(old),"+m"(*addr):"r"(value):"memory");
+    return old;
+}
+
+/**
+ * @brief 线程的入口，线程函数返回后以其返回值结束线程
+ * @param arg 线程的启动信息
+ */
+static void pthread_entry(void* arg){
+    pthread_rec_t* rec=(pthread_rec_t*)arg;
+    pthread_exit(rec->start(rec->arg));
+}
+
+int pthread_create(pthread_t* thread,const pthread_attr_t* attr,void* (*start)(void*),void* arg){
+    size_t size=PTHREAD_STACK_DEFAULT;
+    if(attr && attr->is_initialized && (attr->stacksize>0)){
+        size=attr->stacksize;
+    }
+
+    // 先打开malloc的锁，保证lock与unlock成对
+    thread_started=1;
+
+    char* stack=(char*)malloc(size);
+    if(stack==(char*)0){
+        return EAGAIN;
+    }
+
+    pthread_rec_t* rec=(pthread_rec_t*)(stack+size-sizeof(pthread_rec_t));
+    rec->start=start;
+    rec->arg=arg;
+    rec->stack=stack;
+
+    // 新线程可能在thread_create返回前就已运行结束，先持有链表锁再创建
+    pthread_mutex_lock(&list_mutex);
+    int tid=thread_create(pthread_entry,rec,rec);
+    if(tid<0){
+        pthread_mutex_unlock(&list_mutex);
+        free(stack);
+        return EAGAIN;
+    }
+    rec->tid=(pthread_t)tid;
+    rec->next=thread_list;
+    thread_list=rec;
+    pthread_mutex_unlock(&list_mutex);
+
+    if(thread){
+        *thread=(pthread_t)tid;
+    }
+    return 0;
+}
+
+int pthread_join(pthread_t thread,void** retval){
+    int status;
+    if(thread_join((int)thread,&status)<0){
+        return ESRCH;
+    }
+
+    pthread_mutex_lock(&list_mutex);
+    pthread_rec_t** prev=&thread_list;
+    pthread_rec_t* rec=thread_list;
+    while(rec && (rec->tid!=thread)){
+        prev=&rec->next;
+        rec=rec->next;
+    }
+    if(rec){
+        *prev=rec->next;
+    }
+    pthread_mutex_unlock(&list_mutex);
+
+    if(rec){
+        free(rec->stack);
+    }
+
+    if(retval){
+        *retval=(void*)status;
+    }
+    return 0;
+}
+
+void pthread_exit(void* retval){
+    _exit((int)retval);
+}
+
+pthread_t pthread_self(void){
+    return (pthread_t)getpid();
+}
+
+int pthread_equal(pthread_t t1,pthread_t t2){
+    return t1==t2;
+}
+
+int pthread_attr_init(pthread_attr_t* attr){
+    memset(attr,0,sizeof(pthread_attr_t));
+    attr->is_initialized=1;
+    attr->stacksize=PTHREAD_STACK_DEFAULT;
+    return 0;
+}
+
+int pthread_attr_destroy(pthread_attr_t* attr){
+    attr->is_initialized=0;
+    return 0;
+}
+
+int pthread_attr_setstacksize(pthread_attr_t* attr,size_t stacksize){
+    if(stacksize<PTHREAD_STACK_MIN_SIZE){
+        return EINVAL;
+    }
+    attr->stacksize=stacksize;
+    return 0;
+}
+
+int pthread_mutex_init(pthread_mutex_t* mutex,const pthread_mutexattr_t* attr){
+    *mutex=PTHREAD_MUTEX_INITIALIZER;
+    return 0;
+}
+
+int pthread_mutex_destroy(pthread_mutex_t* mutex){
+    return 0;
+}
+
+/**
+ * @brief 获取互斥锁，只有发生竞争时才通过futex进入内核等待
+ * @note 锁的值：0空闲，1被占用且没有等待者，2被占用且可能有等待者
+ * @param mutex 互斥锁
+ * @return 0
+ */
+int pthread_mutex_lock(pthread_mutex_t* mutex){
+    pthread_mutex_t c=atomic_cmpxchg(mutex,MUTEX_UNLOCKED,MUTEX_LOCKED);
+    if(c==MUTEX_UNLOCKED){
+        return 0;
+    }
+
+    if(c!=MUTEX_CONTENDED){
+        c=atomic_xchg(mutex,MUTEX_CONTENDED);
+    }
+    while(c!=MUTEX_UNLOCKED){
+        futex((volatile int*)mutex,FUTEX_WAIT,MUTEX_CONTENDED,0);
+        c=atomic_xchg(mutex,MUTEX_CONTENDED);
+    }
+    return 0;
+}
+
+int pthread_mutex_trylock(pthread_mutex_t* mutex){
+    return (atomic_cmpxchg(mutex,MUTEX_UNLOCKED,MUTEX_LOCKED)==MUTEX_UNLOCKED) ? 0 : EBUSY;
+}
+
+int pthread_mutex_unlock(pthread_mutex_t* mutex){
+    if(atomic_xchg(mutex,MUTEX_UNLOCKED)==MUTEX_CONTENDED){
+        futex((volatile int*)mutex,FUTEX_WAKE,1,0);
+    }
+    return 0;
+}
+
+/**
+ * @brief 覆盖newlib的malloc锁，多线程下保护堆，同一线程可以重入
+ */
+void __malloc_lock(struct _reent* reent){
+    if(!thread_started){
+        return;
+    }
+
+    pthread_t self=pthread_self();
+    if(malloc_count && (malloc_owner==self)){
+        malloc_count++;
+        return;
+    }
+
+    pthread_mutex_lock(&malloc_mutex);
+    malloc_owner=self;
+    malloc_count=1;
+}
+
+void __malloc_unlock(struct _reent* reent){
+    if(!thread_started){
+        return;
+    }
+
+    if(--malloc_count==0){
+        malloc_owner=0;
+        pthread_mutex_unlock(&malloc_mutex);
+    }
+}
\ No newline at end of file
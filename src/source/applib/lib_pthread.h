@@ -0,0 +1,33 @@
+#ifndef LIB_PTHREAD_H
+#define LIB_PTHREAD_H
+
+/// @brief newlib的pthread.h会引入与lib_syscall.h冲突的unistd.h，只使用sys/types.h中的类型
+#include <sys/types.h>
+
+/// @brief newlib没有打开_POSIX_THREADS，这里补充互斥锁的静态初始化值
+#ifndef PTHREAD_MUTEX_INITIALIZER
+#define PTHREAD_MUTEX_INITIALIZER       ((pthread_mutex_t)0)
+#endif
+
+/// @brief 线程栈的默认大小
+#define PTHREAD_STACK_DEFAULT           (64*1024)
+
+/// @brief 线程栈的最小大小
+#define PTHREAD_STACK_MIN_SIZE          (4*1024)
+
+int pthread_create(pthread_t* thread,const pthread_attr_t* attr,void* (*start)(void*),void* arg);
+int pthread_join(pthread_t thread,void** retval);
+void pthread_exit(void* retval);
+pthread_t pthread_self(void);
+int pthread_equal(pthread_t t1,pthread_t t2);
+
+int pthread_attr_init(pthread_attr_t* attr);
+int pthread_attr_destroy(pthread_attr_t* attr);
+int pthread_attr_setstacksize(pthread_attr_t* attr,size_t stacksize);
+
+int pthread_mutex_init(pthread_mutex_t* mutex,const pthread_mutexattr_t* attr);
+int pthread_mutex_destroy(pthread_mutex_t* mutex);
+int pthread_mutex_lock(pthread_mutex_t* mutex);
+int pthread_mutex_trylock(pthread_mutex_t* mutex);
+int pthread_mutex_unlock(pthread_mutex_t* mutex);
+#endif
\ No newline at end of file
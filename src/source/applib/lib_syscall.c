@@ -6,7 +6,74 @@
 #include <stdlib.h>
 #include <string.h>
 
+/// @brief 是否使用SYSENTER进入内核，-1表示尚未检测
+static int use_sysenter=-1;
+
+/**
+ * @brief 检测CPU是否支持SYSENTER，内核在支持时总会设置好入口
+ * @note 早期的Pentium Pro虽然报告SEP位但并不支持该指令
+ */
+static int sysenter_detect(void){
+    uint32_t eax,ebx,ecx,edx;
+    __asm__ __volatile__(
+        "cpuid"
+        :"=a"(eax),"=b"(ebx),"=c"(ecx),"=d"(edx)
+        :"a"(1),"c"(0)
+    );
+
+    uint32_t family=(eax >> 8) & 0xF;
+    uint32_t model=(eax >> 4) & 0xF;
+    uint32_t stepping=eax & 0xF;
+    return (edx & (1 << 11)) && !(family==6 && model<3 && stepping<3);
+}
+
+/**
+ * @brief 通过SYSENTER进入内核，参数全部经寄存器传递
+ *        ebp用作第四个参数，调用前后由用户栈保存
+ */
+static inline int sys_call_fast(syscall_args_t*args){
+    int ret;
+    __asm__ __volatile__(
+        "push %%ebp\n\t"
+        "mov 4(%%eax),%%ebx\n\t"
+        "mov 8(%%eax),%%esi\n\t"
+        "mov 12(%%eax),%%edi\n\t"
+        "mov 16(%%eax),%%ebp\n\t"
+        "mov 0(%%eax),%%eax\n\t"
+        "mov %%esp,%%ecx\n\t"
+        "mov $1f,%%edx\n\t"
+        "sysenter\n\t"
+        "1:\n\t"
+        "pop %%ebp"
+        :"=a"(ret)
+        :"a"(args)
+        :"ebx","ecx","edx","esi","edi","memory"
+    );
+    return ret;
+}
+
+/**
+ * @brief 选择系统调用的进入方式，用于对比两种方式的开销
+ * @param enable 1 使用SYSENTER（CPU支持时），0 使用调用门
+ * @return 设置前是否在使用SYSENTER
+ */
+int syscall_use_sysenter(int enable){
+    if(use_sysenter<0){
+        use_sysenter=sysenter_detect();
+    }
+    int old=use_sysenter;
+    use_sysenter=enable && sysenter_detect();
+    return old;
+}
+
 static inline int sys_call(syscall_args_t*args){
+    if(use_sysenter<0){
+        use_sysenter=sysenter_detect();
+    }
+    if(use_sysenter){
+        return sys_call_fast(args);
+    }
+
     uint32_t addr[]={0,SELECTOR_SYSCALL | 0};
     int ret;
     __asm__ __volatile__(
@@ -39,12 +106,31 @@ void msleep(int ms){
     sys_call(&args);
 }
 
-int getpid(void){
+/**
+ * @brief 通过系统调用获取pid，getpid直接读取vdso页
+ * @return 当前任务的pid
+ */
+int getpid_syscall(void){
     syscall_args_t args;
     args.id=SYS_GETPID;
     return sys_call(&args);
 }
 
+/// @brief 内核映射的只读共享页
+static const vdso_data_t* const vdso=(const vdso_data_t*)VDSO_ADDR;
+
+int getpid(void){
+    return vdso->pid;
+}
+
+/**
+ * @brief 读取启动以来的tick数，不陷入内核
+ * @return tick数，每个tick的毫秒数见vdso_data_t的tick_ms
+ */
+uint32_t get_tick(void){
+    return ((const volatile vdso_data_t*)vdso)->tick;
+}
+
 void print_msg(const char* fmt,int arg){
     syscall_args_t args;
     args.id=SYS_PRINT_MSG;
@@ -184,6 +270,399 @@ int wait(int* status){
     return sys_call(&args);
 }
 
+int waitpid(int pid,int* status,int options){
+    syscall_args_t args;
+    args.id=SYS_WAITPID;
+    args.arg0=pid;
+    args.arg1=(int)status;
+    args.arg2=options;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief 创建一个与当前进程共享地址空间的线程
+ * @param entry 线程入口，不能直接返回，结束时调用_exit
+ * @param arg 传给入口的参数
+ * @param stack_top 线程用户栈的栈顶
+ * @return 成功返回线程的pid，失败返回-1
+ */
+int thread_create(void (*entry)(void*),void* arg,void* stack_top){
+    syscall_args_t args;
+    args.id=SYS_THREAD_CREATE;
+    args.arg0=(int)entry;
+    args.arg1=(int)arg;
+    args.arg2=(int)stack_top;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief 等待同一进程中的线程结束
+ * @param tid 线程的pid
+ * @param status 线程的退出状态，可以为0
+ * @return 成功返回线程的pid，失败返回-1
+ */
+int thread_join(int tid,int* status){
+    syscall_args_t args;
+    args.id=SYS_THREAD_JOIN;
+    args.arg0=tid;
+    args.arg1=(int)status;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief futex系统调用
+ * @param addr 4字节对齐的整数地址
+ * @param op FUTEX_WAIT：*addr等于val时等待；FUTEX_WAKE：最多唤醒val个等待者
+ * @param val 期望的值或唤醒的数量
+ * @param timeout_ms FUTEX_WAIT的超时时间，0表示一直等待
+ * @return FUTEX_WAIT被唤醒返回0，FUTEX_WAKE返回唤醒的数量，失败返回-1
+ */
+int futex(volatile int* addr,int op,int val,int timeout_ms){
+    syscall_args_t args;
+    args.id=SYS_FUTEX;
+    args.arg0=(int)addr;
+    args.arg1=op;
+    args.arg2=val;
+    args.arg3=timeout_ms;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief 设置任务的优先级
+ * @param pid 任务的pid，0表示当前任务
+ * @param prio 新的优先级，数值越小优先级越高
+ * @return 成功返回原来的优先级，失败返回-1
+ */
+int setprio(int pid,int prio){
+    syscall_args_t args;
+    args.id=SYS_SETPRIO;
+    args.arg0=pid;
+    args.arg1=prio;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief 获取关中断时间的统计
+ * @param info 保存统计结果，可以为0
+ * @param flags IRQOFF_RESET、IRQOFF_ENABLE、IRQOFF_DISABLE的组合
+ * @return 成功返回0，失败返回-1
+ */
+int irqoff_trace(irqoff_info_t* info,int flags){
+    syscall_args_t args;
+    args.id=SYS_IRQOFF_TRACE;
+    args.arg0=(int)info;
+    args.arg1=flags;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief 设置任务的系统调用统计和跟踪选项
+ * @param pid 任务的pid，0表示当前任务
+ * @param flags SYSCALL_TRACK_xxx的组合，为0时关闭
+ * @return 原来的选项，失败返回-1
+ */
+int syscall_ctl(int pid,int flags){
+    syscall_args_t args;
+    args.id=SYS_SYSCALL_CTL;
+    args.arg0=pid;
+    args.arg1=flags;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief 获取按调用号的系统调用统计
+ * @param pid 任务的pid，0表示当前任务，SYSCALL_STAT_ALL表示系统范围
+ * @param stat 保存结果，需要SYSCALL_STAT_NR项，可以为0
+ * @param reset 为1时清除统计
+ * @return 成功返回0，失败返回-1
+ */
+int syscall_stat(int pid,syscall_stat_t* stat,int reset){
+    syscall_args_t args;
+    args.id=SYS_SYSCALL_STAT;
+    args.arg0=pid;
+    args.arg1=(int)stat;
+    args.arg2=reset;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief 取出任务的系统调用跟踪记录
+ * @param pid 任务的pid，0表示当前任务
+ * @param buf 保存记录
+ * @param count buf的容量
+ * @return 取出的记录数，失败返回-1
+ */
+int syscall_trace(int pid,syscall_trace_t* buf,int count){
+    syscall_args_t args;
+    args.id=SYS_SYSCALL_TRACE;
+    args.arg0=pid;
+    args.arg1=(int)buf;
+    args.arg2=count;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief 获取启动过程各阶段的耗时
+ * @param buf 保存各阶段，可以为0
+ * @param count buf的项数
+ * @return 读取的阶段数，buf为0时返回总的阶段数，启动尚未完成时返回-1
+ */
+int boot_time(boot_phase_t* buf,int count){
+    syscall_args_t args;
+    args.id=SYS_BOOT_TIME;
+    args.arg0=(int)buf;
+    args.arg1=count;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief 开始或停止定时器采样
+ * @param cmd PROF_CMD_START开始采样并清除之前的采样，PROF_CMD_STOP停止采样
+ * @param period_ms 开始采样时的采样间隔，以时钟中断的周期为最小单位
+ * @return 成功返回0，失败返回-1
+ */
+int prof_ctl(int cmd,int period_ms){
+    syscall_args_t args;
+    args.id=SYS_PROF_CTL;
+    args.arg0=cmd;
+    args.arg1=period_ms;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief 读取已记录的采样
+ * @param buf 保存采样，可以为0
+ * @param start 从第几个采样开始读取
+ * @param count buf的项数
+ * @param info 保存采样状态，可以为0
+ * @return 读取的采样数，失败返回-1
+ */
+int prof_read(prof_sample_t* buf,int start,int count,prof_info_t* info){
+    syscall_args_t args;
+    args.id=SYS_PROF_READ;
+    args.arg0=(int)buf;
+    args.arg1=start;
+    args.arg2=count;
+    args.arg3=(int)info;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief 查找内核地址所在的函数
+ * @param addr 内核代码中的地址
+ * @param name 保存函数名，可以为0
+ * @param size name的大小
+ * @return 函数的起始地址，找不到时返回0
+ */
+int ksym_lookup(uint32_t addr,char* name,int size){
+    syscall_args_t args;
+    args.id=SYS_KSYM_LOOKUP;
+    args.arg0=addr;
+    args.arg1=(int)name;
+    args.arg2=size;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief 清空批量系统调用
+ * @param batch 批量调用
+ */
+void batch_init(syscall_batch_t* batch){
+    batch->count=0;
+}
+
+/**
+ * @brief 向批量系统调用中加入一项
+ * @param batch 批量调用
+ * @param id 系统调用号，不能为fork、execve或批量调用本身
+ * @return 该项的序号，用于读取结果，已满返回-1
+ */
+int batch_add(syscall_batch_t* batch,int id,int arg0,int arg1,int arg2,int arg3){
+    if(batch->count>=SYSCALL_BATCH_MAX){
+        return -1;
+    }
+
+    int index=batch->count++;
+    syscall_args_t* args=batch->calls+index;
+    args->id=id;
+    args->arg0=arg0;
+    args->arg1=arg1;
+    args->arg2=arg2;
+    args->arg3=arg3;
+    batch->results[index]=-1;
+    return index;
+}
+
+int batch_read(syscall_batch_t* batch,int fd,char* buf,int size){
+    return batch_add(batch,SYS_READ,fd,(int)buf,size,0);
+}
+
+int batch_write(syscall_batch_t* batch,int fd,char* buf,int size){
+    return batch_add(batch,SYS_WRITE,fd,(int)buf,size,0);
+}
+
+int batch_lseek(syscall_batch_t* batch,int fd,int offset,int dir){
+    return batch_add(batch,SYS_LSEEK,fd,offset,dir,0);
+}
+
+int batch_close(syscall_batch_t* batch,int fd){
+    return batch_add(batch,SYS_CLOSE,fd,0,0,0);
+}
+
+/**
+ * @brief 一次进入内核执行批量调用中的全部项，结果保存在batch->results中
+ * @param batch 批量调用
+ * @param flags BATCH_STOP_ON_ERROR或0
+ * @return 实际执行的项数，失败返回-1
+ */
+int batch_submit(syscall_batch_t* batch,int flags){
+    if(batch->count==0){
+        return 0;
+    }
+
+    syscall_args_t args;
+    args.id=SYS_BATCH;
+    args.arg0=(int)batch->calls;
+    args.arg1=(int)batch->results;
+    args.arg2=batch->count;
+    args.arg3=flags;
+
+    return sys_call(&args);
+}
+
+int get_task_info(task_info_t* info,int count){
+    syscall_args_t args;
+    args.id=SYS_TASK_INFO;
+    args.arg0=(int)info;
+    args.arg1=count;
+
+    return sys_call(&args);
+}
+
+int get_sys_info(sys_info_t* info){
+    syscall_args_t args;
+    args.id=SYS_SYS_INFO;
+    args.arg0=(int)info;
+
+    return sys_call(&args);
+}
+
+int sched_lat(int pid,sched_lat_t* lat,int reset){
+    syscall_args_t args;
+    args.id=SYS_SCHED_LAT;
+    args.arg0=pid;
+    args.arg1=(int)lat;
+    args.arg2=reset;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief 64位数除以32位数，用户态没有libgcc，不能直接使用64位除法
+ * @param n 被除数
+ * @param base 除数
+ * @param rem 余数
+ * @return 商
+ */
+static uint64_t div_u64_rem(uint64_t n,uint32_t base,uint32_t* rem){
+    uint32_t high=(uint32_t)(n >> 32);
+    uint32_t low=(uint32_t)n;
+
+    // 先除高32位，保证divl的商不会溢出
+    uint32_t q_high=0;
+    if(high>=base){
+        q_high=high/base;
+        high%=base;
+    }
+
+    uint32_t q_low,r;
+    __asm__ __volatile__(
+        "divl %[base]"
+        :"=a"(q_low),"=d"(r)
+        :"a"(low),"d"(high),[base]"rm"(base)
+    );
+    *rem=r;
+    return ((uint64_t)q_high << 32) | q_low;
+}
+
+static inline uint64_t vdso_rdtsc(void){
+    uint32_t low,high;
+    __asm__ __volatile__("rdtsc":"=a"(low),"=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+/**
+ * @brief 从vdso页读取单调时间，读取期间内核更新了共享页则重读
+ * @param boot_sec 返回启动时的墙上时间
+ * @return 启动以来的纳秒数
+ */
+static uint64_t vdso_monotonic_ns(uint32_t* boot_sec){
+    const volatile vdso_data_t* data=(const volatile vdso_data_t*)vdso;
+    uint32_t seq;
+    uint64_t ns;
+
+    do{
+        seq=data->seq;
+        __asm__ __volatile__("":::"memory");
+
+        ns=data->mono_ns;
+        if(data->khz){
+            ns+=((vdso_rdtsc()-data->cycle_last)*data->mult) >> data->shift;
+        }
+        *boot_sec=data->boot_sec;
+
+        __asm__ __volatile__("":::"memory");
+    }while((seq & 1) || seq!=data->seq);
+    return ns;
+}
+
+int clock_gettime(clockid_t clk_id,struct timespec* ts){
+    if(ts==(struct timespec*)0){
+        return -1;
+    }
+
+    uint32_t boot_sec,nsec;
+    uint64_t sec=div_u64_rem(vdso_monotonic_ns(&boot_sec),1000000000,&nsec);
+    switch(clk_id){
+        case CLOCK_MONOTONIC:
+            break;
+        case CLOCK_REALTIME:
+            sec+=boot_sec;
+            break;
+        default:
+            return -1;
+    }
+
+    ts->tv_sec=sec;
+    ts->tv_nsec=nsec;
+    return 0;
+}
+
+int gettimeofday(struct timeval* tv,void* tz){
+    if(tv==(struct timeval*)0){
+        return -1;
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME,&ts);
+    tv->tv_sec=ts.tv_sec;
+    tv->tv_usec=ts.tv_nsec/1000;
+    return 0;
+}
+
 DIR *opendir(const char* path){
     DIR *dir = (DIR*)malloc(sizeof(DIR));
     if(dir == NULL){
@@ -254,4 +733,179 @@ int unlink(const char *path){
     args.arg0=(int)path;
 
     return sys_call(&args);
+}
+
+/**
+ * @brief 创建管道
+ * @param fds fds[0]为读端，fds[1]为写端，读端在写端全部关闭后读到文件结束
+ * @return 成功返回0，失败返回-1
+ */
+int pipe(int fds[2]){
+    syscall_args_t args;
+
+    args.id=SYS_PIPE;
+    args.arg0=(int)fds;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief 等待多个文件中的任意一个可读写
+ * @param fds 查询的文件，返回时revents为发生的事件
+ * @param nfds 文件数量，最多POLL_MAX_FDS个
+ * @param timeout_ms 超时时间，小于0表示一直等待，0表示立即返回
+ * @return 有事件的文件数量，超时返回0，失败返回-1
+ */
+int poll(struct pollfd* fds,int nfds,int timeout_ms){
+    syscall_args_t args;
+
+    args.id=SYS_POLL;
+    args.arg0=(int)fds;
+    args.arg1=nfds;
+    args.arg2=timeout_ms;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief 创建本地流式套接字
+ * @param domain AF_LOCAL
+ * @param type SOCK_STREAM
+ * @param protocol 0
+ * @return 文件描述符，失败返回-1
+ */
+int socket(int domain,int type,int protocol){
+    syscall_args_t args;
+
+    args.id=SYS_SOCKET;
+    args.arg0=domain;
+    args.arg1=type;
+    args.arg2=protocol;
+
+    return sys_call(&args);
+}
+
+int bind(int fd,const struct sockaddr_un* addr,int len){
+    syscall_args_t args;
+
+    args.id=SYS_BIND;
+    args.arg0=fd;
+    args.arg1=(int)addr;
+    args.arg2=len;
+
+    return sys_call(&args);
+}
+
+int listen(int fd,int backlog){
+    syscall_args_t args;
+
+    args.id=SYS_LISTEN;
+    args.arg0=fd;
+    args.arg1=backlog;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief 取出一个已建立的连接，没有连接时等待
+ * @param fd 监听套接字
+ * @param addr 保存对方的地址，可以为0
+ * @param len 地址的长度，可以为0
+ * @return 新连接的文件描述符，失败返回-1
+ */
+int accept(int fd,struct sockaddr_un* addr,int* len){
+    syscall_args_t args;
+
+    args.id=SYS_ACCEPT;
+    args.arg0=fd;
+    args.arg1=(int)addr;
+    args.arg2=(int)len;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief 连接到监听中的套接字，不等待对方accept
+ * @param fd 套接字
+ * @param addr 监听套接字的地址
+ * @param len 地址的长度
+ * @return 成功返回0，失败返回-1
+ */
+int connect(int fd,const struct sockaddr_un* addr,int len){
+    syscall_args_t args;
+
+    args.id=SYS_CONNECT;
+    args.arg0=fd;
+    args.arg1=(int)addr;
+    args.arg2=len;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief 创建当前进程的异步I/O环，映射到AIO_RING_ADDR
+ * @return 异步I/O环，失败返回0
+ */
+aio_ring_t* aio_setup(void){
+    syscall_args_t args;
+
+    args.id=SYS_AIO_SETUP;
+
+    return (aio_ring_t*)sys_call(&args);
+}
+
+/**
+ * @brief 提交环中全部已填写的提交项，并等待至少min_complete个完成项
+ * @param min_complete 完成队列中至少有这么多项时返回，已提交的操作全部完成时也返回，不能为负数
+ * @return 本次提交的项数，失败返回-1
+ */
+int aio_enter(int min_complete){
+    syscall_args_t args;
+
+    args.id=SYS_AIO_ENTER;
+    args.arg0=min_complete;
+
+    return sys_call(&args);
+}
+
+/**
+ * @brief 取得一个空闲的提交项，填写后由aio_enter提交
+ * @param ring 异步I/O环
+ * @return 提交项，提交队列已满返回0
+ */
+aio_sqe_t* aio_get_sqe(aio_ring_t* ring){
+    uint32_t tail=ring->sq_tail;
+    if(tail-ring->sq_head>=AIO_SQ_ENTRIES){
+        return (aio_sqe_t*)0;
+    }
+
+    aio_sqe_t* sqe=ring->sqes+(tail & (AIO_SQ_ENTRIES-1));
+    ring->sq_tail=tail+1;
+    return sqe;
+}
+
+void aio_prep_rw(aio_sqe_t* sqe,int op,int fd,void* buf,uint32_t len,uint32_t offset,uint32_t user_data){
+    sqe->op=op;
+    sqe->fd=fd;
+    sqe->buf=buf;
+    sqe->len=len;
+    sqe->offset=offset;
+    sqe->user_data=user_data;
+}
+
+/**
+ * @brief 取出一个完成项
+ * @param ring 异步I/O环
+ * @param cqe 保存完成项
+ * @return 1 取到，0 完成队列为空
+ */
+int aio_peek_cqe(aio_ring_t* ring,aio_cqe_t* cqe){
+    uint32_t head=ring->cq_head;
+    if(head==ring->cq_tail){
+        return 0;
+    }
+
+    *cqe=ring->cqes[head & (AIO_CQ_ENTRIES-1)];
+    ring->cq_head=head+1;
+    return 1;
 }
\ No newline at end of file
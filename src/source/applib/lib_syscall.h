@@ -2,6 +2,17 @@
 #define LIB_SYSCALL_H
 
 #include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
+
+/// @brief newlib没有打开POSIX时钟的定义，这里补充
+#ifndef CLOCK_REALTIME
+#define CLOCK_REALTIME          1
+#endif
+
+#ifndef CLOCK_MONOTONIC
+#define CLOCK_MONOTONIC         4
+#endif
 
 
 typedef struct _syscall_args_t{
@@ -34,7 +45,13 @@ int dup(int file);
 
 void _exit(int status);
 
+/// @brief newlib没有WNOWAIT，这里补充，取值与内核的WAIT_NOWAIT一致
+#ifndef WNOWAIT
+#define WNOWAIT                 4
+#endif
+
 int wait(int* status);
+int waitpid(int pid,int* status,int options);
 
 /**
  * @brief 目录项结构体
@@ -61,10 +78,417 @@ typedef struct _DIR{
 }DIR;
 
 
+/// @brief 任务信息中名称的长度
+#define TASK_INFO_NAME_SIZE     32
+
+/**
+ * @brief 任务信息，用于ps/top命令
+ * @param pid 任务的pid
+ * @param ppid 父进程的pid
+ * @param state 任务状态：R运行/就绪 S睡眠 W等待 Z僵尸 C创建
+ * @param name 任务名称
+ * @param utime 用户态运行的tick数
+ * @param stime 内核态运行的tick数
+ * @param nvcsw 主动切换次数
+ * @param nivcsw 被抢占次数
+ * @param wait_ticks 在就绪队列中等待的tick数
+ * @param prio 当前优先级，数值越小优先级越高
+ */
+typedef struct _task_info_t{
+    int pid;
+    int ppid;
+    char state;
+    char name[TASK_INFO_NAME_SIZE];
+    unsigned int utime;
+    unsigned int stime;
+    unsigned int nvcsw;
+    unsigned int nivcsw;
+    unsigned int wait_ticks;
+    int prio;
+}task_info_t;
+
+/**
+ * @brief 系统信息
+ * @param ticks 系统启动后的tick数
+ * @param tick_ms 每个tick的毫秒数
+ * @param task_count 任务总数
+ * @param nr_running 就绪的任务数
+ * @param loadavg 1、5、15分钟的平均负载，低11位为小数部分
+ */
+typedef struct _sys_info_t{
+    unsigned int ticks;
+    unsigned int tick_ms;
+    int task_count;
+    int nr_running;
+    unsigned int loadavg[3];
+}sys_info_t;
+
+/// @brief 调度延迟直方图的桶数，第i个桶统计[2^i,2^(i+1))个时钟周期的延迟
+#define SCHED_LAT_BUCKETS       40
+
+/**
+ * @brief 调度延迟统计，记录任务从进入就绪队列到开始运行的时间
+ * @param hist 按时钟周期数log2分桶的直方图
+ * @param count 统计的次数
+ * @param max 最大延迟的时钟周期数
+ * @param max_pid 出现最大延迟的任务pid
+ * @param max_name 出现最大延迟的任务名称
+ */
+typedef struct _sched_lat_t{
+    unsigned int hist[SCHED_LAT_BUCKETS];
+    unsigned int count;
+    unsigned long long max;
+    int max_pid;
+    char max_name[TASK_INFO_NAME_SIZE];
+}sched_lat_t;
+
+/// @brief 关中断时间统计保留的最长区间数量
+#define IRQOFF_TOP_NR           16
+
+/// @brief irqoff_trace的控制选项：清除统计、开启统计、关闭统计，统计默认关闭
+#define IRQOFF_RESET            (1 << 0)
+#define IRQOFF_ENABLE           (1 << 1)
+#define IRQOFF_DISABLE          (1 << 2)
+
+/**
+ * @brief 一个关中断区间的统计，按关中断与开中断的调用位置区分
+ * @param enter_ip 关中断的位置，中断入口开始的区间为汇编入口中调用irq_enter的位置
+ * @param leave_ip 开中断的位置
+ * @param max_ns 该位置出现过的最长关中断时间
+ * @param count 该位置进入统计的次数
+ */
+typedef struct _irqoff_span_t{
+    unsigned int enter_ip;
+    unsigned int leave_ip;
+    unsigned int max_ns;
+    unsigned int count;
+}irqoff_span_t;
+
+/**
+ * @brief 关中断时间统计
+ * @param count 统计的关中断次数
+ * @param max_ns 最长的关中断时间
+ * @param avg_ns 平均的关中断时间
+ * @param nr spans中有效的数量
+ * @param enabled 统计是否开启
+ * @param spans 按max_ns从大到小排列的最长区间
+ */
+typedef struct _irqoff_info_t{
+    unsigned int count;
+    unsigned int max_ns;
+    unsigned int avg_ns;
+    int nr;
+    int enabled;
+    irqoff_span_t spans[IRQOFF_TOP_NR];
+}irqoff_info_t;
+
+/// @brief 系统调用号的数量，即最大的系统调用号加1
+#define SYSCALL_STAT_NR         101
+
+/// @brief 延迟直方图的桶数，第0桶为小于2^SHIFT纳秒，第i桶为[2^(i+SHIFT-1),2^(i+SHIFT))纳秒，最后一桶不设上限
+#define SYSCALL_HIST_NR         16
+#define SYSCALL_HIST_SHIFT      8
+
+/// @brief syscall_stat的pid取该值时读取系统范围的统计
+#define SYSCALL_STAT_ALL        -1
+
+/// @brief 任务的系统调用跟踪选项：按调用号统计、记录每次调用
+#define SYSCALL_TRACK_STAT      (1 << 0)
+#define SYSCALL_TRACK_TRACE     (1 << 1)
+
+/// @brief 每个任务的跟踪记录环形缓冲区大小，写满后覆盖最早的记录
+#define SYSCALL_TRACE_NR        128
+
+/**
+ * @brief 单个系统调用的统计
+ * @param count 调用次数
+ * @param errors 返回负数的次数
+ * @param total_ns 累计耗时，包含在内核中阻塞的时间
+ * @param max_ns 最长的一次耗时
+ * @param hist 按耗时的log2分布的调用次数
+ */
+typedef struct _syscall_stat_t{
+    uint32_t count;
+    uint32_t errors;
+    uint64_t total_ns;
+    uint32_t max_ns;
+    uint32_t hist[SYSCALL_HIST_NR];
+}syscall_stat_t;
+
+/**
+ * @brief 一次系统调用的跟踪记录
+ * @param seq 序号，不连续说明中间的记录已被覆盖
+ * @param id 系统调用号
+ * @param args 参数
+ * @param ret 返回值
+ * @param ns 耗时
+ */
+typedef struct _syscall_trace_t{
+    uint32_t seq;
+    int id;
+    int args[4];
+    int ret;
+    uint32_t ns;
+}syscall_trace_t;
+
+/// @brief 启动过程最多记录的阶段数，以及阶段名的最大长度
+#define BOOT_PHASE_NR           40
+#define BOOT_PHASE_NAME_SIZE    20
+
+/**
+ * @brief 启动过程中的一个阶段，时间从CPU复位时TSC为0算起
+ * @param name 阶段名
+ * @param end_us 阶段结束的时间
+ * @param us 阶段的耗时
+ */
+typedef struct _boot_phase_t{
+    char name[BOOT_PHASE_NAME_SIZE];
+    uint32_t end_us;
+    uint32_t us;
+}boot_phase_t;
+
+/// @brief 采样分析的控制命令
+#define PROF_CMD_START          0
+#define PROF_CMD_STOP           1
+
+/// @brief 采样缓冲区的容量，写满后丢弃之后的采样
+#define PROF_SAMPLE_NR          4096
+
+/// @brief 内核函数名的最大长度
+#define KSYM_NAME_SIZE          48
+
+/**
+ * @brief 定时器中断时记录的一次采样
+ * @param eip 被中断的指令地址
+ * @param pid 当前任务的pid
+ * @param cpl 被中断时的特权级，0为内核态，3为用户态
+ */
+typedef struct _prof_sample_t{
+    uint32_t eip;
+    int pid;
+    int cpl;
+}prof_sample_t;
+
+/**
+ * @brief 采样的状态
+ * @param running 是否正在采样
+ * @param period_ms 采样间隔的毫秒数
+ * @param nr 已记录的采样数
+ * @param lost 缓冲区满后丢弃的采样数
+ */
+typedef struct _prof_info_t{
+    int running;
+    int period_ms;
+    uint32_t nr;
+    uint32_t lost;
+}prof_info_t;
+
+/// @brief 一次批量系统调用最多包含的项数
+#define SYSCALL_BATCH_MAX       64
+
+/// @brief 批量系统调用中某项返回负数时停止执行后续各项
+#define BATCH_STOP_ON_ERROR     (1 << 0)
+
+/**
+ * @brief 用户态构造的批量系统调用
+ * @param calls 各项的调用号和参数
+ * @param results 各项的返回值，未执行的项为-1
+ * @param count 已加入的项数
+ */
+typedef struct _syscall_batch_t{
+    syscall_args_t calls[SYSCALL_BATCH_MAX];
+    int results[SYSCALL_BATCH_MAX];
+    int count;
+}syscall_batch_t;
+
+/// @brief poll的事件，newlib没有<poll.h>，取值与Linux一致
+#ifndef POLLIN
+#define POLLIN                  0x001
+#define POLLOUT                 0x004
+#define POLLERR                 0x008
+#define POLLHUP                 0x010
+#define POLLNVAL                0x020
+#endif
+
+/// @brief 本地套接字，newlib没有<sys/socket.h>，这里补充
+#define AF_LOCAL                1
+#define AF_UNIX                 AF_LOCAL
+#define SOCK_STREAM             1
+
+/// @brief 套接字名字的最大长度，包括结尾的0
+#define SOCK_NAME_SIZE          32
+
+/**
+ * @brief 本地套接字的地址
+ * @param sun_family AF_LOCAL
+ * @param sun_path 名字，所有进程共享同一个名字空间，监听套接字关闭时释放
+ */
+struct sockaddr_un{
+    unsigned short sun_family;
+    char sun_path[SOCK_NAME_SIZE];
+};
+
+/// @brief 一次poll最多查询的文件数量
+#define POLL_MAX_FDS            16
+
+/**
+ * @brief poll查询的文件
+ * @param fd 文件描述符，小于0时忽略该项
+ * @param events 关心的事件
+ * @param revents 返回时发生的事件，POLLERR、POLLHUP、POLLNVAL总是返回
+ */
+struct pollfd{
+    int fd;
+    short events;
+    short revents;
+};
+
+/// @brief 内核映射到每个用户地址空间的只读页，用户态无需陷入内核即可读取
+#define VDSO_ADDR               0xF0000000
+
+/**
+ * @brief 共享页的内容，时间相关字段由内核在时钟中断中更新
+ * @param seq 更新计数，内核写入期间为奇数，读者在前后两次读到相同的偶数值时结果有效
+ * @param pid 当前运行任务的pid，任务切换时更新
+ * @param tick 启动以来的tick数
+ * @param tick_ms 每个tick的毫秒数
+ * @param khz TSC频率，为0表示没有TSC，此时时间精度为一个tick
+ * @param mult 周期数转换为纳秒的乘数
+ * @param shift 周期数转换为纳秒的移位数
+ * @param cycle_last 上一次更新时的TSC值
+ * @param mono_ns 上一次更新时的单调时间，单位纳秒
+ * @param boot_sec 启动时的墙上时间，1970年以来的秒数
+ */
+typedef struct _vdso_data_t{
+    volatile uint32_t seq;
+    volatile int pid;
+    uint32_t tick;
+    uint32_t tick_ms;
+    uint32_t khz;
+    uint32_t mult;
+    uint32_t shift;
+    uint64_t cycle_last;
+    uint64_t mono_ns;
+    uint32_t boot_sec;
+}vdso_data_t;
+
+/// @brief 异步I/O环所在的用户地址，紧跟在vdso页之后，每个进程最多一个
+#define AIO_RING_ADDR           (VDSO_ADDR+0x1000)
+
+/// @brief 提交队列和完成队列的项数，必须是2的幂
+#define AIO_SQ_ENTRIES          64
+#define AIO_CQ_ENTRIES          128
+
+/// @brief 异步I/O的操作
+#define AIO_OP_NOP              0
+#define AIO_OP_READ             1
+#define AIO_OP_WRITE            2
+#define AIO_OP_FSYNC            3
+
+/// @brief offset取该值时使用文件当前的读写位置
+#define AIO_OFFSET_CURRENT      0xFFFFFFFF
+
+/**
+ * @brief 提交队列项，由用户填写
+ * @param op AIO_OP_xxx
+ * @param fd 文件描述符，提交时解析，之后关闭fd不影响已提交的操作
+ * @param offset 文件内的偏移，AIO_OFFSET_CURRENT表示当前位置
+ * @param buf 用户缓冲区，完成之前不能释放
+ * @param len 读写的字节数
+ * @param user_data 原样返回到完成队列项中，用于匹配请求
+ */
+typedef struct _aio_sqe_t{
+    int op;
+    int fd;
+    uint32_t offset;
+    void* buf;
+    uint32_t len;
+    uint32_t user_data;
+}aio_sqe_t;
+
+/**
+ * @brief 完成队列项，由内核填写
+ * @param user_data 对应提交队列项的user_data
+ * @param res 操作的返回值，读写为字节数，失败为-1
+ */
+typedef struct _aio_cqe_t{
+    uint32_t user_data;
+    int res;
+}aio_cqe_t;
+
+/**
+ * @brief 用户和内核共享的异步I/O环，占一页
+ * @param sq_head 内核已取走的提交项序号，只由内核修改
+ * @param sq_tail 用户已填写的提交项序号，只由用户修改
+ * @param cq_head 用户已取走的完成项序号，只由用户修改
+ * @param cq_tail 内核已写入的完成项序号，只由内核修改
+ * @param inflight 已提交但未完成的操作数
+ * @param sqes 提交队列，序号对AIO_SQ_ENTRIES取模得到下标
+ * @param cqes 完成队列，序号对AIO_CQ_ENTRIES取模得到下标
+ */
+typedef struct _aio_ring_t{
+    volatile uint32_t sq_head;
+    volatile uint32_t sq_tail;
+    volatile uint32_t cq_head;
+    volatile uint32_t cq_tail;
+    volatile uint32_t inflight;
+    aio_sqe_t sqes[AIO_SQ_ENTRIES];
+    aio_cqe_t cqes[AIO_CQ_ENTRIES];
+}aio_ring_t;
+
+/// @brief futex的操作
+#define FUTEX_WAIT              0
+#define FUTEX_WAKE              1
+
+int thread_create(void (*entry)(void*),void* arg,void* stack_top);
+int thread_join(int tid,int* status);
+int futex(volatile int* addr,int op,int val,int timeout_ms);
+int setprio(int pid,int prio);
+int irqoff_trace(irqoff_info_t* info,int flags);
+int syscall_use_sysenter(int enable);
+int getpid_syscall(void);
+int syscall_ctl(int pid,int flags);
+int syscall_stat(int pid,syscall_stat_t* stat,int reset);
+int syscall_trace(int pid,syscall_trace_t* buf,int count);
+int boot_time(boot_phase_t* buf,int count);
+int prof_ctl(int cmd,int period_ms);
+int prof_read(prof_sample_t* buf,int start,int count,prof_info_t* info);
+int ksym_lookup(uint32_t addr,char* name,int size);
+
+void batch_init(syscall_batch_t* batch);
+int batch_add(syscall_batch_t* batch,int id,int arg0,int arg1,int arg2,int arg3);
+int batch_read(syscall_batch_t* batch,int fd,char* buf,int size);
+int batch_write(syscall_batch_t* batch,int fd,char* buf,int size);
+int batch_lseek(syscall_batch_t* batch,int fd,int offset,int dir);
+int batch_close(syscall_batch_t* batch,int fd);
+int batch_submit(syscall_batch_t* batch,int flags);
+uint32_t get_tick(void);
+
+int get_task_info(task_info_t* info,int count);
+int get_sys_info(sys_info_t* info);
+int sched_lat(int pid,sched_lat_t* lat,int reset);
+
+int clock_gettime(clockid_t clk_id,struct timespec* ts);
+int gettimeofday(struct timeval* tv,void* tz);
+
 DIR *opendir(const char* path);
 struct dirent *readdir(DIR *dir);
 int closedir(DIR *dir);
 
 int ioctl(int file,int cmd,int arg0,int arg1);
 int unlink(const char *path);
+int pipe(int fds[2]);
+int poll(struct pollfd* fds,int nfds,int timeout_ms);
+
+int socket(int domain,int type,int protocol);
+int bind(int fd,const struct sockaddr_un* addr,int len);
+int listen(int fd,int backlog);
+int accept(int fd,struct sockaddr_un* addr,int* len);
+int connect(int fd,const struct sockaddr_un* addr,int len);
+
+aio_ring_t* aio_setup(void);
+int aio_enter(int min_complete);
+aio_sqe_t* aio_get_sqe(aio_ring_t* ring);
+void aio_prep_rw(aio_sqe_t* sqe,int op,int fd,void* buf,uint32_t len,uint32_t offset,uint32_t user_data);
+int aio_peek_cqe(aio_ring_t* ring,aio_cqe_t* cqe);
 #endif
\ No newline at end of file
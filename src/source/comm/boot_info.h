@@ -6,10 +6,19 @@
 /// @brief 定义内存信息的最大个数
 #define BOOT_RAM_REGION_MAX			10		
 
+/// @brief 加载器记录TSC的时间点，依次为进入加载器、检测完内存、进入保护模式、读完内核、加载完内核
+#define BOOT_TSC_LOADER             0
+#define BOOT_TSC_MEMORY             1
+#define BOOT_TSC_PROTECT            2
+#define BOOT_TSC_DISK               3
+#define BOOT_TSC_ELF                4
+#define BOOT_TSC_NR                 5
+
 /**
  * @brief 存储内存信息
  * @param ram_region_cfg 存储内存信息的数组包含start存储起始地址以及size即这块儿内存大小
  * @param ram_region_count 存储内存信息的个数
+ * @param tsc 加载器各阶段结束时的TSC，用于统计启动耗时
  */
 typedef struct _boot_info_t {
     struct {
@@ -17,6 +26,7 @@ typedef struct _boot_info_t {
         uint32_t size;
     }ram_region_cfg[BOOT_RAM_REGION_MAX];
     int ram_region_count;
+    uint64_t tsc[BOOT_TSC_NR];
 }boot_info_t;
 
 #define SECTOR_SIZE 512
@@ -252,4 +252,183 @@ static inline uint32_t read_cr2(void){
     );
     return cr2;
 }
+/**
+ * @brief 读取时间戳计数器
+ * @return 处理器上电以来的时钟周期数
+ */
+static inline uint64_t rdtsc(void){
+    uint32_t low,high;
+    __asm__ __volatile__(
+        "rdtsc"
+        :"=a"(low),"=d"(high)
+    );
+    return ((uint64_t)high << 32) | low;
+}
+
+/**
+ * @brief 查找最高的置位位
+ * @param v 不能为0
+ * @return 最高置位位的序号
+ */
+static inline uint32_t bsr(uint32_t v){
+    uint32_t index;
+    __asm__ __volatile__(
+        "bsr %[v],%[index]"
+        :[index]"=r"(index)
+        :[v]"r"(v)
+    );
+    return index;
+}
+/**
+ * @brief 执行cpuid指令
+ * @param leaf 功能号
+ * @param eax 返回的eax
+ * @param ebx 返回的ebx
+ * @param ecx 返回的ecx
+ * @param edx 返回的edx
+ */
+static inline void cpuid(uint32_t leaf,uint32_t* eax,uint32_t* ebx,uint32_t* ecx,uint32_t* edx){
+    __asm__ __volatile__(
+        "cpuid"
+        :"=a"(*eax),"=b"(*ebx),"=c"(*ecx),"=d"(*edx)
+        :"a"(leaf),"c"(0)
+    );
+}
+
+/**
+ * @brief 读取模型特定寄存器
+ * @param msr 寄存器编号
+ * @return 寄存器的值
+ */
+static inline uint64_t rdmsr(uint32_t msr){
+    uint32_t low,high;
+    __asm__ __volatile__(
+        "rdmsr"
+        :"=a"(low),"=d"(high)
+        :"c"(msr)
+    );
+    return ((uint64_t)high << 32) | low;
+}
+
+/**
+ * @brief 写入模型特定寄存器
+ * @param msr 寄存器编号
+ * @param value 写入的值
+ */
+static inline void wrmsr(uint32_t msr,uint64_t value){
+    __asm__ __volatile__(
+        "wrmsr"
+        :
+        :"c"(msr),"a"((uint32_t)value),"d"((uint32_t)(value >> 32))
+    );
+}
+
+/**
+ * @brief 清除cr0寄存器的TS位
+ */
+static inline void clts(void){
+    __asm__ __volatile__("clts");
+}
+
+/**
+ * @brief 原子地比较并交换，*addr等于old时写入value
+ * @param addr 操作的地址
+ * @param old 期望的旧值
+ * @param value 要写入的新值
+ * @return *addr原来的值，等于old说明交换成功
+ */
+static inline uint32_t atomic_cmpxchg(volatile uint32_t* addr,uint32_t old,uint32_t value){
+    __asm__ __volatile__(
+        "lock cmpxchgl %[value],%[mem]"
+        :"+a"(old),[mem]"+m"(*addr)
+        :[value]"r"(value)
+        :"memory","cc"
+    );
+    return old;
+}
+
+/**
+ * @brief 原子地加上一个值
+ * @param addr 操作的地址
+ * @param value 要加上的值，可以为负数
+ * @return *addr原来的值
+ */
+static inline int atomic_xadd(volatile int* addr,int value){
+    __asm__ __volatile__(
+        "lock xaddl %[value],%[mem]"
+        :[value]"+r"(value),[mem]"+m"(*addr)
+        :
+        :"memory","cc"
+    );
+    return value;
+}
+
+/**
+ * @brief 原子地交换，xchg访问内存时隐含lock
+ * @param addr 操作的地址
+ * @param value 要写入的新值
+ * @return *addr原来的值
+ */
+static inline uint32_t atomic_xchg(volatile uint32_t* addr,uint32_t value){
+    __asm__ __volatile__(
+        "xchgl %[value],%[mem]"
+        :[value]"+r"(value),[mem]"+m"(*addr)
+        :
+        :"memory"
+    );
+    return value;
+}
+
+/**
+ * @brief 在自旋等待的循环中提示处理器
+ */
+static inline void cpu_relax(void){
+    __asm__ __volatile__("pause":::"memory");
+}
+
+/**
+ * @brief 自旋锁，持有期间不能睡眠
+ * @param locked 0空闲，1被持有
+ */
+typedef struct _spinlock_t{
+    volatile uint32_t locked;
+}spinlock_t;
+
+static inline void spin_init(spinlock_t* lock){
+    lock->locked=0;
+}
+
+static inline void spin_lock(spinlock_t* lock){
+    while(atomic_xchg(&lock->locked,1)){
+        while(lock->locked){
+            cpu_relax();
+        }
+    }
+}
+
+static inline int spin_trylock(spinlock_t* lock){
+    return atomic_xchg(&lock->locked,1)==0;
+}
+
+static inline void spin_unlock(spinlock_t* lock){
+    __asm__ __volatile__("":::"memory");
+    lock->locked=0;
+}
+
+/**
+ * @brief 关中断后获取自旋锁，防止中断处理程序在同一cpu上争用
+ * @param lock 自旋锁
+ * @return 原来的eflags，传给spin_unlock_irqrestore
+ */
+static inline uint32_t spin_lock_irqsave(spinlock_t* lock){
+    uint32_t eflags=read_eflags();
+    cli();
+    spin_lock(lock);
+    return eflags;
+}
+
+static inline void spin_unlock_irqrestore(spinlock_t* lock,uint32_t eflags){
+    spin_unlock(lock);
+    write_eflags(eflags);
+}
 #endif
\ No newline at end of file
@@ -19,5 +19,10 @@ typedef unsigned short uint16_t;
 typedef unsigned long uint32_t;
 #endif
 
+#ifndef _UINT64_T_DECLARED
+#define _UINT64_T_DECLARED
+typedef unsigned long long uint64_t;
+#endif
+
 #endif
 
@@ -0,0 +1,121 @@
+#include "core/boottime.h"
+#include "comm/cpu_instr.h"
+#include "dev/clock.h"
+#include "cpu/irq.h"
+#include "core/memory.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+/**
+ * @brief 一个阶段结束时记录的时间点
+ * @param name 阶段名，指向常量字符串
+ * @param tsc 阶段结束时的TSC
+ */
+typedef struct _boot_mark_t{
+    const char* name;
+    uint64_t tsc;
+}boot_mark_t;
+
+/// @brief 加载器各时间点对应的阶段名，第一个阶段为从复位到进入加载器的BIOS阶段
+static const char* const boot_loader_phases[BOOT_TSC_NR]={
+    [BOOT_TSC_LOADER]="bios",
+    [BOOT_TSC_MEMORY]="detect_memory",
+    [BOOT_TSC_PROTECT]="protect_mode",
+    [BOOT_TSC_DISK]="read_kernel",
+    [BOOT_TSC_ELF]="load_elf",
+};
+
+static boot_mark_t boot_marks[BOOT_PHASE_NR];
+static int boot_mark_count;
+
+/// @brief 第一个程序启动后置1，之后不再记录
+static int boot_done;
+
+/**
+ * @brief 记录加载器阶段的时间点，需在进入内核后最先调用
+ * @param boot_info 加载器传递的启动信息
+ * @note 此时还没有校准TSC，只记录周期数，输出报告时再换算
+ */
+void boot_time_init(boot_info_t* boot_info){
+    for(int i=0;i<BOOT_TSC_NR;i++){
+        boot_marks[i].name=boot_loader_phases[i];
+        boot_marks[i].tsc=boot_info->tsc[i];
+    }
+    boot_mark_count=BOOT_TSC_NR;
+}
+
+/**
+ * @brief 记录一个阶段结束的时间点，阶段的耗时为与上一个时间点的差
+ * @param name 阶段名，需为常量字符串
+ */
+void boot_time_mark(const char* name){
+    irq_state_t state=irq_enter_protection();
+    if(!boot_done && (boot_mark_count<BOOT_PHASE_NR)){
+        boot_marks[boot_mark_count].name=name;
+        boot_marks[boot_mark_count].tsc=rdtsc();
+        boot_mark_count++;
+    }
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief 将第i个时间点换算为阶段的结束时间和耗时
+ * @param i 时间点的序号
+ * @param phase 保存结果
+ */
+static void boot_phase_get(int i,boot_phase_t* phase){
+    uint64_t start=(i>0) ? boot_marks[i-1].tsc : 0;
+    uint64_t end=boot_marks[i].tsc;
+
+    kernel_strncpy(phase->name,boot_marks[i].name,BOOT_PHASE_NAME_SIZE);
+    phase->name[BOOT_PHASE_NAME_SIZE-1]='\0';
+    phase->end_us=(uint32_t)div_u64_rem(clock_cycles_to_ns(end),1000,(uint32_t*)0);
+    phase->us=(end>start) ? (uint32_t)div_u64_rem(clock_cycles_to_ns(end-start),1000,(uint32_t*)0) : 0;
+}
+
+/**
+ * @brief 记录最后一个阶段并结束启动计时，输出各阶段的耗时
+ * @param name 最后一个阶段的名称
+ * @note 只有第一次调用有效，由第一个程序的execve调用
+ */
+void boot_time_finish(const char* name){
+    if(boot_done){
+        return;
+    }
+    boot_time_mark(name);
+    boot_done=1;
+
+    boot_phase_t phase;
+    log_printf("boot time:");
+    for(int i=0;i<boot_mark_count;i++){
+        boot_phase_get(i,&phase);
+        log_printf("  %s: %d us, done at %d us",phase.name,phase.us,phase.end_us);
+    }
+}
+
+/**
+ * @brief 获取启动过程各阶段的耗时
+ * @param buf 保存各阶段，可以为0
+ * @param count buf的项数
+ * @return 读取的阶段数，buf为0时返回总的阶段数，启动尚未完成时返回-1
+ */
+int sys_boot_time(boot_phase_t* buf,int count){
+    if(!boot_done){
+        return -1;
+    }
+
+    if((buf==(boot_phase_t*)0) || (count<=0)){
+        return boot_mark_count;
+    }
+
+    if(count>boot_mark_count){
+        count=boot_mark_count;
+    }
+    if(memory_check_user(buf,count*sizeof(boot_phase_t),1)<0){
+        return -1;
+    }
+    for(int i=0;i<count;i++){
+        boot_phase_get(i,buf+i);
+    }
+    return count;
+}
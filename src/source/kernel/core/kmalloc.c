@@ -0,0 +1,103 @@
+#include "core/kmalloc.h"
+#include "core/memory.h"
+#include "cpu/irq.h"
+#include "tools/klib.h"
+
+/// @brief 各个大小的空闲块链表，空闲块的起始处存放链表结点
+static list_t free_lists[KMALLOC_CLASS_NR];
+
+/**
+ * @brief 初始化内核小块内存分配器
+ */
+void kmalloc_init(void){
+    for(int i=0;i<KMALLOC_CLASS_NR;i++){
+        list_init(&free_lists[i]);
+    }
+}
+
+/**
+ * @brief 分配内核内存，内存来自物理页，内核中可以直接访问
+ * @param size 需要分配的字节数
+ * @return 分配的内存地址，失败返回0
+ */
+void* kmalloc(uint32_t size){
+    uint32_t total=size+sizeof(kmalloc_hdr_t);
+
+    // 大块内存直接按页分配
+    if(total>(1<<KMALLOC_MAX_SHIFT)){
+        int pages=up2(total,MEM_PAGE_SIZE)/MEM_PAGE_SIZE;
+        kmalloc_hdr_t* hdr=(kmalloc_hdr_t*)memory_alloc_pages(pages);
+        if(hdr==(kmalloc_hdr_t*)0){
+            return (void*)0;
+        }
+        hdr->order=KMALLOC_ORDER_PAGE;
+        hdr->pages=pages;
+        return hdr+1;
+    }
+
+    int order=KMALLOC_MIN_SHIFT;
+    while((1<<order)<total){
+        order++;
+    }
+    list_t* list=&free_lists[order-KMALLOC_MIN_SHIFT];
+
+    irq_state_t state=irq_enter_protection();
+    list_node_t* node=list_remove_first(list);
+    irq_leave_protection(state);
+
+    if(node==(list_node_t*)0){
+        uint32_t page=memory_alloc_page();
+        if(page==0){
+            return (void*)0;
+        }
+
+        // 第一块留给本次分配，页中其余的块加入空闲链表
+        uint32_t block_size=1<<order;
+        state=irq_enter_protection();
+        for(uint32_t offset=block_size;offset<MEM_PAGE_SIZE;offset+=block_size){
+            list_insert_last(list,(list_node_t*)(page+offset));
+        }
+        irq_leave_protection(state);
+
+        node=(list_node_t*)page;
+    }
+
+    kmalloc_hdr_t* hdr=(kmalloc_hdr_t*)node;
+    hdr->order=order;
+    hdr->pages=0;
+    return hdr+1;
+}
+
+/**
+ * @brief 分配内核内存并清零
+ * @param size 需要分配的字节数
+ * @return 分配的内存地址，失败返回0
+ */
+void* kzalloc(uint32_t size){
+    void* ptr=kmalloc(size);
+    if(ptr){
+        kernel_memset(ptr,0,size);
+    }
+    return ptr;
+}
+
+/**
+ * @brief 释放kmalloc分配的内存，小块内存回到空闲链表中复用
+ * @param ptr kmalloc返回的地址，可以为0
+ */
+void kfree(void* ptr){
+    if(ptr==(void*)0){
+        return;
+    }
+
+    kmalloc_hdr_t* hdr=(kmalloc_hdr_t*)ptr-1;
+    if(hdr->order==KMALLOC_ORDER_PAGE){
+        memory_free_pages((uint32_t)hdr,hdr->pages);
+        return;
+    }
+
+    ASSERT((hdr->order>=KMALLOC_MIN_SHIFT) && (hdr->order<=KMALLOC_MAX_SHIFT));
+    irq_state_t state=irq_enter_protection();
+    list_insert_first(&free_lists[hdr->order-KMALLOC_MIN_SHIFT],(list_node_t*)hdr);
+    irq_leave_protection(state);
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "core/ksym.h"
+#include "core/memory.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+/// @brief 预留的符号表空间，构建时为全0，写入镜像前由objcopy替换为实际内容
+__attribute__((used,section(".ksyms"))) static const uint8_t ksym_area[KSYM_AREA_SIZE]={0};
+
+/// @brief 符号表的有效表项数，表无效时为0
+static uint32_t ksym_count;
+
+/**
+ * @brief 检查镜像中是否带有符号表
+ * @note 直接运行未经处理的kernel.elf时符号表为空，采样结果只显示地址
+ */
+void ksym_init(void){
+    extern uint8_t s_ksyms[],e_ksyms[];
+    ksym_header_t* header=(ksym_header_t*)s_ksyms;
+
+    ksym_count=0;
+    if(header->magic!=KSYM_MAGIC){
+        log_printf("no kernel symbol table.");
+        return;
+    }
+
+    uint32_t max=(uint32_t)(e_ksyms-s_ksyms-sizeof(ksym_header_t))/sizeof(ksym_entry_t);
+    ksym_count=(header->count<max) ? header->count : max;
+    log_printf("kernel symbol table: %d symbols.",ksym_count);
+}
+
+/**
+ * @brief 查找地址所在的内核函数
+ * @param addr 内核代码中的地址
+ * @param name 保存函数名，可以为0
+ * @return 函数的起始地址，不在内核代码中或没有符号表时返回0
+ */
+uint32_t ksym_find(uint32_t addr,const char** name){
+    extern uint8_t s_ksyms[],e_text[];
+    ksym_entry_t* entries=(ksym_entry_t*)(s_ksyms+sizeof(ksym_header_t));
+
+    if((ksym_count==0) || (addr<entries[0].addr) || (addr>=(uint32_t)e_text)){
+        return 0;
+    }
+
+    // 二分查找最后一个起始地址不大于addr的函数
+    uint32_t low=0,high=ksym_count;
+    while(high-low>1){
+        uint32_t mid=(low+high)/2;
+        if(entries[mid].addr<=addr){
+            low=mid;
+        }
+        else{
+            high=mid;
+        }
+    }
+
+    if(name){
+        *name=(const char*)(s_ksyms+entries[low].name);
+    }
+    return entries[low].addr;
+}
+
+/**
+ * @brief 查找地址所在的内核函数，供用户态的分析工具使用
+ * @param addr 内核代码中的地址
+ * @param name 保存函数名，可以为0
+ * @param size name的大小，函数名过长时截断
+ * @return 函数的起始地址，找不到时返回0
+ */
+int sys_ksym_lookup(uint32_t addr,char* name,int size){
+    const char* sym;
+    if((size>0) && (memory_check_user(name,size,1)<0)){
+        return -1;
+    }
+    uint32_t start=ksym_find(addr,&sym);
+    if(start==0){
+        return 0;
+    }
+
+    if(name && (size>0)){
+        kernel_strncpy(name,sym,size);
+        name[size-1]='\0';
+    }
+    return (int)start;
+}
@@ -0,0 +1,126 @@
+#include "core/kthread.h"
+#include "core/memory.h"
+#include "cpu/irq.h"
+#include "tools/log.h"
+#include "tools/klib.h"
+
+/**
+ * @brief 内核线程的公共入口，执行完线程函数后自动退出
+ * @param fn 线程函数
+ * @param arg 线程函数的参数
+ */
+static void kthread_entry(kthread_fn_t fn,void* arg){
+    fn(arg);
+    kthread_exit(0);
+}
+
+/**
+ * @brief 创建一个内核线程并加入就绪队列
+ * @param name 线程名称
+ * @param fn 线程函数
+ * @param arg 线程函数的参数
+ * @return 创建的线程，失败返回0
+ */
+task_t* kthread_create(const char* name,kthread_fn_t fn,void* arg){
+    task_t* task=alloc_task();
+    if(task==(task_t*)0){
+        log_printf("no free task for kthread %s.",name);
+        return (task_t*)0;
+    }
+
+    int err=task_init(task,name,TASK_FLAGS_SYSTEM | TASK_FLAGS_KTHREAD,(uint32_t)kthread_entry,0);
+    if(err<0){
+        goto kthread_create_failed;
+    }
+
+    // 内核线程只使用内核栈，在栈顶构造kthread_entry(fn,arg)的调用现场
+    uint32_t* stack=(uint32_t*)task->tss.esp0;
+    *(--stack)=(uint32_t)arg;
+    *(--stack)=(uint32_t)fn;
+    *(--stack)=0;
+    task->tss.esp=(uint32_t)stack;
+
+    task_start(task);
+    return task;
+
+kthread_create_failed:
+    task_uninit(task);
+    free_task(task);
+    return (task_t*)0;
+}
+
+/**
+ * @brief 判断当前内核线程是否被要求退出，线程函数应在循环中检查
+ * @return 1 需要退出，0 继续运行
+ */
+int kthread_should_stop(void){
+    return task_current()->should_stop;
+}
+
+/**
+ * @brief 结束当前内核线程
+ *        若有任务在kthread_stop中等待则由其回收，否则交给first_task回收
+ * @param status 退出状态码
+ */
+void kthread_exit(int status){
+    task_t* curr=task_current();
+
+    irq_state_t state=irq_enter_protection();
+
+    if(!curr->should_stop){
+        task_set_parent(curr,task_first_task());
+    }
+
+    task_t* parent=curr->parent;
+    if(parent->state==TASK_WAITING){
+        task_set_ready(parent);
+    }
+
+    curr->status=status;
+    curr->state=TASK_ZOMBIE;
+    task_set_block(curr);
+
+    task_dispatch();
+
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief 要求内核线程退出，并等待其结束后回收资源
+ *        只能用于在循环中检查kthread_should_stop()的线程
+ * @param task 需要停止的内核线程
+ * @return 线程的退出状态码
+ */
+int kthread_stop(task_t* task){
+    ASSERT(task->flags & TASK_FLAGS_KTHREAD);
+    task_t* curr=task_current();
+
+    irq_state_t state=irq_enter_protection();
+
+    // 从原父进程的子进程链表中移除，避免其wait同时回收该线程
+    // 也不加入当前任务的子进程链表，线程结束后直接在这里回收
+    task->should_stop=1;
+    if(task->parent){
+        list_remove(&task->parent->child_list,&task->child_node);
+    }
+    task->parent=curr;
+
+    // 正在睡眠的线程需要提前唤醒，使其能够看到退出请求
+    if(task->state==TASK_SLEEP){
+        task_set_wakeup(task);
+        task_set_ready(task);
+    }
+
+    while(task->state!=TASK_ZOMBIE){
+        task_set_block(curr);
+        curr->state=TASK_WAITING;
+        task_dispatch();
+    }
+
+    irq_leave_protection(state);
+
+    int status=task->status;
+    task_uninit(task);
+    free_task(task);
+    return status;
+}
@@ -2,6 +2,9 @@
 #include "tools/log.h"
 #include "cpu/mmu.h"
 #include "dev/console.h"
+#include "core/kmalloc.h"
+#include "core/vdso.h"
+#include "fs/aio.h"
 
 /// @brief 物理页分配器
 static addr_alloc_t paddr_alloc;
@@ -120,6 +123,40 @@ void memory_init(boot_info_t* boot_info){
    mmu_set_page_dir((uint32_t)kernel_page_dir);
 }
 
+/**
+ * @brief 将一段物理地址映射到内核的MMIO区域，禁用缓存，映射后不再解除
+ * @param paddr 物理地址，可以不按页对齐
+ * @param size 映射的字节数
+ * @return 对应的虚拟地址，区域已满时返回0
+ * @note 各任务的页目录创建时复制内核的页目录项，因此首次映射需在创建第一个任务之前完成
+ */
+void* memory_map_mmio(uint32_t paddr,uint32_t size){
+    static uint32_t mmio_next=MEM_MMIO_START;
+
+    uint32_t pstart=down2(paddr,MEM_PAGE_SIZE);
+    uint32_t pend=up2(paddr+size,MEM_PAGE_SIZE);
+    int page_count=(pend-pstart)/MEM_PAGE_SIZE;
+    if(mmio_next+page_count*MEM_PAGE_SIZE>MEM_MMIO_END){
+        log_printf("mmio area full, map 0x%x failed.",paddr);
+        return (void*)0;
+    }
+
+    uint32_t vaddr=mmio_next;
+    if(memory_create_map(kernel_page_dir,vaddr,pstart,page_count,PTE_W | PTE_PCD | PTE_PWT)<0){
+        return (void*)0;
+    }
+    mmio_next+=page_count*MEM_PAGE_SIZE;
+    return (void*)(vaddr+(paddr-pstart));
+}
+
+/**
+ * @brief 获取内核页表的地址
+ * @return 内核页表的物理地址，内核线程直接使用该页表
+ */
+uint32_t memory_kernel_page_dir(void){
+    return (uint32_t)kernel_page_dir;
+}
+
 uint32_t memory_create_uvm(void){
     pde_t* page_dir=(pde_t*)addr_alloc_page(&paddr_alloc,1);
     if(page_dir==0){
@@ -131,6 +168,13 @@ uint32_t memory_create_uvm(void){
         page_dir[i].v=kernel_page_dir[i].v;
     }
 
+    // 所有地址空间共享同一个只读的vdso页
+    uint32_t vdso=vdso_paddr();
+    if(vdso && memory_create_map(page_dir,VDSO_ADDR,vdso,1,PTE_U)<0){
+        memory_destroy_uvm((uint32_t)page_dir);
+        return 0;
+    }
+
     return (uint32_t)page_dir;
 }
 
@@ -164,6 +208,24 @@ uint32_t memory_alloc_page(void){
     return addr;
 }
 
+/**
+ * @brief 分配连续的多个内核物理页
+ * @param page_count 页的数量
+ * @return 起始物理地址，失败返回0
+ */
+uint32_t memory_alloc_pages(int page_count){
+    return addr_alloc_page(&paddr_alloc,page_count);
+}
+
+/**
+ * @brief 释放memory_alloc_pages分配的连续物理页
+ * @param addr 起始物理地址
+ * @param page_count 页的数量
+ */
+void memory_free_pages(uint32_t addr,int page_count){
+    addr_free_page(&paddr_alloc,addr,page_count);
+}
+
 static pde_t* curr_page_dir(void){
     return (pde_t*)(task_current()->tss.cr3);
 }
@@ -191,7 +253,8 @@ void memory_destroy_uvm(uint32_t page_dir){
 
         pte_t* pte=(pte_t*)pde_paddr(pde);
         for(int j=0;j<PTE_CNT;j++,pte++){
-            if(!pte->present){
+            // vdso页为所有地址空间共享，不能释放
+            if(!pte->present || ((i<<22) | (j<<12))==VDSO_ADDR){
                 continue;
             }
 
@@ -220,7 +283,9 @@ uint32_t memory_copy_uvm(uint32_t page_dir){
 
         pte_t*pte=(pte_t*)pde_paddr(pde);
         for(int j=0;j<PTE_CNT;j++,pte++){
-            if(!pte->present){
+            // vdso页已在memory_create_uvm中映射，异步I/O环属于父进程，子进程需要重新创建
+            uint32_t vaddr=(i<<22) | (j<<12);
+            if(!pte->present || vaddr==VDSO_ADDR || vaddr==AIO_RING_ADDR){
                 continue;
             }
 
@@ -228,7 +293,6 @@ uint32_t memory_copy_uvm(uint32_t page_dir){
             if(page==0) {
                 goto copy_uvm_failed;
             }
-            uint32_t vaddr=(i<<22) | (j<<12);
             int err=memory_create_map((pde_t*)to_page_dir,vaddr,page,1,get_pte_perm(pte));
             if(err < 0){
                 goto copy_uvm_failed;
@@ -243,24 +307,119 @@ copy_uvm_failed:
     if(to_page_dir){
         memory_destroy_uvm(to_page_dir);
     }
-    return -1;
+    return 0;
+}
+
+/**
+ * @brief 创建一个地址空间描述结构
+ * @param page_dir 地址空间使用的页目录表，创建成功后由mm_t负责销毁
+ * @return 成功返回mm_t指针，失败返回0
+ */
+mm_t* mm_create(uint32_t page_dir){
+    mm_t* mm=(mm_t*)kzalloc(sizeof(mm_t));
+    if(mm==(mm_t*)0){
+        return (mm_t*)0;
+    }
+
+    mm->page_dir=page_dir;
+    mm->ref=1;
+    mutex_init(&mm->mutex);
+    return mm;
+}
+
+/**
+ * @brief 增加地址空间的引用计数，创建线程时使用
+ * @param mm 地址空间
+ * @return 传入的mm
+ */
+mm_t* mm_get(mm_t* mm){
+    irq_state_t state=irq_enter_protection();
+    mm->ref++;
+    irq_leave_protection(state);
+    return mm;
+}
+
+/**
+ * @brief 减少地址空间的引用计数，最后一个使用者退出时销毁页表
+ * @param mm 地址空间
+ */
+void mm_put(mm_t* mm){
+    irq_state_t state=irq_enter_protection();
+    int ref=--mm->ref;
+    irq_leave_protection(state);
+
+    if(ref==0){
+        if(mm->aio){
+            aio_ctx_free(mm->aio);
+        }
+        memory_destroy_uvm(mm->page_dir);
+        kfree(mm);
+    }
 }
 
 /**
  * @brief 获取页表项对应的物理地址
  * @param page_dir 获取该页物理地址所使用的页表
  * @param vaddr 虚拟地址
- * @return 成功返回物理地址，失败返回0
+ * @return 成功返回物理地址，页表或页不存在时返回0
 */
 uint32_t memory_get_paddr(uint32_t page_dir,uint32_t vaddr){
     pte_t* pte=find_pte((pde_t*)page_dir,vaddr,0);
-    if(!pte){
+    if(!pte || !pte->present){
+        return 0;
+    }
+
+    return pte_paddr(pte) + (vaddr & (MEM_PAGE_SIZE-1));
+}
+
+/**
+ * @brief 获取用户缓冲区对应的物理地址，并按用户态的权限检查
+ * @param page_dir 用户地址空间的页表
+ * @param vaddr 用户地址
+ * @param write 为1时要求该页可写，即内核将代替用户写入该页
+ * @return 成功返回物理地址，页不存在、不允许用户访问或不可写时返回0
+ * @note 内核通过物理地址直接访问时不经过页表的权限检查，代替用户访问前需先调用
+ */
+uint32_t memory_get_user_paddr(uint32_t page_dir,uint32_t vaddr,int write){
+    pte_t* pte=find_pte((pde_t*)page_dir,vaddr,0);
+    if(!pte || !pte->present || !pte->user_mode_acc){
+        return 0;
+    }
+    if(write && !pte->write_enable){
         return 0;
     }
 
     return pte_paddr(pte) + (vaddr & (MEM_PAGE_SIZE-1));
 }
 
+/**
+ * @brief 检查系统调用中内核代替当前任务读写的用户缓冲区
+ * @param addr 缓冲区地址，低于MEMORY_TASK_BASE的是内核自己传入的缓冲区，不做检查
+ * @param size 字节数
+ * @param write 为1时要求各页用户可写
+ * @return 可以访问返回0，否则返回-1
+ * @note 未设置CR0.WP，内核写入只读的用户页不会产生异常，写入前必须先检查
+ */
+int memory_check_user(const void* addr,uint32_t size,int write){
+    uint32_t vaddr=(uint32_t)addr;
+    if((vaddr<MEMORY_TASK_BASE) || (size==0)){
+        return 0;
+    }
+    if(vaddr+size<vaddr){
+        return -1;
+    }
+
+    uint32_t page_dir=read_cr3();
+    uint32_t start=down2(vaddr,MEM_PAGE_SIZE);
+    uint32_t pages=((vaddr-start)+size+MEM_PAGE_SIZE-1)/MEM_PAGE_SIZE;
+    for(uint32_t i=0;i<pages;i++){
+        if(memory_get_user_paddr(page_dir,start+i*MEM_PAGE_SIZE,write)==0){
+            return -1;
+        }
+    }
+    return 0;
+}
+
 int memory_copy_uvm_data(uint32_t to,uint32_t page_dir,uint32_t from,uint32_t size){
     while(size > 0){
         uint32_t to_paddr=memory_get_paddr(page_dir,to);
@@ -283,25 +442,29 @@ int memory_copy_uvm_data(uint32_t to,uint32_t page_dir,uint32_t from,uint32_t si
 }
 
 char* sys_sbrk(int incr){
-    task_t* task=task_current();
-    uint8_t*pre_heap_end=(uint8_t*) task->heap_end;
+    mm_t* mm=task_current()->mm;
 
     ASSERT(incr>=0);
 
+    mutex_lock(&mm->mutex);
+    uint8_t*pre_heap_end=(uint8_t*) mm->heap_end;
+
     int pre_incr=incr;
 
     if(incr==0){
         log_printf("sbrk(0): end=0x%x",pre_heap_end);
+        mutex_unlock(&mm->mutex);
         return pre_heap_end;
     }
 
-    uint32_t start=task->heap_end;
+    uint32_t start=mm->heap_end;
     uint32_t end=start+incr;
 
     int start_offset=start % MEM_PAGE_SIZE;
     if(start_offset){
         if(start_offset+incr <= MEM_PAGE_SIZE){
-            task->heap_end=end;
+            mm->heap_end=end;
+            mutex_unlock(&mm->mutex);
             return pre_heap_end;
         }
         else{
@@ -316,10 +479,12 @@ char* sys_sbrk(int incr){
         int err=memory_alloc_page_for(start,curr_size,PTE_P | PTE_U | PTE_W);
         if(err<0){
             log_printf("sbrk: alloc mem failed.");
+            mutex_unlock(&mm->mutex);
             return (char*)-1;
         }
     }
 
-    task->heap_end=end;
+    mm->heap_end=end;
+    mutex_unlock(&mm->mutex);
     return (char*)pre_heap_end;
 }
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "core/pid.h"
+#include "core/task.h"
+#include "tools/bitmap.h"
+#include "cpu/irq.h"
+
+/// @brief pid位图，置位表示已被占用
+static uint8_t pid_bits[PID_MAX/8];
+static bitmap_t pid_bitmap;
+
+/// @brief 上一次分配的pid，下次从其后开始查找，避免pid被立即复用
+static int last_pid;
+
+/// @brief pid到任务的哈希表，任务通过pid_node挂在对应的桶中
+static list_t pid_hash[PID_HASH_SIZE];
+
+/// @brief 计算pid所在的哈希桶
+#define pid_hashfn(pid)     ((pid) & (PID_HASH_SIZE-1))
+
+/**
+ * @brief 初始化pid位图和哈希表
+ */
+void pid_init(void){
+    bitmap_init(&pid_bitmap,pid_bits,PID_MAX,0);
+
+    // pid 0不参与分配
+    bitmap_set_bit(&pid_bitmap,0,1,1);
+    last_pid=0;
+
+    for(int i=0;i<PID_HASH_SIZE;i++){
+        list_init(&pid_hash[i]);
+    }
+}
+
+/**
+ * @brief 分配一个未被占用的pid，从上次分配的位置往后循环查找
+ * @return 分配的pid，失败返回-1
+ */
+int pid_alloc(void){
+    int pid=-1;
+
+    irq_state_t state=irq_enter_protection();
+    int curr=last_pid;
+    for(int i=1;i<PID_MAX;i++){
+        if(++curr>=PID_MAX){
+            curr=1;
+        }
+
+        if(!bitmap_is_set(&pid_bitmap,curr)){
+            bitmap_set_bit(&pid_bitmap,curr,1,1);
+            last_pid=pid=curr;
+            break;
+        }
+    }
+    irq_leave_protection(state);
+
+    return pid;
+}
+
+/**
+ * @brief 释放pid
+ * @param pid 需要释放的pid
+ */
+void pid_free(int pid){
+    if((pid<=0) || (pid>=PID_MAX)){
+        return;
+    }
+
+    irq_state_t state=irq_enter_protection();
+    bitmap_set_bit(&pid_bitmap,pid,1,0);
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief 将任务加入pid哈希表
+ * @param task 已分配pid的任务
+ */
+void pid_hash_insert(task_t* task){
+    irq_state_t state=irq_enter_protection();
+    list_insert_last(&pid_hash[pid_hashfn(task->pid)],&task->pid_node);
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief 将任务从pid哈希表中移除
+ * @param task 需要移除的任务
+ */
+void pid_hash_remove(task_t* task){
+    irq_state_t state=irq_enter_protection();
+    list_remove(&pid_hash[pid_hashfn(task->pid)],&task->pid_node);
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief 根据pid查找任务
+ * @param pid 任务的pid
+ * @return 对应的任务，不存在返回0
+ */
+task_t* pid_find_task(int pid){
+    if((pid<=0) || (pid>=PID_MAX)){
+        return (task_t*)0;
+    }
+
+    task_t* task=(task_t*)0;
+
+    irq_state_t state=irq_enter_protection();
+    list_node_t* node=list_first(&pid_hash[pid_hashfn(pid)]);
+    while(node){
+        task_t* curr=list_node_parent(node,task_t,pid_node);
+        if(curr->pid==pid){
+            task=curr;
+            break;
+        }
+        node=list_node_next(node);
+    }
+    irq_leave_protection(state);
+
+    return task;
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "core/profile.h"
+#include "core/task.h"
+#include "core/memory.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+#include "os_cfg.h"
+
+/// @brief 采样缓冲区占用的页数
+#define PROF_PAGES      ((PROF_SAMPLE_NR*sizeof(prof_sample_t)+MEM_PAGE_SIZE-1)/MEM_PAGE_SIZE)
+
+/**
+ * @brief 采样的状态，只有一个CPU，整个系统共用一个采样缓冲区
+ * @param samples 采样缓冲区，第一次开始采样时分配，之后不再释放
+ * @param running 是否正在采样
+ * @param period 每隔多少个tick采样一次
+ * @param countdown 距离下一次采样的tick数
+ * @param nr 已记录的采样数
+ * @param lost 缓冲区满后丢弃的采样数
+ */
+static struct{
+    prof_sample_t* samples;
+    int running;
+    int period;
+    int countdown;
+    uint32_t nr;
+    uint32_t lost;
+}prof;
+
+/**
+ * @brief 在定时器中断中记录被中断的位置
+ * @param frame 定时器中断保存的现场
+ * @note 在关中断的中断处理函数中调用
+ */
+void prof_tick(exception_frame_t* frame){
+    if(!prof.running || (--prof.countdown>0)){
+        return;
+    }
+    prof.countdown=prof.period;
+
+    if(prof.nr>=PROF_SAMPLE_NR){
+        prof.lost++;
+        return;
+    }
+
+    prof_sample_t* sample=prof.samples+prof.nr++;
+    sample->eip=frame->eip;
+    sample->pid=task_current()->pid;
+    sample->cpl=frame->cs & 0x3;
+}
+
+/**
+ * @brief 开始或停止采样
+ * @param cmd PROF_CMD_START开始采样，清除之前的采样；PROF_CMD_STOP停止采样，保留已有的采样
+ * @param period_ms 开始采样时的采样间隔，向上取整到OS_TICK_MS的倍数
+ * @return 成功返回0，失败返回-1
+ */
+int sys_prof_ctl(int cmd,int period_ms){
+    int period=(period_ms+OS_TICK_MS-1)/OS_TICK_MS;
+    switch(cmd){
+        case PROF_CMD_START:
+            if(period<=0){
+                return -1;
+            }
+
+            if(prof.samples==(prof_sample_t*)0){
+                prof.samples=(prof_sample_t*)memory_alloc_pages(PROF_PAGES);
+                if(prof.samples==(prof_sample_t*)0){
+                    log_printf("alloc profile buffer failed.");
+                    return -1;
+                }
+            }
+
+            irq_state_t state=irq_enter_protection();
+            prof.period=period;
+            prof.countdown=period;
+            prof.nr=0;
+            prof.lost=0;
+            prof.running=1;
+            irq_leave_protection(state);
+            return 0;
+        case PROF_CMD_STOP:
+            prof.running=0;
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+/**
+ * @brief 读取采样结果，不会清除缓冲区
+ * @param buf 保存采样，可以为0
+ * @param start 从第几个采样开始读取
+ * @param count buf的项数
+ * @param info 保存采样状态，可以为0
+ * @return 读取的采样数，失败返回-1
+ * @note 采样只追加不修改，采样过程中也可以读取已记录的部分
+ */
+int sys_prof_read(prof_sample_t* buf,int start,int count,prof_info_t* info){
+    if((start<0) || (count<0)){
+        return -1;
+    }
+    if((memory_check_user(buf,count*sizeof(prof_sample_t),1)<0) || (memory_check_user(info,sizeof(prof_info_t),1)<0)){
+        return -1;
+    }
+
+    irq_state_t state=irq_enter_protection();
+    uint32_t nr=prof.nr;
+    if(info){
+        info->running=prof.running;
+        info->period_ms=prof.period*OS_TICK_MS;
+        info->nr=prof.nr;
+        info->lost=prof.lost;
+    }
+    irq_leave_protection(state);
+
+    if((buf==(prof_sample_t*)0) || (start>=nr)){
+        return 0;
+    }
+
+    if(count>nr-start){
+        count=nr-start;
+    }
+    kernel_memcpy(buf,prof.samples+start,count*sizeof(prof_sample_t));
+    return count;
+}
@@ -0,0 +1,198 @@
+#include "core/softirq.h"
+#include "core/task.h"
+#include "core/kthread.h"
+#include "cpu/irq.h"
+#include "ipc/sem.h"
+#include "tools/log.h"
+
+/// @brief 等待处理的软中断位图
+static volatile uint32_t softirq_pending;
+
+/// @brief 各软中断的处理函数
+static softirq_fn_t softirq_table[SOFTIRQ_NR];
+
+/// @brief 硬件中断的嵌套层数
+static volatile int hardirq_count;
+
+/// @brief 正在处理软中断，此期间不进行任务切换
+static volatile int softirq_active;
+
+/// @brief 等待执行的tasklet
+static list_t tasklet_list;
+
+/// @brief ksoftirqd等待在此信号量上
+static sem_t ksoftirqd_sem;
+static task_t* ksoftirqd_task;
+
+/**
+ * @brief 注册软中断的处理函数
+ * @param nr 软中断编号SOFTIRQ_xxx
+ * @param func 处理函数
+ */
+void softirq_register(int nr,softirq_fn_t func){
+    softirq_table[nr]=func;
+}
+
+/**
+ * @brief 标记软中断待处理，可以在中断处理函数中调用
+ * @param nr 软中断编号SOFTIRQ_xxx
+ */
+void softirq_raise(int nr){
+    irq_state_t state=irq_enter_protection();
+    softirq_pending|=1<<nr;
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief 判断当前是否处于中断或软中断上下文，此时不能进行任务切换
+ * @return 1 处于中断上下文，0 处于任务上下文
+ */
+int in_interrupt(void){
+    return hardirq_count || softirq_active;
+}
+
+/**
+ * @brief 处理所有待处理的软中断
+ * @return 1 处理完毕，0 软中断持续产生，剩余部分需交给ksoftirqd
+ * @note 调用和返回时均为关中断，处理函数在开中断下执行
+ */
+static int do_softirq(void){
+    int restart=SOFTIRQ_MAX_RESTART;
+
+    softirq_active=1;
+    while(softirq_pending && restart--){
+        uint32_t pending=softirq_pending;
+        softirq_pending=0;
+
+        irq_enable_global();
+        for(int nr=0;nr<SOFTIRQ_NR;nr++){
+            if((pending & (1<<nr)) && softirq_table[nr]){
+                softirq_table[nr]();
+            }
+        }
+        irq_disable_global();
+    }
+    softirq_active=0;
+
+    return softirq_pending==0;
+}
+
+/**
+ * @brief 硬件中断入口，由中断处理的汇编代码调用
+ */
+void irq_enter(void){
+    hardirq_count++;
+
+    // 中断门已关中断，从入口开始统计，中断处理和其中的临界区都计入这一区间
+    irqoff_trace_begin((uint32_t)__builtin_return_address(0));
+}
+
+/**
+ * @brief 硬件中断出口，由中断处理的汇编代码调用
+ *        在最外层中断返回前处理软中断，并执行中断期间推迟的任务切换
+ */
+void irq_exit(void){
+    if(!--hardirq_count && !softirq_active){
+        if(softirq_pending && !do_softirq() && ksoftirqd_task){
+            sem_notify(&ksoftirqd_sem);
+        }
+        task_resched();
+    }
+
+    // 中断返回时恢复被中断处的开中断状态
+    irqoff_trace_end((uint32_t)__builtin_return_address(0));
+}
+
+/**
+ * @brief 软中断处理线程，负责中断退出时未处理完的软中断
+ * @param arg 未使用
+ */
+static void ksoftirqd_entry(void* arg){
+    for(;;){
+        sem_wait(&ksoftirqd_sem);
+
+        // do_softirq要求调用时关中断
+        irq_disable_global();
+        int done=do_softirq();
+        irq_enable_global();
+
+        // 仍有软中断未处理时先让出CPU，稍后继续
+        if(!done){
+            sem_notify(&ksoftirqd_sem);
+        }
+        task_resched();
+    }
+}
+
+/**
+ * @brief 初始化tasklet
+ * @param tasklet tasklet
+ * @param func 处理函数
+ */
+void tasklet_init(tasklet_t* tasklet,tasklet_fn_t func){
+    list_node_init(&tasklet->node);
+    tasklet->func=func;
+    tasklet->state=0;
+}
+
+/**
+ * @brief 将tasklet加入队列并触发软中断，可以在中断处理函数中调用
+ * @param tasklet tasklet
+ * @return 1 已加入，0 tasklet已在队列中
+ */
+int tasklet_schedule(tasklet_t* tasklet){
+    irq_state_t state=irq_enter_protection();
+    if(tasklet->state & TASKLET_STATE_SCHED){
+        irq_leave_protection(state);
+        return 0;
+    }
+    tasklet->state|=TASKLET_STATE_SCHED;
+    list_insert_last(&tasklet_list,&tasklet->node);
+    softirq_pending|=1<<SOFTIRQ_TASKLET;
+    irq_leave_protection(state);
+    return 1;
+}
+
+/**
+ * @brief tasklet软中断的处理函数，依次执行队列中的tasklet
+ *        执行前清除SCHED标志，处理过程中可以再次调度自身
+ */
+static void tasklet_action(void){
+    irq_state_t state=irq_enter_protection();
+    list_t list=tasklet_list;
+    list_init(&tasklet_list);
+    irq_leave_protection(state);
+
+    list_node_t* node;
+    while((node=list_remove_first(&list))!=(list_node_t*)0){
+        tasklet_t* tasklet=list_node_parent(node,tasklet_t,node);
+
+        state=irq_enter_protection();
+        tasklet->state&=~TASKLET_STATE_SCHED;
+        irq_leave_protection(state);
+
+        tasklet->func(tasklet);
+    }
+}
+
+/**
+ * @brief 初始化软中断，需要在各驱动注册软中断和tasklet之前调用
+ */
+void softirq_init(void){
+    softirq_pending=0;
+    hardirq_count=0;
+    softirq_active=0;
+    list_init(&tasklet_list);
+    softirq_register(SOFTIRQ_TASKLET,tasklet_action);
+}
+
+/**
+ * @brief 创建ksoftirqd内核线程
+ */
+void ksoftirqd_init(void){
+    sem_init(&ksoftirqd_sem,0);
+    ksoftirqd_task=kthread_create("ksoftirqd",ksoftirqd_entry,(void*)0);
+    if(ksoftirqd_task==(task_t*)0){
+        log_printf("create ksoftirqd failed.");
+    }
+}
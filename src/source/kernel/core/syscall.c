@@ -2,17 +2,64 @@
 #include "core/task.h"
 #include "fs/fs.h"
 #include "core/memory.h"
+#include "dev/clock.h"
+#include "ipc/futex.h"
+#include "cpu/irq.h"
+#include "core/kmalloc.h"
+#include "core/pid.h"
+#include "tools/klib.h"
+#include "fs/aio.h"
+#include "fs/socket.h"
+#include "core/profile.h"
+#include "core/ksym.h"
+#include "core/boottime.h"
 
 /// @brief 系统调用的函数指针，统一以这种方式定义
 typedef int (*syscall_handler_t)(uint32_t arg0,uint32_t arg1,uint32_t arg2,uint32_t arg3);
 
+/**
+ * @brief 单个系统调用的内部统计，耗时以时钟周期记录，读取时再换算
+ */
+typedef struct _syscall_counter_t{
+    uint32_t count;
+    uint32_t errors;
+    uint64_t total;
+    uint64_t max;
+    uint32_t hist[SYSCALL_HIST_NR];
+}syscall_counter_t;
+
+/**
+ * @brief 任务的系统调用统计和跟踪记录
+ * @param flags SYSCALL_TRACK_xxx
+ * @param counters 按调用号的统计
+ * @param trace 跟踪记录的环形缓冲区
+ * @param head 下一条要读取的记录的序号
+ * @param tail 下一条要写入的记录的序号
+ */
+typedef struct _syscall_track_t{
+    int flags;
+    syscall_counter_t counters[SYSCALL_STAT_NR];
+    syscall_trace_t trace[SYSCALL_TRACE_NR];
+    uint32_t head;
+    uint32_t tail;
+}syscall_track_t;
+
+/// @brief 系统范围的统计
+static syscall_counter_t* syscall_counters;
+
 
 void sys_print_msg(char* fmt,int arg){
     log_printf(fmt,arg);
 }
 
+int sys_batch(syscall_args_t* calls,int* results,int count,int flags);
+int sys_syscall_ctl(int pid,int flags);
+int sys_syscall_stat(int pid,syscall_stat_t* stat,int reset);
+int sys_syscall_trace(int pid,syscall_trace_t* buf,int count);
+static void syscall_account(task_t* task,syscall_args_t* args,int ret,uint64_t cycles);
+
 /// @brief 系统调用函数表，函数号和函数指针的映射关系
-static const syscall_handler_t sys_table[]={
+static const syscall_handler_t sys_table[SYSCALL_STAT_NR]={
     [SYS_SLEEP]=(syscall_handler_t)sys_msleep,
     [SYS_GETPID]=(syscall_handler_t)sys_getpid,
     [SYS_FORK]=(syscall_handler_t)sys_fork,
@@ -29,24 +76,314 @@ static const syscall_handler_t sys_table[]={
     [SYS_DUP]=(syscall_handler_t)sys_dup,
     [SYS_EXIT]=(syscall_handler_t)sys_exit,
     [SYS_WAIT]=(syscall_handler_t)sys_wait,
+    [SYS_WAITPID]=(syscall_handler_t)sys_waitpid,
+    [SYS_TASK_INFO]=(syscall_handler_t)sys_get_task_info,
+    [SYS_SYS_INFO]=(syscall_handler_t)sys_get_sys_info,
+    [SYS_SCHED_LAT]=(syscall_handler_t)sys_sched_lat,
+    [SYS_CLOCK_GETTIME]=(syscall_handler_t)sys_clock_gettime,
+    [SYS_GETTIMEOFDAY]=(syscall_handler_t)sys_gettimeofday,
+    [SYS_THREAD_CREATE]=(syscall_handler_t)sys_thread_create,
+    [SYS_THREAD_JOIN]=(syscall_handler_t)sys_thread_join,
+    [SYS_FUTEX]=(syscall_handler_t)sys_futex,
+    [SYS_SETPRIO]=(syscall_handler_t)sys_setprio,
+    [SYS_IRQOFF_TRACE]=(syscall_handler_t)sys_irqoff_trace,
+    [SYS_BATCH]=(syscall_handler_t)sys_batch,
+    [SYS_SYSCALL_CTL]=(syscall_handler_t)sys_syscall_ctl,
+    [SYS_SYSCALL_STAT]=(syscall_handler_t)sys_syscall_stat,
+    [SYS_SYSCALL_TRACE]=(syscall_handler_t)sys_syscall_trace,
+    [SYS_PROF_CTL]=(syscall_handler_t)sys_prof_ctl,
+    [SYS_PROF_READ]=(syscall_handler_t)sys_prof_read,
+    [SYS_KSYM_LOOKUP]=(syscall_handler_t)sys_ksym_lookup,
+    [SYS_BOOT_TIME]=(syscall_handler_t)sys_boot_time,
 
     [SYS_OPENDIR]=(syscall_handler_t)sys_opendir,
     [SYS_READDIR]=(syscall_handler_t)sys_readdir,
     [SYS_CLOSEDIR]=(syscall_handler_t)sys_closedir,
     [SYS_IOCTL]=(syscall_handler_t)sys_ioctl,
     [SYS_UNLINK]=(syscall_handler_t)sys_unlink,
+    [SYS_PIPE]=(syscall_handler_t)sys_pipe,
+    [SYS_POLL]=(syscall_handler_t)sys_poll,
+    [SYS_AIO_SETUP]=(syscall_handler_t)sys_aio_setup,
+    [SYS_AIO_ENTER]=(syscall_handler_t)sys_aio_enter,
+    [SYS_SOCKET]=(syscall_handler_t)sys_socket,
+    [SYS_BIND]=(syscall_handler_t)sys_bind,
+    [SYS_LISTEN]=(syscall_handler_t)sys_listen,
+    [SYS_ACCEPT]=(syscall_handler_t)sys_accept,
+    [SYS_CONNECT]=(syscall_handler_t)sys_connect,
     [SYS_PRINT_MSG]=(syscall_handler_t)sys_print_msg,
 };
 
 
-void do_handler_syscall(syscall_frame_t*frame){
-    if(frame->func_id < sizeof(sys_table)/sizeof(sys_table[0])){
-        syscall_handler_t handler=sys_table[frame->func_id];
-        if(handler){
-            int ret=handler(frame->arg0,frame->arg1,frame->arg2,frame->arg3);
-            frame->eax=ret;
-            return;
+/**
+ * @brief 查找系统调用的处理函数
+ * @param id 系统调用号
+ * @return 处理函数，不存在返回0
+ */
+static syscall_handler_t syscall_lookup(uint32_t id){
+    if(id < sizeof(sys_table)/sizeof(sys_table[0])){
+        return sys_table[id];
+    }
+    return (syscall_handler_t)0;
+}
+
+/**
+ * @brief 在一次进入内核中依次执行多个系统调用
+ *        fork和execve依赖调用现场，不能放在批量调用中，批量调用也不能嵌套
+ * @param calls 系统调用参数数组
+ * @param results 各项的返回值，可以为0
+ * @param count 数量，不超过SYSCALL_BATCH_MAX
+ * @param flags BATCH_STOP_ON_ERROR：某项返回负数时停止执行后续各项
+ * @return 实际执行的项数，参数错误返回-1
+ * @note 各项和单独调用一样计入统计和跟踪记录，其耗时同时包含在batch自身的统计中
+ */
+int sys_batch(syscall_args_t* calls,int* results,int count,int flags){
+    if(calls==(syscall_args_t*)0 || count<0 || count>SYSCALL_BATCH_MAX){
+        return -1;
+    }
+    if(memory_check_user(calls,count*sizeof(syscall_args_t),0)<0 || memory_check_user(results,count*sizeof(int),1)<0){
+        return -1;
+    }
+
+    task_t* task=task_current();
+    for(int i=0;i<count;i++){
+        syscall_args_t* args=calls+i;
+        syscall_handler_t handler=syscall_lookup(args->id);
+
+        int ret=-1;
+        if(handler && args->id!=SYS_BATCH && args->id!=SYS_FORK && args->id!=SYS_EXECVE){
+            uint64_t start=rdtsc();
+            ret=handler(args->arg0,args->arg1,args->arg2,args->arg3);
+            syscall_account(task,args,ret,rdtsc()-start);
         }
+        if(results){
+            results[i]=ret;
+        }
+
+        if(ret<0 && (flags & BATCH_STOP_ON_ERROR)){
+            return i+1;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief 根据耗时计算直方图的桶号
+ * @param ns 耗时
+ * @return 桶号
+ */
+static int syscall_hist_index(uint64_t ns){
+    uint32_t v=(uint32_t)(ns >> SYSCALL_HIST_SHIFT);
+    if((ns >> 32) || v >= (1u << (SYSCALL_HIST_NR-2))){
+        return SYSCALL_HIST_NR-1;
+    }
+    return v ? bsr(v)+1 : 0;
+}
+
+/**
+ * @brief 累加一次调用的统计
+ */
+static void syscall_counter_add(syscall_counter_t* counter,int ret,uint64_t cycles,int hist){
+    counter->count++;
+    if(ret<0){
+        counter->errors++;
+    }
+    counter->total+=cycles;
+    if(cycles>counter->max){
+        counter->max=cycles;
+    }
+    counter->hist[hist]++;
+}
+
+/**
+ * @brief 记录一次系统调用的统计，以及开启跟踪的任务的跟踪记录
+ * @param task 发起调用的任务
+ * @param args 调用号和参数
+ * @param ret 返回值
+ * @param cycles 耗时的时钟周期数
+ */
+static void syscall_account(task_t* task,syscall_args_t* args,int ret,uint64_t cycles){
+    uint32_t id=args->id;
+    uint64_t ns=clock_cycles_to_ns(cycles);
+    int hist=syscall_hist_index(ns);
+
+    irq_state_t state=irq_enter_protection();
+    if(syscall_counters){
+        syscall_counter_add(syscall_counters+id,ret,cycles,hist);
+    }
+
+    syscall_track_t* track=task->sys_track;
+    if(track && (track->flags & SYSCALL_TRACK_STAT)){
+        syscall_counter_add(track->counters+id,ret,cycles,hist);
+    }
+    if(track && (track->flags & SYSCALL_TRACK_TRACE)){
+        syscall_trace_t* trace=track->trace+(track->tail % SYSCALL_TRACE_NR);
+        trace->seq=track->tail++;
+        trace->id=id;
+        trace->args[0]=args->arg0;
+        trace->args[1]=args->arg1;
+        trace->args[2]=args->arg2;
+        trace->args[3]=args->arg3;
+        trace->ret=ret;
+        trace->ns=(ns >> 32) ? 0xFFFFFFFF : (uint32_t)ns;
+
+        // 缓冲区已满时丢弃最早的记录
+        if(track->tail-track->head>SYSCALL_TRACE_NR){
+            track->head=track->tail-SYSCALL_TRACE_NR;
+        }
+    }
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief 查找pid对应的任务，0表示当前任务
+ */
+static task_t* syscall_find_task(int pid){
+    return pid ? pid_find_task(pid) : task_current();
+}
+
+/**
+ * @brief 设置任务的系统调用统计和跟踪选项，选项在execve后保留
+ * @param pid 任务的pid，0表示当前任务
+ * @param flags SYSCALL_TRACK_xxx的组合，为0时关闭并释放记录
+ * @return 原来的选项，失败返回-1
+ */
+int sys_syscall_ctl(int pid,int flags){
+    task_t* task=syscall_find_task(pid);
+    if(task==(task_t*)0){
+        return -1;
+    }
+
+    syscall_track_t* track=(syscall_track_t*)0;
+    if(flags && task->sys_track==(syscall_track_t*)0){
+        track=(syscall_track_t*)kzalloc(sizeof(syscall_track_t));
+        if(track==(syscall_track_t*)0){
+            return -1;
+        }
+    }
+
+    irq_state_t state=irq_enter_protection();
+    int old=task->sys_track ? task->sys_track->flags : 0;
+    if(flags==0){
+        // 取下后再释放，统计代码只在关中断下访问该记录
+        track=task->sys_track;
+        task->sys_track=(syscall_track_t*)0;
+    }
+    else{
+        if(task->sys_track==(syscall_track_t*)0){
+            task->sys_track=track;
+            track=(syscall_track_t*)0;
+        }
+        task->sys_track->flags=flags;
+    }
+    irq_leave_protection(state);
+
+    if(track){
+        kfree(track);
+    }
+    return old;
+}
+
+/**
+ * @brief 读取系统调用的统计
+ * @param pid 任务的pid，0表示当前任务，SYSCALL_STAT_ALL表示系统范围
+ * @param stat 保存结果，共SYSCALL_STAT_NR项，按调用号索引，可以为0
+ * @param reset 为1时读取后清除统计
+ * @return 0 成功，-1 任务不存在或未开启统计
+ */
+int sys_syscall_stat(int pid,syscall_stat_t* stat,int reset){
+    syscall_counter_t* counters=syscall_counters;
+    if(pid!=SYSCALL_STAT_ALL){
+        task_t* task=syscall_find_task(pid);
+        if(task==(task_t*)0 || task->sys_track==(syscall_track_t*)0){
+            return -1;
+        }
+        counters=task->sys_track->counters;
+    }
+    if(counters==(syscall_counter_t*)0 || memory_check_user(stat,SYSCALL_STAT_NR*sizeof(syscall_stat_t),1)<0){
+        return -1;
+    }
+
+    irq_state_t state=irq_enter_protection();
+    for(int i=0;stat && i<SYSCALL_STAT_NR;i++){
+        syscall_counter_t* counter=counters+i;
+        syscall_stat_t* out=stat+i;
+        out->count=counter->count;
+        out->errors=counter->errors;
+        out->total_ns=clock_cycles_to_ns(counter->total);
+        out->max_ns=(uint32_t)clock_cycles_to_ns(counter->max);
+        kernel_memcpy(out->hist,counter->hist,sizeof(out->hist));
+    }
+    if(reset){
+        kernel_memset(counters,0,sizeof(syscall_counter_t)*SYSCALL_STAT_NR);
+    }
+    irq_leave_protection(state);
+    return 0;
+}
+
+/**
+ * @brief 取出任务的跟踪记录，已取出的记录从缓冲区中移除
+ * @param pid 任务的pid，0表示当前任务，已退出但未被回收的任务仍可读取
+ * @param buf 保存记录
+ * @param count buf最多能保存的记录数
+ * @return 取出的记录数，-1 任务不存在或未开启跟踪
+ */
+int sys_syscall_trace(int pid,syscall_trace_t* buf,int count){
+    task_t* task=syscall_find_task(pid);
+    if(task==(task_t*)0 || buf==(syscall_trace_t*)0 || count<0){
+        return -1;
+    }
+    if(memory_check_user(buf,count*sizeof(syscall_trace_t),1)<0){
+        return -1;
+    }
+
+    irq_state_t state=irq_enter_protection();
+    syscall_track_t* track=task->sys_track;
+    if(track==(syscall_track_t*)0 || !(track->flags & SYSCALL_TRACK_TRACE)){
+        irq_leave_protection(state);
+        return -1;
+    }
+
+    int n=0;
+    while(n<count && track->head!=track->tail){
+        buf[n++]=track->trace[track->head++ % SYSCALL_TRACE_NR];
+    }
+    irq_leave_protection(state);
+    return n;
+}
+
+/**
+ * @brief 释放任务的统计和跟踪记录，在回收任务时调用
+ * @param task 任务
+ */
+void syscall_track_free(task_t* task){
+    if(task->sys_track){
+        kfree(task->sys_track);
+        task->sys_track=(syscall_track_t*)0;
+    }
+}
+
+/**
+ * @brief 分配系统范围的统计
+ */
+void syscall_init(void){
+    syscall_counters=(syscall_counter_t*)kzalloc(sizeof(syscall_counter_t)*SYSCALL_STAT_NR);
+    if(syscall_counters==(syscall_counter_t*)0){
+        log_printf("alloc syscall counters failed.");
+    }
+}
+
+void do_handler_syscall(syscall_frame_t*frame){
+    syscall_handler_t handler=syscall_lookup(frame->func_id);
+    if(handler){
+        task_t* task=task_current();
+        uint64_t start=rdtsc();
+        int ret=handler(frame->arg0,frame->arg1,frame->arg2,frame->arg3);
+        uint64_t cycles=rdtsc()-start;
+
+        syscall_args_t args={frame->func_id,frame->arg0,frame->arg1,frame->arg2,frame->arg3};
+        syscall_account(task,&args,ret,cycles);
+        frame->eax=ret;
+        return;
     }
 
     task_t* task=task_current();
@@ -4,6 +4,13 @@
 #include "core/syscall.h"
 #include "comm/elf.h"
 #include "fs/fs.h"
+#include "core/pid.h"
+#include "core/kmalloc.h"
+#include "dev/time.h"
+#include "cpu/fpu.h"
+#include "core/softirq.h"
+#include "core/vdso.h"
+#include "core/boottime.h"
 
 /// @brief 任务管理器
 static task_manager_t task_manager;
@@ -11,10 +18,7 @@ static task_manager_t task_manager;
 /// @brief idle_task的栈
 static uint32_t idle_task_stack[IDLE_TASK_SIZE];
 
-/// @brief 任务表用来存储所有的任务
-static task_t task_table[TASK_NR];
-
-/// @brief 互斥锁，用来保护任务表的访问
+/// @brief 互斥锁，用来保护任务数量的统计
 static mutex_t table_mutex;
 
 /**
@@ -62,9 +66,27 @@ static int tss_init(task_t* task,int flag,uint32_t entry,uint32_t esp){
     task->tss.cs=code_sel;
     task->tss.eflags=EFLAGS_DEFAULT | EFLAGS_IF;
 
-    uint32_t page_dir=memory_create_uvm();
-    if(page_dir == 0){
-        goto tss_init_failed;
+    // 内核线程直接使用内核页表，不创建用户地址空间；用户线程共享创建者的地址空间
+    uint32_t page_dir;
+    if(flag & TASK_FLAGS_KTHREAD){
+        task->mm=(mm_t*)0;
+        page_dir=memory_kernel_page_dir();
+    }
+    else if(flag & TASK_FLAGS_THREAD){
+        task->mm=mm_get(task_current()->mm);
+        page_dir=task->mm->page_dir;
+    }
+    else{
+        page_dir=memory_create_uvm();
+        if(page_dir == 0){
+            goto tss_init_failed;
+        }
+
+        task->mm=mm_create(page_dir);
+        if(task->mm==(mm_t*)0){
+            memory_destroy_uvm(page_dir);
+            goto tss_init_failed;
+        }
     }
     task->tss.cr3=page_dir;
     task->tss_sel=tss_sel;
@@ -78,11 +100,89 @@ tss_init_failed:
 
 }
 
+/**
+ * @brief 分配一个空的打开文件表
+ * @param size 文件表的初始大小
+ * @return 成功返回文件表，失败返回0
+ */
+static files_t* files_alloc(int size){
+    files_t* files=(files_t*)kmalloc(sizeof(files_t));
+    if(files==(files_t*)0){
+        return (files_t*)0;
+    }
+
+    files->table=(file_t**)kzalloc(size*sizeof(file_t*));
+    if(files->table==(file_t**)0){
+        kfree(files);
+        return (files_t*)0;
+    }
+    files->size=size;
+    files->ref=1;
+    return files;
+}
+
+/**
+ * @brief 增加打开文件表的引用计数，创建线程时使用
+ * @param files 文件表
+ * @return 传入的files
+ */
+static files_t* files_get(files_t* files){
+    irq_state_t state=irq_enter_protection();
+    files->ref++;
+    irq_leave_protection(state);
+    return files;
+}
+
+/**
+ * @brief 减少打开文件表的引用计数，最后一个使用者释放时关闭其中所有文件
+ * @param files 文件表
+ */
+static void files_put(files_t* files){
+    irq_state_t state=irq_enter_protection();
+    int ref=--files->ref;
+    irq_leave_protection(state);
+
+    if(ref){
+        return;
+    }
+
+    for(int fd=0;fd<files->size;fd++){
+        file_t* file=files->table[fd];
+        if(file){
+            files->table[fd]=(file_t*)0;
+            fs_close_file(file);
+        }
+    }
+    kfree(files->table);
+    kfree(files);
+}
+
 int task_init(task_t* task,const char*name,int flag,uint32_t entry,uint32_t esp){
     ASSERT(task!=(task_t*)0);
+    int pid=pid_alloc();
+    if(pid<0){
+        log_printf("no free pid.");
+        return -1;
+    }
+
+    if(flag & TASK_FLAGS_THREAD){
+        task->files=files_get(task_current()->files);
+    }
+    else{
+        task->files=files_alloc(TASK_OFILE_INIT);
+        if(task->files==(files_t*)0){
+            log_printf("alloc file table failed.");
+            pid_free(pid);
+            return -1;
+        }
+    }
+
     int err=tss_init(task,flag,entry,esp);
     if(err<0){
         log_printf("init task failed.");
+        files_put(task->files);
+        task->files=(files_t*)0;
+        pid_free(pid);
         return err;
     }
     kernel_strncpy(task->name,name,TASK_NAME_SIZE);
@@ -92,22 +192,33 @@ int task_init(task_t* task,const char*name,int flag,uint32_t entry,uint32_t esp)
     task->slice_ticks=task->time_ticks;
     task->sleep_ticks=0;
     task->status=0;
+    task->flags=flag;
+    task->should_stop=0;
+    task->utime=task->stime=0;
+    task->nvcsw=task->nivcsw=0;
+    task->wait_ticks=0;
+    task->ready_tick=0;
+    task->ready_tsc=0;
+    kernel_memset(&task->sched_lat,0,sizeof(sched_lat_t));
+    task->fpu_state=(void*)0;
+    task->prio=task->base_prio=TASK_PRIO_DEFAULT;
+    list_init(&task->held_list);
+    task->blocked_on=(struct _mutex_t*)0;
     
     list_node_init(&task->all_node);
     list_node_init(&task->run_node);
     list_node_init(&task->wait_node);
+    list_node_init(&task->pid_node);
+    list_init(&task->child_list);
+    list_node_init(&task->child_node);
     
     irq_state_t state=irq_enter_protection();
 
-    task->pid=(uint32_t)task;
+    task->pid=pid;
     task->parent=(task_t*)0;
-    task->heap_start=0;
-    task->heap_end=0;
-
-    // 对task->file_table进行初始化
-    kernel_memset(&task->file_table,0,sizeof(task->file_table));
 
     list_insert_last(&task_manager.task_list,&task->all_node);
+    pid_hash_insert(task);
 
     irq_leave_protection(state);
 
@@ -130,18 +241,41 @@ void task_uninit(task_t* task){
     }
 
     if(task->tss.esp0){
-        memory_free_page(task->tss.esp-MEM_PAGE_SIZE);
+        memory_free_page(task->tss.esp0-MEM_PAGE_SIZE);
     }
 
-    if(task->tss.cr3){
-        memory_destroy_uvm(task->tss.cr3);
+    // 地址空间和文件表可能与其它线程共享，由引用计数决定是否真正释放
+    if(task->mm){
+        mm_put(task->mm);
     }
 
-    kernel_memset(task,0,sizeof(task));
+    if(task->files){
+        files_put(task->files);
+    }
+    fpu_release(task);
+    syscall_track_free(task);
+
+    // pid与all_node在task_init中同时设置，pid非0说明任务已加入任务链表和pid哈希表
+    if(task->pid){
+        irq_state_t state=irq_enter_protection();
+        list_remove(&task_manager.task_list,&task->all_node);
+        pid_hash_remove(task);
+        pid_free(task->pid);
+        irq_leave_protection(state);
+    }
+
+    kernel_memset(task,0,sizeof(task_t));
 }
 
 void task_switch_from_to(task_t*from,task_t*to){
+    // 新任务第一次运行时直接开中断，不经过irq_leave_protection，切换前先结束当前区间
+    irqoff_trace_end((uint32_t)task_switch_from_to);
+    cpu_set_sysenter_stack(to->tss.esp0);
+    vdso_set_pid(to->pid);
     switch_to_tss(to->tss_sel);
+
+    // 切换回来时仍处于task_dispatch的关中断区间中
+    irqoff_trace_begin((uint32_t)task_switch_from_to);
 }
 
 static void idle_task_entry(void){
@@ -150,27 +284,28 @@ static void idle_task_entry(void){
     }
 }
 
+static void task_timer_softirq(void);
+static int task_wait(int pid,int* status,int options,int join);
+
 /**
  * @brief 初始化任务管理器
  */
 void task_manager_init(void){
 
-    kernel_memset(task_table,0,sizeof(task_table));
     mutex_init(&table_mutex);
+    task_manager.task_count=0;
+    task_manager.task_limit=TASK_NR;
+    task_manager.load_ticks=0;
+    task_manager.pending_ticks=0;
+    task_manager.need_resched=0;
+    kernel_memset(task_manager.loadavg,0,sizeof(task_manager.loadavg));
+    kernel_memset(&task_manager.sched_lat,0,sizeof(sched_lat_t));
 
-    int sel=gdt_alloc_desc();
+    pid_init();
 
-    // 这里虽然设置的代码段和数据段范围还是0x0-0xFFFFFFFF，但使用该段的段选择子访问的方式为特权级3
-    segment_desc_set(sel,0x0,0xFFFFFFFF,
-        SEG_P_PRESENT | SEG_DPL3 | SEG_S_NORMAL | SEG_TYPE_DATA | SEG_TYPE_RW | SEG_D
-    );
-    task_manager.app_data_sel=sel;
-
-    sel=gdt_alloc_desc();
-    segment_desc_set(sel,0x0,0xFFFFFFFF,
-           SEG_P_PRESENT | SEG_DPL3 | SEG_S_NORMAL |SEG_TYPE_CODE | SEG_TYPE_RW | SEG_D
-    );
-    task_manager.app_code_sel=sel;
+    // 用户段位于gdt中的固定位置，见init_gdt
+    task_manager.app_data_sel=APP_SELECTOR_DS;
+    task_manager.app_code_sel=APP_SELECTOR_CS;
 
     list_init(&task_manager.ready_list);
     list_init(&task_manager.task_list);
@@ -180,6 +315,8 @@ void task_manager_init(void){
     (uint32_t)(idle_task_stack+IDLE_TASK_SIZE));
 
     task_start(&task_manager.idle_task);
+
+    softirq_register(SOFTIRQ_TIMER,task_timer_softirq);
 }
 
 /**
@@ -198,8 +335,8 @@ void task_first_init(void){
 
     task_init(&task_manager.first_task,"first task",0,first_start,first_start+alloc_size);
 
-    task_manager.first_task.heap_start=(uint32_t)e_first_task;
-    task_manager.first_task.heap_end=(uint32_t)e_first_task;
+    task_manager.first_task.mm->heap_start=(uint32_t)e_first_task;
+    task_manager.first_task.mm->heap_end=(uint32_t)e_first_task;
 
     write_tr(task_manager.first_task.tss_sel);
     task_manager.curr_task=&task_manager.first_task;
@@ -216,18 +353,36 @@ task_t* task_first_task(void){
     return &task_manager.first_task;
 }
 
+/**
+ * @brief 按优先级将任务插入就绪队列，排在所有优先级不低于它的任务之后
+ * @param task 需要插入的任务
+ */
+static void ready_list_insert(task_t* task){
+    list_node_t* node=list_first(&task_manager.ready_list);
+    while(node){
+        task_t* curr=list_node_parent(node,task_t,run_node);
+        if(curr->prio>task->prio){
+            break;
+        }
+        node=list_node_next(node);
+    }
+    list_insert_before(&task_manager.ready_list,node,&task->run_node);
+}
+
 /**
  * @brief 设置任务为就绪状态
  * @param task 需要设置的任务
  * @return 0 成功，-1 失败
- * @note 该函数会将任务插入到就绪队列中，将任务的状态设置为就绪
+ * @note 该函数会将任务按优先级插入到就绪队列中，将任务的状态设置为就绪
  */
 void task_set_ready(task_t* task){
     if(task==&task_manager.idle_task){
         return;
     }
-    list_insert_last(&task_manager.ready_list,&task->run_node);
+    ready_list_insert(task);
     task->state=TASK_READY;
+    task->ready_tick=time_get_tick();
+    task->ready_tsc=rdtsc();
 }
 
 void task_set_block(task_t* task){
@@ -263,40 +418,206 @@ int sys_sched_yield(void){
     return 0;
 }
 
+/**
+ * @brief 将一次调度延迟记录到直方图中
+ * @param lat 延迟统计
+ * @param cycles 延迟的时钟周期数
+ * @param task 被调度的任务
+ */
+static void sched_lat_record(sched_lat_t* lat,uint64_t cycles,task_t* task){
+    uint32_t high=(uint32_t)(cycles >> 32);
+    uint32_t low=(uint32_t)cycles;
+
+    int bucket=0;
+    if(high){
+        bucket=32+bsr(high);
+    }
+    else if(low){
+        bucket=bsr(low);
+    }
+    if(bucket>=SCHED_LAT_BUCKETS){
+        bucket=SCHED_LAT_BUCKETS-1;
+    }
+
+    lat->hist[bucket]++;
+    lat->count++;
+    if(cycles>lat->max){
+        lat->max=cycles;
+        lat->max_pid=task->pid;
+        kernel_strncpy(lat->max_name,task->name,TASK_INFO_NAME_SIZE);
+    }
+}
+
+/**
+ * @brief 判断任务是否仍在就绪队列中，用于区分主动切换和被抢占
+ * @param task 需要判断的任务
+ * @return 1 在就绪队列中，0 已阻塞
+ */
+static int task_is_runnable(task_t* task){
+    if(task->state==TASK_SLEEP){
+        return 0;
+    }
+    return task->run_node.pre || task->run_node.next
+        || (list_first(&task_manager.ready_list)==&task->run_node);
+}
+
+/**
+ * @brief 修改任务当前的优先级，任务在就绪队列中时重新排序
+ * @param task 需要修改的任务
+ * @param prio 新的优先级
+ * @note 调用者需要处于临界区中，调度在下一次task_dispatch时生效
+ */
+void task_set_prio(task_t* task,int prio){
+    if(task->prio==prio){
+        return;
+    }
+
+    task->prio=prio;
+    if((task!=&task_manager.idle_task) && task_is_runnable(task)){
+        list_remove(&task_manager.ready_list,&task->run_node);
+        ready_list_insert(task);
+    }
+}
+
 void task_dispatch(void){
     irq_state_t state=irq_enter_protection();
+
+    // 中断和软中断上下文中不切换任务，推迟到中断返回前进行
+    if(in_interrupt()){
+        task_manager.need_resched=1;
+        irq_leave_protection(state);
+        return;
+    }
+    task_manager.need_resched=0;
+
     task_t* to=task_next_run();
     if(to!=task_manager.curr_task){
         task_t* from=task_current();
+        if(from){
+            if(task_is_runnable(from)){
+                from->nivcsw++;
+            }
+            else{
+                from->nvcsw++;
+            }
+        }
+
+        if(to->state==TASK_READY){
+            to->wait_ticks+=time_get_tick()-to->ready_tick;
+
+            uint64_t latency=rdtsc()-to->ready_tsc;
+            sched_lat_record(&to->sched_lat,latency,to);
+            sched_lat_record(&task_manager.sched_lat,latency,to);
+        }
+
         task_manager.curr_task=to;
         to->state=TASK_RUNNING;
         task_switch_from_to(from,to);
     }
+    else if(to->state==TASK_READY){
+        // 重新选中当前任务时不发生切换，等待时间从这里重新算起，不计入已运行的时间
+        to->ready_tick=time_get_tick();
+        to->ready_tsc=rdtsc();
+        to->state=TASK_RUNNING;
+    }
     irq_leave_protection(state);
 }
 
-void task_time_tick(void){
+/**
+ * @brief 按指数衰减更新一个平均负载值
+ * @param load 原来的平均负载
+ * @param exp 衰减系数
+ * @param active 当前活动的任务数，定点数表示
+ * @return 新的平均负载
+ */
+static uint32_t calc_load(uint32_t load,uint32_t exp,uint32_t active){
+    load*=exp;
+    load+=active*(FIXED_1-exp);
+    return load>>FSHIFT;
+}
+
+/**
+ * @brief 每TASK_LOAD_FREQ个tick统计一次就绪任务数，更新平均负载
+ * @param ticks 自上次调用以来经过的tick数
+ */
+static void task_calc_load(uint32_t ticks){
+    task_manager.load_ticks+=ticks;
+    if(task_manager.load_ticks<TASK_LOAD_FREQ){
+        return;
+    }
+    task_manager.load_ticks=0;
+
+    uint32_t active=list_count(&task_manager.ready_list)*FIXED_1;
+    task_manager.loadavg[0]=calc_load(task_manager.loadavg[0],EXP_1,active);
+    task_manager.loadavg[1]=calc_load(task_manager.loadavg[1],EXP_5,active);
+    task_manager.loadavg[2]=calc_load(task_manager.loadavg[2],EXP_15,active);
+}
+
+/**
+ * @brief 时钟中断处理，负责时间片轮转、睡眠唤醒和cpu时间统计
+ * @param user_mode 时钟中断发生时是否处于用户态
+ */
+void task_time_tick(int user_mode){
     irq_state_t state=irq_enter_protection();
     task_t* curr_task=task_current();
+    if(user_mode){
+        curr_task->utime++;
+    }
+    else{
+        curr_task->stime++;
+    }
+
     if(--curr_task->slice_ticks==0){
         curr_task->slice_ticks=curr_task->time_ticks;
         task_set_block(curr_task);
         task_set_ready(curr_task);
+        task_manager.need_resched=1;
+    }
+
+    // 负载统计和睡眠队列扫描交给软中断，可能合并多个tick一起处理
+    task_manager.pending_ticks++;
+    irq_leave_protection(state);
+    softirq_raise(SOFTIRQ_TIMER);
+}
+
+/**
+ * @brief 定时器软中断，处理中断期间累积的tick：更新负载并唤醒到期的睡眠任务
+ */
+static void task_timer_softirq(void){
+    irq_state_t state=irq_enter_protection();
+    uint32_t ticks=task_manager.pending_ticks;
+    task_manager.pending_ticks=0;
+    if(ticks==0){
+        irq_leave_protection(state);
+        return;
     }
+
+    task_calc_load(ticks);
+
     list_node_t* curr=list_first(&task_manager.sleep_list);
     while(curr){
         list_node_t*next=list_node_next(curr);
         task_t* task=list_node_parent(curr,task_t,run_node);
-        if(--task->sleep_ticks==0){
+        task->sleep_ticks-=ticks;
+        if(task->sleep_ticks<=0){
             task_set_wakeup(task);
             task_set_ready(task);
+            task_manager.need_resched=1;
         }
         curr=next;
     }
-    task_dispatch();
     irq_leave_protection(state);
 }
 
+/**
+ * @brief 若有推迟的任务切换则执行调度，在中断返回前或软中断线程中调用
+ */
+void task_resched(void){
+    if(task_manager.need_resched){
+        task_dispatch();
+    }
+}
+
 void task_set_sleep(task_t* task,uint32_t ticks){
     if(ticks==0){
         return;
@@ -330,41 +651,134 @@ int sys_getpid(void){
     return task->pid;
 }
 
-static task_t* alloc_task(void){
-    task_t* task=(task_t*)0;
+/**
+ * @brief 动态分配一个任务结构，任务数量受task_limit限制
+ * @return 分配的任务，超出限制或内存不足时返回0
+ */
+task_t* alloc_task(void){
     mutex_lock(&table_mutex);
-    for(int i=0;i<TASK_NR;i++){
-        task_t* curr=task_table+i;
-        if(curr->pid==0){
-            task=curr;
-            break;
-        }
-    }   
+    if(task_manager.task_count>=task_manager.task_limit){
+        mutex_unlock(&table_mutex);
+        log_printf("too many tasks, limit=%d",task_manager.task_limit);
+        return (task_t*)0;
+    }
+    task_manager.task_count++;
     mutex_unlock(&table_mutex);
 
+    task_t* task=(task_t*)kzalloc(sizeof(task_t));
+    if(task==(task_t*)0){
+        mutex_lock(&table_mutex);
+        task_manager.task_count--;
+        mutex_unlock(&table_mutex);
+    }
+
     return task;
 }
 
-static void free_task(task_t* task){
+/**
+ * @brief 释放任务结构，调用前需先task_uninit
+ * @param task 需要释放的任务
+ */
+void free_task(task_t* task){
+    kfree(task);
+
+    mutex_lock(&table_mutex);
+    task_manager.task_count--;
+    mutex_unlock(&table_mutex);
+}
+
+/**
+ * @brief 设置动态分配任务的最大数量
+ * @param limit 新的最大数量，不能小于1
+ * @return 原来的最大数量，参数错误返回-1
+ */
+int task_set_limit(int limit){
+    if(limit<1){
+        return -1;
+    }
+
     mutex_lock(&table_mutex);
-    task->pid=0;
+    int old=task_manager.task_limit;
+    task_manager.task_limit=limit;
     mutex_unlock(&table_mutex);
+    return old;
+}
+
+/**
+ * @brief 扩大打开文件表，每次扩大为原来的两倍
+ * @param files 需要扩大的文件表
+ * @param size 至少需要的大小
+ * @return 0 成功，-1 失败
+ */
+static int files_expand(files_t* files,int size){
+    int new_size=files->size;
+    while(new_size<size){
+        new_size*=2;
+    }
+    if(new_size>TASK_OFILE_NR){
+        return -1;
+    }
+
+    file_t** table=(file_t**)kzalloc(new_size*sizeof(file_t*));
+    if(table==(file_t**)0){
+        return -1;
+    }
+
+    // 文件表可能被其它线程同时扩大，替换时重新检查
+    irq_state_t state=irq_enter_protection();
+    file_t** old_table=table;
+    if(files->size<new_size){
+        kernel_memcpy(table,files->table,files->size*sizeof(file_t*));
+        old_table=files->table;
+        files->table=table;
+        files->size=new_size;
+    }
+    irq_leave_protection(state);
+
+    kfree(old_table);
+    return 0;
+}
+
+/**
+ * @brief 设置任务的父进程，同时维护父进程的子进程链表
+ * @param task 子任务
+ * @param parent 新的父进程，为0时只从原父进程中移除
+ */
+void task_set_parent(task_t* task,task_t* parent){
+    irq_state_t state=irq_enter_protection();
+    if(task->parent){
+        list_remove(&task->parent->child_list,&task->child_node);
+    }
+    task->parent=parent;
+    if(parent){
+        list_insert_last(&parent->child_list,&task->child_node);
+    }
+    irq_leave_protection(state);
 }
 
 /**
  * @brief 复制父进程打开的文件到子进程
  * @param child_task 子进程
+ * @return 0 成功，-1 失败
  */
-static void copy_opened_files(task_t* child_task){
-    task_t* parent=task_current();
-    for(int i=0;i<TASK_OFILE_NR;i++){
+static int copy_opened_files(task_t* child_task){
+    files_t* parent=task_current()->files;
+    files_t* child=child_task->files;
+    if(parent->size>child->size){
+        if(files_expand(child,parent->size)<0){
+            return -1;
+        }
+    }
+
+    for(int i=0;i<parent->size;i++){
 
-        file_t* file=parent->file_table[i];
+        file_t* file=parent->table[i];
         if(file){
             file_inc_ref(file);
-            child_task->file_table[i]=file;
+            child->table[i]=file;
         }
     }
+    return 0;
 }
 
 /**
@@ -384,7 +798,15 @@ int sys_fork(void){
         goto fork_failed;
     }
 
-    copy_opened_files(child_task);
+    if(copy_opened_files(child_task)<0){
+        goto fork_failed;
+    }
+
+    if(fpu_copy(child_task,parent_task)<0){
+        goto fork_failed;
+    }
+
+    child_task->prio=child_task->base_prio=parent_task->base_prio;
 
     tss_t* tss=&child_task->tss;
     tss->eax= 0;
@@ -402,12 +824,18 @@ int sys_fork(void){
     tss->gs=frame->gs;
     tss->eflags=frame->eflags;
 
-    child_task->parent=parent_task;
-
-    if((tss->cr3=memory_copy_uvm(parent_task->tss.cr3))<0){
+    // 用复制的地址空间替换task_init创建的空地址空间
+    uint32_t page_dir=memory_copy_uvm(parent_task->mm->page_dir);
+    if(page_dir==0){
         goto fork_failed;
     }
+    memory_destroy_uvm(child_task->mm->page_dir);
+    child_task->mm->page_dir=page_dir;
+    child_task->mm->heap_start=parent_task->mm->heap_start;
+    child_task->mm->heap_end=parent_task->mm->heap_end;
+    tss->cr3=page_dir;
 
+    task_set_parent(child_task,parent_task);
     task_start(child_task);
 
     return child_task->pid;
@@ -421,6 +849,98 @@ fork_failed:
     return -1;
 }
 
+/**
+ * @brief 设置任务自身的优先级，持有锁时仍保留继承得到的优先级
+ * @param pid 任务的pid，0表示当前任务
+ * @param prio 新的优先级，范围TASK_PRIO_HIGHEST~TASK_PRIO_LOWEST
+ * @return 成功返回原来的优先级，失败返回-1
+ */
+int sys_setprio(int pid,int prio){
+    if((prio<TASK_PRIO_HIGHEST) || (prio>TASK_PRIO_LOWEST)){
+        return -1;
+    }
+
+    irq_state_t state=irq_enter_protection();
+    task_t* task=pid ? pid_find_task(pid) : task_current();
+    if((task==(task_t*)0) || (task==&task_manager.idle_task) || (task->state==TASK_ZOMBIE)){
+        irq_leave_protection(state);
+        return -1;
+    }
+
+    int old_prio=task->base_prio;
+    task->base_prio=prio;
+    mutex_prio_changed(task);
+    task_dispatch();
+    irq_leave_protection(state);
+
+    return old_prio;
+}
+
+/**
+ * @brief 创建一个与当前进程共享地址空间和打开文件表的线程
+ * @param entry 线程的入口函数，形式为void entry(void* arg)，不能直接返回
+ * @param arg 传给入口函数的参数
+ * @param stack_top 线程用户栈的栈顶，由调用者分配
+ * @return 成功返回线程的pid，失败返回-1
+ */
+int sys_thread_create(uint32_t entry,uint32_t arg,uint32_t stack_top){
+    task_t* curr=task_current();
+    if((curr->mm==(mm_t*)0) || (stack_top<MEMORY_TASK_BASE+sizeof(uint32_t)*2)){
+        return -1;
+    }
+
+    // 在线程栈上构造entry(arg)的调用现场，返回地址为0，写入前确认这两个字用户可写
+    uint32_t* stack=(uint32_t*)(stack_top & ~0xF);
+    if((memory_get_user_paddr(curr->tss.cr3,(uint32_t)(stack-1),1)==0)
+        || (memory_get_user_paddr(curr->tss.cr3,(uint32_t)(stack-2),1)==0)){
+        return -1;
+    }
+
+    task_t* thread=alloc_task();
+    if(thread==(task_t*)0){
+        return -1;
+    }
+
+    *--stack=arg;
+    *--stack=0;
+
+    int err=task_init(thread,curr->name,TASK_FLAGS_THREAD,entry,(uint32_t)stack);
+    if(err<0){
+        free_task(thread);
+        return -1;
+    }
+
+    thread->prio=thread->base_prio=curr->base_prio;
+    task_set_parent(thread,curr);
+    task_start(thread);
+    return thread->pid;
+}
+
+/**
+ * @brief 等待同一进程中的线程结束并回收
+ * @param tid 线程的pid
+ * @param status 线程的退出状态，可以为0
+ * @return 成功返回线程的pid，失败返回-1
+ */
+int sys_thread_join(int tid,int* status){
+    task_t* curr=task_current();
+
+    irq_state_t state=irq_enter_protection();
+    task_t* task=pid_find_task(tid);
+    if((task==(task_t*)0) || (task==curr) || (task->mm!=curr->mm) || !(task->flags & TASK_FLAGS_THREAD)){
+        irq_leave_protection(state);
+        return -1;
+    }
+
+    // 任意线程都可以回收同进程的线程，先把它挂到自己名下再按子进程回收
+    if(task->parent!=curr){
+        task_set_parent(task,curr);
+    }
+    irq_leave_protection(state);
+
+    return task_wait(tid,status,0,1);
+}
+
 static int load_phdr(int file,Elf32_Phdr*phdr ,uint32_t page_dir){
     int err=memory_alloc_for_page_dir(page_dir,phdr->p_vaddr,phdr->p_memsz,PTE_P|PTE_U|PTE_W);
     if(err < 0){
@@ -453,7 +973,8 @@ static int load_phdr(int file,Elf32_Phdr*phdr ,uint32_t page_dir){
 
 }
 
-static uint32_t load_elf_file(task_t* task,const char* name,uint32_t page_dir){
+static uint32_t load_elf_file(mm_t* mm,const char* name){
+    uint32_t page_dir=mm->page_dir;
     Elf32_Ehdr elf_hdr;
     Elf32_Phdr elf_phdr;
 
@@ -498,8 +1019,8 @@ static uint32_t load_elf_file(task_t* task,const char* name,uint32_t page_dir){
             goto load_failed;
         }
 
-        task->heap_start=elf_phdr.p_vaddr+elf_phdr.p_memsz;
-        task->heap_end=task->heap_start;
+        mm->heap_start=elf_phdr.p_vaddr+elf_phdr.p_memsz;
+        mm->heap_end=mm->heap_start;
     }
 
 
@@ -540,19 +1061,34 @@ static int copy_args(char* to,uint32_t page_dir,int argc,char**argv){
 
 }
 
+/**
+ * @brief 用新程序替换当前任务的地址空间
+ * @param name 程序的路径
+ * @param argv 参数
+ * @param env 环境变量，未使用
+ * @return 成功时返回到新程序的入口，失败返回-1
+ * @note 只替换调用者自己的地址空间，同进程的其它线程继续在旧地址空间中运行，
+ *       旧地址空间在它们全部退出后才释放
+ */
 int sys_execve(char* name,char** argv,char** env){
     task_t* task=task_current();
 
     kernel_strncpy(task->name,get_file_name(name),TASK_NAME_SIZE);
 
-    uint32_t old_page_dir=task->tss.cr3;
+    mm_t* new_mm=(mm_t*)0;
     uint32_t new_page_dir=memory_create_uvm();
 
     if(!new_page_dir){
         goto exec_failed;
     }
 
-    uint32_t entry=load_elf_file(task,name,new_page_dir);
+    new_mm=mm_create(new_page_dir);
+    if(new_mm==(mm_t*)0){
+        memory_destroy_uvm(new_page_dir);
+        goto exec_failed;
+    }
+
+    uint32_t entry=load_elf_file(new_mm,name);
 
     if(entry==0){
         goto exec_failed;
@@ -583,19 +1119,24 @@ int sys_execve(char* name,char** argv,char** env){
 
     frame->esp=stack_top-sizeof(uint32_t)*SYSCALL_PARAM_COUNT;
 
+    // 旧地址空间可能仍被其它线程使用，只减少引用计数
+    mm_t* old_mm=task->mm;
+    task->mm=new_mm;
     task->tss.cr3=new_page_dir;
     mmu_set_page_dir(new_page_dir);
 
-    memory_destroy_uvm(old_page_dir);
+    // 新程序从初始的浮点状态开始
+    fpu_release(task);
+
+    mm_put(old_mm);
 
+    // 第一个程序加载完成即启动结束
+    boot_time_finish("first_exec");
     return 0;
 
 exec_failed:
-    if(new_page_dir){
-        task->tss.cr3=old_page_dir;
-        mmu_set_page_dir(old_page_dir);
-
-        memory_destroy_uvm(new_page_dir);
+    if(new_mm){
+        mm_put(new_mm);
     }
     return -1;
 }
@@ -606,12 +1147,16 @@ exec_failed:
  * @return 获取成功返回对应的文件指针，不成功返回NULL
  */
 file_t* task_file(int fd){
-    if((fd>=0) && (fd<TASK_OFILE_NR)){
-        file_t* file=task_current()->file_table[fd];
-        return file;
+    files_t* files=task_current()->files;
+    file_t* file=(file_t*)0;
+
+    irq_state_t state=irq_enter_protection();
+    if((fd>=0) && (fd<files->size)){
+        file=files->table[fd];
     }
+    irq_leave_protection(state);
 
-    return (file_t*)0;
+    return file;
 }
 
 /**
@@ -620,17 +1165,26 @@ file_t* task_file(int fd){
  * @return 如果分配成功返回对应的fd如果分配失败返回-1
  */
 int task_alloc_fd(file_t* file){
-    task_t* task=task_current();
+    files_t* files=task_current()->files;
 
-    for(int i=0;i<TASK_OFILE_NR;i++){
-        file_t* p=task->file_table[i];
-        if(p==(file_t*)0){
-            task->file_table[i]=file;
-            return i;
+    for(;;){
+        irq_state_t state=irq_enter_protection();
+        int size=files->size;
+        for(int i=0;i<size;i++){
+            file_t* p=files->table[i];
+            if(p==(file_t*)0){
+                files->table[i]=file;
+                irq_leave_protection(state);
+                return i;
+            }
         }
-    }
+        irq_leave_protection(state);
 
-    return -1;
+        // 文件表已满，扩大后重新查找，其它线程可能同时占用了新增的表项
+        if(files_expand(files,size+1)<0){
+            return -1;
+        }
+    }
 }
 
 /**
@@ -638,44 +1192,41 @@ int task_alloc_fd(file_t* file){
  * @param fd 要释放的文件描述符
  */
 void task_remove_fd(int fd){
-   if((fd>=0) && (fd<TASK_OFILE_NR)){
-       task_current()->file_table[fd]=(file_t*)0;
+    files_t* files=task_current()->files;
+
+    irq_state_t state=irq_enter_protection();
+    if((fd>=0) && (fd<files->size)){
+        files->table[fd]=(file_t*)0;
     }
+    irq_leave_protection(state);
 }
 
 void sys_exit(int status){
     task_t* curr_task=task_current();
 
-    for(int fd=0;fd<TASK_OFILE_NR;fd++){
-        file_t* file=curr_task->file_table[fd];
-        if(file){
-            sys_close(fd);
-            curr_task->file_table[fd]=(file_t*)0;
-        }
-    }
-
-    int move_child=0;
+    // 文件表由同一进程的线程共享，最后一个退出的线程负责关闭文件
+    files_put(curr_task->files);
+    curr_task->files=(files_t*)0;
 
-    mutex_lock(&table_mutex);
+    irq_state_t state=irq_enter_protection();
 
-    for(int i=0;i<TASK_NR;i++){
-        task_t* task=task_table+i;
-        if(task->parent==curr_task){
-            task->parent=&task_manager.first_task;
-            if(task->state==TASK_ZOMBIE){
-                move_child=1;  
-            }
+    // 将所有子进程交给first_task
+    task_t* first_task=&task_manager.first_task;
+    int move_child=0;
+    list_node_t* node;
+    while((node=list_remove_first(&curr_task->child_list))!=(list_node_t*)0){
+        task_t* task=list_node_parent(node,task_t,child_node);
+        task->parent=first_task;
+        list_insert_last(&first_task->child_list,&task->child_node);
+        if(task->state==TASK_ZOMBIE){
+            move_child=1;
         }
     }
 
-    mutex_unlock(&table_mutex);
-
-    irq_state_t state=irq_enter_protection();
-
     task_t* parent=curr_task->parent;
-    if(move_child && (parent!=&task_manager.first_task)){
-        if(task_manager.first_task.state==TASK_WAITING){
-            task_set_ready(&task_manager.first_task);
+    if(move_child && (parent!=first_task)){
+        if(first_task->state==TASK_WAITING){
+            task_set_ready(first_task);
         }
     }
 
@@ -700,40 +1251,229 @@ void sys_exit(int status){
  * @return 返回子进程的pid
  */
 int sys_wait(int* status){
+    return sys_waitpid(-1,status,0);
+}
+
+/**
+ * @brief 判断子任务是否由当前的等待方式回收
+ * @param curr 等待的任务
+ * @param task 子任务
+ * @param join 为1时只回收线程，为0时跳过同一进程的线程，这些线程需通过thread_join回收
+ * @return 可以回收返回1，否则返回0
+ */
+static int task_wait_match(task_t* curr,task_t* task,int join){
+    if(join){
+        return (task->flags & TASK_FLAGS_THREAD) ? 1 : 0;
+    }
+
+    // 进程退出后转交给first_task的线程不再有人join，仍按子进程回收
+    return !((task->flags & TASK_FLAGS_THREAD) && (task->mm==curr->mm));
+}
+
+/**
+ * @brief 等待指定的子任务结束并回收其资源
+ * @param pid 子任务的pid，-1表示任意子任务
+ * @param status 退出状态码，可以为0
+ * @param options WAIT_NOHANG表示没有已结束的子任务时立即返回，WAIT_NOWAIT表示不回收子任务
+ * @param join 为1时用于thread_join回收线程，为0时用于waitpid回收子进程
+ * @return 回收的子任务pid，WAIT_NOHANG下没有已结束的子任务返回0，没有对应的子任务返回-1
+ */
+static int task_wait(int pid,int* status,int options,int join){
     task_t* curr_task=task_current();
+    if(memory_check_user(status,sizeof(int),1)<0){
+        return -1;
+    }
 
-    // 注意这个for(;;){}的位置
     for(;;){
-        mutex_lock(&table_mutex);
+        irq_state_t state=irq_enter_protection();
 
-        for(int i=0;i<TASK_NR;i++){
-            task_t* task=task_table+i;
-            if(task->parent != curr_task){
-                continue;
-            }    
+        int has_child=0;
+        task_t* zombie=(task_t*)0;
+        if(pid>0){
+            task_t* task=pid_find_task(pid);
+            if(task && (task->parent==curr_task) && task_wait_match(curr_task,task,join)){
+                has_child=1;
+                if(task->state==TASK_ZOMBIE){
+                    zombie=task;
+                }
+            }
+        }
+        else{
+            list_node_t* node=list_first(&curr_task->child_list);
+            while(node){
+                task_t* task=list_node_parent(node,task_t,child_node);
+                node=list_node_next(node);
+                if(!task_wait_match(curr_task,task,join)){
+                    continue;
+                }
+
+                has_child=1;
+                if(task->state==TASK_ZOMBIE){
+                    zombie=task;
+                    break;
+                }
+            }
+        }
 
-            if(task->state==TASK_ZOMBIE){
-                int pid=task->pid;
-                *status=task->status;
-                
-                task_uninit(task);
-                kernel_memset(task,0,sizeof(task_t));
+        if(zombie){
+            if(options & WAIT_NOWAIT){
+                irq_leave_protection(state);
+                if(status){
+                    *status=zombie->status;
+                }
+                return zombie->pid;
+            }
 
-                mutex_unlock(&table_mutex);
+            list_remove(&curr_task->child_list,&zombie->child_node);
+            irq_leave_protection(state);
 
-                return pid;
+            int child_pid=zombie->pid;
+            if(status){
+                *status=zombie->status;
             }
+
+            task_uninit(zombie);
+            free_task(zombie);
+            return child_pid;
         }
 
-        irq_state_t state=irq_enter_protection();
+        if(!has_child || (options & WAIT_NOHANG)){
+            irq_leave_protection(state);
+            return has_child ? 0 : -1;
+        }
 
+        // 子进程退出时会将当前任务重新设置为就绪
         task_set_block(curr_task);
         curr_task->state=TASK_WAITING;
+        task_dispatch();
 
         irq_leave_protection(state);
+    }
+}
 
-        mutex_unlock(&table_mutex);
+/**
+ * @brief 等待指定的子进程结束并回收其资源，同一进程的线程不在此回收
+ * @param pid 子进程的pid，-1表示任意子进程
+ * @param status 退出状态码，可以为0
+ * @param options WAIT_NOHANG表示没有已结束的子进程时立即返回，WAIT_NOWAIT表示不回收子进程
+ * @return 回收的子进程pid，WAIT_NOHANG下没有已结束的子进程返回0，没有对应的子进程返回-1
+ */
+int sys_waitpid(int pid,int* status,int options){
+    return task_wait(pid,status,options,0);
+}
 
-        task_dispatch();
+/**
+ * @brief 将任务状态转换为ps显示的字符
+ * @param task 任务
+ * @return 状态字符
+ */
+static char task_state_char(task_t* task){
+    switch(task->state){
+        case TASK_CREATED:
+            return 'C';
+        case TASK_SLEEP:
+            return 'S';
+        case TASK_WAITING:
+            return 'W';
+        case TASK_ZOMBIE:
+            return 'Z';
+        default:
+            return task_is_runnable(task) ? 'R' : 'W';
+    }
+}
+
+/**
+ * @brief 获取所有任务的运行信息
+ * @param info 存放任务信息的数组
+ * @param count 数组的大小
+ * @return 写入的任务信息数量
+ */
+int sys_get_task_info(task_info_t* info,int count){
+    if((info==(task_info_t*)0) || (count<=0)){
+        return -1;
+    }
+    if(memory_check_user(info,count*sizeof(task_info_t),1)<0){
+        return -1;
+    }
+
+    int index=0;
+    irq_state_t state=irq_enter_protection();
+    list_node_t* node=list_first(&task_manager.task_list);
+    while(node && (index<count)){
+        task_t* task=list_node_parent(node,task_t,all_node);
+        task_info_t* curr=info+index++;
+
+        curr->pid=task->pid;
+        curr->ppid=task->parent ? task->parent->pid : 0;
+        curr->state=task_state_char(task);
+        kernel_strncpy(curr->name,task->name,TASK_INFO_NAME_SIZE);
+        curr->utime=task->utime;
+        curr->stime=task->stime;
+        curr->nvcsw=task->nvcsw;
+        curr->nivcsw=task->nivcsw;
+        curr->wait_ticks=task->wait_ticks;
+        curr->prio=task->prio;
+
+        node=list_node_next(node);
+    }
+    irq_leave_protection(state);
+
+    return index;
+}
+
+/**
+ * @brief 获取系统的运行信息
+ * @param info 存放系统信息的结构体
+ * @return 0 成功，-1 失败
+ */
+int sys_get_sys_info(sys_info_t* info){
+    if((info==(sys_info_t*)0) || (memory_check_user(info,sizeof(sys_info_t),1)<0)){
+        return -1;
+    }
+
+    irq_state_t state=irq_enter_protection();
+    info->ticks=time_get_tick();
+    info->tick_ms=OS_TICK_MS;
+    info->task_count=list_count(&task_manager.task_list);
+    info->nr_running=list_count(&task_manager.ready_list);
+    for(int i=0;i<3;i++){
+        info->loadavg[i]=task_manager.loadavg[i];
+    }
+    irq_leave_protection(state);
+
+    return 0;
+}
+
+/**
+ * @brief 读取并可选地清空调度延迟统计
+ * @param pid 任务的pid，0表示全局统计
+ * @param lat 存放统计结果，可以为0表示只清空
+ * @param reset 非0时读取后清空统计
+ * @return 0 成功，-1 任务不存在
+ */
+int sys_sched_lat(int pid,sched_lat_t* lat,int reset){
+    sched_lat_t* src=&task_manager.sched_lat;
+    if(memory_check_user(lat,sizeof(sched_lat_t),1)<0){
+        return -1;
     }
+
+    irq_state_t state=irq_enter_protection();
+    if(pid){
+        task_t* task=pid_find_task(pid);
+        if(task==(task_t*)0){
+            irq_leave_protection(state);
+            return -1;
+        }
+        src=&task->sched_lat;
+    }
+
+    if(lat){
+        kernel_memcpy(lat,src,sizeof(sched_lat_t));
+    }
+    if(reset){
+        kernel_memset(src,0,sizeof(sched_lat_t));
+    }
+    irq_leave_protection(state);
+
+    return 0;
 }
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "core/vdso.h"
+#include "core/memory.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+/// @brief 共享页的物理地址，内核通过恒等映射直接写入
+static vdso_data_t* vdso_page;
+
+/**
+ * @brief 分配共享页，需在创建第一个用户地址空间之前调用
+ */
+void vdso_init(void){
+    vdso_page=(vdso_data_t*)memory_alloc_page();
+    if(vdso_page==(vdso_data_t*)0){
+        log_printf("alloc vdso page failed.");
+        return;
+    }
+    kernel_memset(vdso_page,0,MEM_PAGE_SIZE);
+}
+
+/**
+ * @brief 获取共享页的物理地址，用于映射到用户地址空间
+ * @return 物理地址，未分配时返回0
+ */
+uint32_t vdso_paddr(void){
+    return (uint32_t)vdso_page;
+}
+
+/**
+ * @brief 获取共享页在内核中的地址
+ * @return 共享页，未分配时返回0
+ */
+vdso_data_t* vdso_data(void){
+    return vdso_page;
+}
+
+/**
+ * @brief 开始更新共享页，seq变为奇数
+ * @note 需在关中断下调用，与vdso_write_end配对
+ */
+void vdso_write_begin(vdso_data_t* vdso){
+    vdso->seq++;
+    __asm__ __volatile__("":::"memory");
+}
+
+/**
+ * @brief 结束更新共享页，seq恢复为偶数
+ */
+void vdso_write_end(vdso_data_t* vdso){
+    __asm__ __volatile__("":::"memory");
+    vdso->seq++;
+}
+
+/**
+ * @brief 记录当前运行任务的pid，单个字的写入不需要seq保护
+ * @param pid 即将运行的任务的pid
+ */
+void vdso_set_pid(int pid){
+    if(vdso_page){
+        vdso_page->pid=pid;
+    }
+}
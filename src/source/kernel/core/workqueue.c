@@ -0,0 +1,115 @@
+#include "core/workqueue.h"
+#include "cpu/irq.h"
+#include "tools/log.h"
+
+/// @brief 系统默认的工作队列，供不需要独立线程的模块使用
+static workqueue_t system_wq;
+
+/**
+ * @brief 初始化工作项
+ * @param work 工作项
+ * @param func 工作项的处理函数
+ */
+void work_init(work_t* work,work_fn_t func){
+    list_node_init(&work->node);
+    work->func=func;
+    work->pending=0;
+}
+
+/**
+ * @brief 工作线程，依次取出并执行队列中的工作项
+ * @param arg 所属的工作队列
+ */
+static void worker_entry(void* arg){
+    workqueue_t* wq=(workqueue_t*)arg;
+
+    for(;;){
+        sem_wait(&wq->sem);
+
+        irq_state_t state=irq_enter_protection();
+        list_node_t* node=list_remove_first(&wq->work_list);
+        if(node==(list_node_t*)0){
+            // 队列为空时的唤醒只来自workqueue_destroy
+            irq_leave_protection(state);
+            if(kthread_should_stop()){
+                break;
+            }
+            continue;
+        }
+        work_t* work=list_node_parent(node,work_t,node);
+        work->pending=0;
+        irq_leave_protection(state);
+
+        work->func(work);
+    }
+}
+
+/**
+ * @brief 创建工作队列及其工作线程
+ * @param wq 工作队列
+ * @param name 工作线程的名称
+ * @return 0 成功，-1 失败
+ */
+int workqueue_create(workqueue_t* wq,const char* name){
+    list_init(&wq->work_list);
+    sem_init(&wq->sem,0);
+    wq->stopping=0;
+
+    wq->worker=kthread_create(name,worker_entry,wq);
+    if(wq->worker==(task_t*)0){
+        log_printf("create workqueue %s failed.",name);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 销毁工作队列，已加入的工作项会先执行完毕
+ * @param wq 工作队列
+ */
+void workqueue_destroy(workqueue_t* wq){
+    irq_state_t state=irq_enter_protection();
+    wq->stopping=1;
+    wq->worker->should_stop=1;
+    irq_leave_protection(state);
+
+    sem_notify(&wq->sem);
+    kthread_stop(wq->worker);
+    wq->worker=(task_t*)0;
+}
+
+/**
+ * @brief 将工作项加入工作队列，可以在中断处理函数中调用
+ * @param wq 工作队列
+ * @param work 工作项
+ * @return 1 已加入，0 工作项已在队列中或队列正在销毁
+ */
+int queue_work(workqueue_t* wq,work_t* work){
+    irq_state_t state=irq_enter_protection();
+    if(work->pending || wq->stopping){
+        irq_leave_protection(state);
+        return 0;
+    }
+    work->pending=1;
+    list_insert_last(&wq->work_list,&work->node);
+    irq_leave_protection(state);
+
+    sem_notify(&wq->sem);
+    return 1;
+}
+
+/**
+ * @brief 将工作项加入系统默认的工作队列
+ * @param work 工作项
+ * @return 1 已加入，0 工作项已在队列中
+ */
+int schedule_work(work_t* work){
+    return queue_work(&system_wq,work);
+}
+
+/**
+ * @brief 创建系统默认的工作队列
+ */
+void workqueue_init(void){
+    workqueue_create(&system_wq,"kworker");
+}
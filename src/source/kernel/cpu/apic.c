@@ -0,0 +1,473 @@
+#include "cpu/apic.h"
+#include "cpu/irq.h"
+#include "core/memory.h"
+#include "dev/clock.h"
+#include "comm/cpu_instr.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+#include "os_cfg.h"
+
+/// @brief 没有对应引脚的全局中断号
+#define APIC_NO_GSI             0xFFFFFFFF
+
+/**
+ * @brief 从ACPI或MP表中得到的中断控制器配置
+ * @param lapic_paddr LAPIC的物理地址
+ * @param ioapic_paddr IOAPIC的物理地址，只使用第一个IOAPIC，为0表示没有找到
+ * @param ioapic_id IOAPIC的编号，用于匹配MP表中的中断表项
+ * @param gsi_base 该IOAPIC第一个引脚的全局中断号
+ * @param isa_gsi ISA中断对应的全局中断号
+ * @param isa_flags ISA中断重定向表项中的极性和触发方式
+ * @param imcr 需要通过IMCR将中断从8259切换到APIC
+ */
+typedef struct _apic_config_t{
+    uint32_t lapic_paddr;
+    uint32_t ioapic_paddr;
+    uint32_t ioapic_id;
+    uint32_t gsi_base;
+    uint32_t isa_gsi[ISA_IRQ_NR];
+    uint32_t isa_flags[ISA_IRQ_NR];
+    int imcr;
+}apic_config_t;
+
+static apic_config_t apic_cfg;
+
+/// @brief 映射后的LAPIC、IOAPIC寄存器，以及BIOS数据区到ROM的区域
+static volatile uint32_t* lapic;
+static volatile uint32_t* ioapic;
+static uint8_t* bios_area;
+
+/// @brief IOAPIC的引脚数，以及ISA中断对应的引脚和重定向表项低32位的副本
+static uint32_t ioapic_pin_nr;
+static int isa_pin[ISA_IRQ_NR];
+static uint32_t isa_redir[ISA_IRQ_NR];
+
+/// @brief 是否已切换到APIC
+static int apic_on;
+
+static inline uint32_t lapic_read(uint32_t reg){
+    return lapic[reg/4];
+}
+
+static inline void lapic_write(uint32_t reg,uint32_t value){
+    lapic[reg/4]=value;
+}
+
+static inline uint32_t ioapic_read(uint32_t reg){
+    ioapic[IOAPIC_REGSEL/4]=reg;
+    return ioapic[IOAPIC_WIN/4];
+}
+
+static inline void ioapic_write(uint32_t reg,uint32_t value){
+    ioapic[IOAPIC_REGSEL/4]=reg;
+    ioapic[IOAPIC_WIN/4]=value;
+}
+
+/**
+ * @brief 计算字节和，ACPI和MP表的校验要求所有字节相加为0
+ */
+static uint8_t table_checksum(void* table,uint32_t len){
+    uint8_t sum=0;
+    uint8_t* p=(uint8_t*)table;
+    while(len--){
+        sum+=*p++;
+    }
+    return sum;
+}
+
+/**
+ * @brief 将MPS/ACPI的中断标志转换为IOAPIC重定向表项的极性和触发方式，默认为高电平边沿触发
+ */
+static uint32_t inti_to_redir(uint16_t flags){
+    uint32_t redir=0;
+    if((flags & INTI_POLARITY_MASK)==INTI_POLARITY_LOW){
+        redir|=IOAPIC_POLARITY_LOW;
+    }
+    if((flags & INTI_TRIGGER_MASK)==INTI_TRIGGER_LEVEL){
+        redir|=IOAPIC_TRIGGER_LEVEL;
+    }
+    return redir;
+}
+
+/**
+ * @brief 在BIOS区域中按16字节对齐查找带签名且校验正确的结构
+ * @param start 查找的起始物理地址
+ * @param end 查找的结束物理地址
+ * @param sig 签名
+ * @param sig_len 签名长度
+ * @param len 参与校验的长度
+ * @return 找到的结构，未找到返回0
+ */
+static void* bios_scan(uint32_t start,uint32_t end,const char* sig,int sig_len,int len){
+    if(start<MEM_EBDA_START || end>BIOS_ROM_END){
+        return (void*)0;
+    }
+    for(uint32_t addr=start;addr+len<=end;addr+=16){
+        uint8_t* p=bios_area+(addr-MEM_EBDA_START);
+        if(kernel_memcmp(p,(void*)sig,sig_len)==0 && table_checksum(p,len)==0){
+            return p;
+        }
+    }
+    return (void*)0;
+}
+
+/**
+ * @brief 依次在EBDA的第一个1KB和BIOS ROM中查找
+ */
+static void* bios_find(const char* sig,int sig_len,int len){
+    uint32_t ebda=(uint32_t)(*(uint16_t*)BDA_EBDA_SEG) << 4;
+    void* p=bios_scan(ebda,ebda+1024,sig,sig_len,len);
+    if(p==(void*)0){
+        p=bios_scan(BIOS_ROM_START,BIOS_ROM_END,sig,sig_len,len);
+    }
+    return p;
+}
+
+/**
+ * @brief 映射一张ACPI表，先映射表头得到长度，再映射整张表并校验
+ * @param paddr 表的物理地址
+ * @return 表的虚拟地址，失败返回0
+ */
+static acpi_sdt_t* acpi_map_table(uint32_t paddr){
+    acpi_sdt_t* header=(acpi_sdt_t*)memory_map_mmio(paddr,sizeof(acpi_sdt_t));
+    if(header==(acpi_sdt_t*)0){
+        return (acpi_sdt_t*)0;
+    }
+    acpi_sdt_t* table=(acpi_sdt_t*)memory_map_mmio(paddr,header->length);
+    if(table==(acpi_sdt_t*)0 || table_checksum(table,table->length)){
+        return (acpi_sdt_t*)0;
+    }
+    return table;
+}
+
+/**
+ * @brief 解析MADT，得到LAPIC、IOAPIC的地址和ISA中断的重定向
+ */
+static void acpi_parse_madt(acpi_madt_t* madt){
+    apic_cfg.lapic_paddr=madt->lapic_addr;
+
+    uint8_t* p=(uint8_t*)(madt+1);
+    uint8_t* end=(uint8_t*)madt+madt->header.length;
+    while(p+sizeof(madt_entry_t)<=end){
+        madt_entry_t* entry=(madt_entry_t*)p;
+        if(entry->length<sizeof(madt_entry_t)){
+            break;
+        }
+
+        switch(entry->type){
+            case MADT_TYPE_IOAPIC:{
+                madt_ioapic_t* io=(madt_ioapic_t*)entry;
+                if(apic_cfg.ioapic_paddr==0){
+                    apic_cfg.ioapic_paddr=io->addr;
+                    apic_cfg.ioapic_id=io->id;
+                    apic_cfg.gsi_base=io->gsi_base;
+                }
+                break;
+            }
+            case MADT_TYPE_OVERRIDE:{
+                madt_override_t* ovr=(madt_override_t*)entry;
+                if(ovr->bus==0 && ovr->source<ISA_IRQ_NR){
+                    apic_cfg.isa_gsi[ovr->source]=ovr->gsi;
+                    apic_cfg.isa_flags[ovr->source]=inti_to_redir(ovr->flags);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        p+=entry->length;
+    }
+}
+
+/**
+ * @brief 通过ACPI的RSDT查找MADT
+ * @return 0 成功，-1 没有可用的ACPI表
+ */
+static int acpi_parse(void){
+    acpi_rsdp_t* rsdp=(acpi_rsdp_t*)bios_find("RSD PTR ",8,sizeof(acpi_rsdp_t));
+    if(rsdp==(acpi_rsdp_t*)0){
+        return -1;
+    }
+
+    acpi_sdt_t* rsdt=acpi_map_table(rsdp->rsdt_addr);
+    if(rsdt==(acpi_sdt_t*)0 || kernel_memcmp(rsdt->signature,"RSDT",4)){
+        return -1;
+    }
+
+    int count=(rsdt->length-sizeof(acpi_sdt_t))/sizeof(uint32_t);
+    uint32_t* entry=(uint32_t*)(rsdt+1);
+    for(int i=0;i<count;i++){
+        acpi_sdt_t* table=acpi_map_table(entry[i]);
+        if(table && kernel_memcmp(table->signature,"APIC",4)==0){
+            acpi_parse_madt((acpi_madt_t*)table);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 解析MP配置表，ACPI不可用时的后备方案
+ * @return 0 成功，-1 没有可用的MP表
+ */
+static int mp_parse(void){
+    mp_float_t* mpf=(mp_float_t*)bios_find("_MP_",4,sizeof(mp_float_t));
+    if(mpf==(mp_float_t*)0){
+        return -1;
+    }
+    apic_cfg.imcr=(mpf->feature2 & MP_FEATURE2_IMCRP)!=0;
+
+    // 使用默认配置时没有配置表，中断按恒等方式连接到默认地址的IOAPIC
+    if(mpf->feature1 || mpf->config_addr==0){
+        apic_cfg.lapic_paddr=LAPIC_DEFAULT_ADDR;
+        apic_cfg.ioapic_paddr=IOAPIC_DEFAULT_ADDR;
+        return 0;
+    }
+
+    mp_config_t* config=(mp_config_t*)memory_map_mmio(mpf->config_addr,sizeof(mp_config_t));
+    if(config==(mp_config_t*)0){
+        return -1;
+    }
+    config=(mp_config_t*)memory_map_mmio(mpf->config_addr,config->length);
+    if(config==(mp_config_t*)0 || kernel_memcmp(config->signature,"PCMP",4)
+        || table_checksum(config,config->length)){
+        return -1;
+    }
+    apic_cfg.lapic_paddr=config->lapic_addr;
+
+    int isa_bus=-1;
+    uint8_t* p=(uint8_t*)(config+1);
+    for(int i=0;i<config->entry_count;i++){
+        switch(*p){
+            case MP_ENTRY_PROCESSOR:
+                p+=20;
+                continue;
+            case MP_ENTRY_BUS:{
+                mp_bus_t* bus=(mp_bus_t*)p;
+                if(kernel_memcmp(bus->bus_type,"ISA",3)==0){
+                    isa_bus=bus->bus_id;
+                }
+                break;
+            }
+            case MP_ENTRY_IOAPIC:{
+                mp_ioapic_t* io=(mp_ioapic_t*)p;
+                if((io->flags & 1) && apic_cfg.ioapic_paddr==0){
+                    apic_cfg.ioapic_paddr=io->addr;
+                    apic_cfg.ioapic_id=io->id;
+                }
+                break;
+            }
+            case MP_ENTRY_IOINT:{
+                mp_ioint_t* ioint=(mp_ioint_t*)p;
+                if(ioint->int_type==0 && ioint->src_bus==isa_bus && ioint->src_irq<ISA_IRQ_NR
+                    && ioint->dst_ioapic==apic_cfg.ioapic_id){
+                    apic_cfg.isa_gsi[ioint->src_irq]=ioint->dst_intin;
+                    apic_cfg.isa_flags[ioint->src_irq]=inti_to_redir(ioint->flags);
+                }
+                break;
+            }
+            case MP_ENTRY_LOCALINT:
+                break;
+            default:
+                // 未知表项无法得知长度，放弃剩余部分
+                return 0;
+        }
+        p+=8;
+    }
+    return 0;
+}
+
+/**
+ * @brief 打开LAPIC，屏蔽LINT0上的8259虚拟线，LINT1作为NMI
+ */
+static void lapic_init(void){
+    wrmsr(MSR_APIC_BASE,rdmsr(MSR_APIC_BASE) | MSR_APIC_BASE_ENABLE);
+
+    lapic_write(LAPIC_SVR,LAPIC_SVR_ENABLE | APIC_SPURIOUS_VECTOR);
+    lapic_write(LAPIC_LVT_TIMER,LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_LVT_LINT0,LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_LVT_LINT1,LAPIC_LVT_NMI);
+    lapic_write(LAPIC_LVT_ERROR,LAPIC_LVT_MASKED);
+
+    // ESR需要先写再读，连续写两次清除之前的错误
+    lapic_write(LAPIC_ESR,0);
+    lapic_write(LAPIC_ESR,0);
+    lapic_write(LAPIC_TPR,0);
+    lapic_write(LAPIC_EOI,0);
+}
+
+/**
+ * @brief 屏蔽IOAPIC的所有引脚，再按8259相同的向量号配置ISA中断，初始保持屏蔽
+ */
+static void ioapic_init(void){
+    ioapic_pin_nr=((ioapic_read(IOAPIC_REG_VER) >> 16) & 0xFF)+1;
+    for(int pin=0;pin<ioapic_pin_nr;pin++){
+        ioapic_write(IOAPIC_REG_REDTBL+pin*2,IOAPIC_MASKED);
+        ioapic_write(IOAPIC_REG_REDTBL+pin*2+1,0);
+    }
+
+    uint32_t dest=lapic_read(LAPIC_ID) >> 24;
+    for(int irq=0;irq<ISA_IRQ_NR;irq++){
+        uint32_t gsi=apic_cfg.isa_gsi[irq];
+        if(gsi==APIC_NO_GSI || gsi<apic_cfg.gsi_base || gsi-apic_cfg.gsi_base>=ioapic_pin_nr){
+            isa_pin[irq]=-1;
+            continue;
+        }
+
+        int pin=gsi-apic_cfg.gsi_base;
+        isa_pin[irq]=pin;
+        isa_redir[irq]=(IRQ_PIC_START+irq) | apic_cfg.isa_flags[irq] | IOAPIC_MASKED;
+        ioapic_write(IOAPIC_REG_REDTBL+pin*2+1,dest << 24);
+        ioapic_write(IOAPIC_REG_REDTBL+pin*2,isa_redir[irq]);
+    }
+}
+
+/**
+ * @brief 查找ACPI或MP表并切换到LAPIC和IOAPIC，找不到时继续使用8259
+ * @note 需在分页和内存分配初始化之后、任何设备打开中断之前调用
+ */
+void apic_init(void){
+    apic_on=0;
+
+    uint32_t eax,ebx,ecx,edx;
+    cpuid(1,&eax,&ebx,&ecx,&edx);
+    if(!OS_USE_APIC || !(edx & CPUID_EDX_APIC)){
+        log_printf("APIC not used, fall back to 8259.");
+        return;
+    }
+
+    kernel_memset(&apic_cfg,0,sizeof(apic_cfg));
+    for(int irq=0;irq<ISA_IRQ_NR;irq++){
+        apic_cfg.isa_gsi[irq]=irq;
+    }
+
+    bios_area=(uint8_t*)memory_map_mmio(MEM_EBDA_START,BIOS_ROM_END-MEM_EBDA_START);
+    if(bios_area==(uint8_t*)0){
+        return;
+    }
+    if(acpi_parse()<0 && mp_parse()<0){
+        log_printf("no ACPI/MP table, fall back to 8259.");
+        return;
+    }
+    if(apic_cfg.ioapic_paddr==0){
+        log_printf("no IOAPIC found, fall back to 8259.");
+        return;
+    }
+
+    // 被其他ISA中断重定向占用的引脚不再按恒等方式分配
+    for(int irq=0;irq<ISA_IRQ_NR;irq++){
+        uint32_t gsi=apic_cfg.isa_gsi[irq];
+        if(gsi!=irq && gsi<ISA_IRQ_NR && apic_cfg.isa_gsi[gsi]==gsi){
+            apic_cfg.isa_gsi[gsi]=APIC_NO_GSI;
+        }
+    }
+
+    lapic=(volatile uint32_t*)memory_map_mmio(apic_cfg.lapic_paddr,MEM_PAGE_SIZE);
+    ioapic=(volatile uint32_t*)memory_map_mmio(apic_cfg.ioapic_paddr,MEM_PAGE_SIZE);
+    if(lapic==(volatile uint32_t*)0 || ioapic==(volatile uint32_t*)0){
+        return;
+    }
+
+    irq_state_t state=irq_enter_protection();
+
+    // 8259保持初始化后的向量设置，但屏蔽全部中断
+    outb(PIC0_IMR,0xFF);
+    outb(PIC1_IMR,0xFF);
+    if(apic_cfg.imcr){
+        outb(IMCR_ADDR_PORT,IMCR_SELECT);
+        outb(IMCR_DATA_PORT,IMCR_APIC);
+    }
+
+    irq_install(APIC_SPURIOUS_VECTOR,(irq_handler_t)exception_handler_spurious);
+    lapic_init();
+    ioapic_init();
+    apic_on=1;
+
+    irq_leave_protection(state);
+
+    log_printf("APIC: lapic 0x%x, ioapic 0x%x with %d pins.",
+        apic_cfg.lapic_paddr,apic_cfg.ioapic_paddr,ioapic_pin_nr);
+}
+
+/**
+ * @brief 是否已切换到APIC
+ * @return 1 使用APIC，0 使用8259
+ */
+int apic_active(void){
+    return apic_on;
+}
+
+/**
+ * @brief 向LAPIC发送中断结束，只需一次MMIO写
+ */
+void lapic_eoi(void){
+    lapic_write(LAPIC_EOI,0);
+}
+
+/**
+ * @brief 打开ISA中断在IOAPIC上对应的引脚
+ * @param irq ISA中断号0-15
+ */
+void ioapic_enable_irq(int irq){
+    if(irq<0 || irq>=ISA_IRQ_NR || isa_pin[irq]<0){
+        return;
+    }
+    irq_state_t state=irq_enter_protection();
+    isa_redir[irq]&=~IOAPIC_MASKED;
+    ioapic_write(IOAPIC_REG_REDTBL+isa_pin[irq]*2,isa_redir[irq]);
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief 屏蔽ISA中断在IOAPIC上对应的引脚
+ * @param irq ISA中断号0-15
+ */
+void ioapic_disable_irq(int irq){
+    if(irq<0 || irq>=ISA_IRQ_NR || isa_pin[irq]<0){
+        return;
+    }
+    irq_state_t state=irq_enter_protection();
+    isa_redir[irq]|=IOAPIC_MASKED;
+    ioapic_write(IOAPIC_REG_REDTBL+isa_pin[irq]*2,isa_redir[irq]);
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief 以TSC为基准校准LAPIC定时器，并将其设为周期模式作为时钟中断源
+ * @param vector 定时器中断的向量号
+ * @param ms 中断周期，单位毫秒
+ * @return 0 成功，-1 没有APIC或TSC不可用，需使用PIT
+ */
+int lapic_timer_init(int vector,uint32_t ms){
+    uint32_t khz=clock_tsc_khz();
+    if(!OS_LAPIC_TIMER || !apic_on || khz==0){
+        return -1;
+    }
+
+    lapic_write(LAPIC_TIMER_DIV,LAPIC_TIMER_DIV16);
+    lapic_write(LAPIC_LVT_TIMER,LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_TIMER_INIT,0xFFFFFFFF);
+
+    uint64_t end=rdtsc()+(uint64_t)khz*LAPIC_CALIBRATE_MS;
+    while(rdtsc()<end){
+        cpu_relax();
+    }
+    uint32_t elapsed=0xFFFFFFFF-lapic_read(LAPIC_TIMER_CURR);
+    lapic_write(LAPIC_TIMER_INIT,0);
+
+    uint32_t count=elapsed/LAPIC_CALIBRATE_MS*ms;
+    if(count==0){
+        return -1;
+    }
+
+    lapic_write(LAPIC_LVT_TIMER,vector | LAPIC_TIMER_PERIODIC);
+    lapic_write(LAPIC_TIMER_INIT,count);
+    log_printf("LAPIC timer: %d counts per tick.",count);
+    return 0;
+}
+
+/**
+ * @brief LAPIC伪中断，不需要发送EOI
+ */
+void do_handler_spurious(exception_frame_t* frame){
+}
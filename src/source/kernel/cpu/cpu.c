@@ -9,6 +9,12 @@ static segment_desc_t gdt_table[GDT_TABLE_SIZE];
 /// @brief 互斥锁
 static mutex_t mutex;
 
+/// @brief 可能空闲的最小表项索引，分配时从这里开始查找
+static int gdt_free_hint=1;
+
+/// @brief CPU是否支持SYSENTER/SYSEXIT
+static int sysenter_supported;
+
 /**
  * @brief 设置gdt表项
  * @param selector gdt表的索引
@@ -45,6 +51,14 @@ void init_gdt(void){
     segment_desc_set(KERNEL_SELECTOR_CS, 0x00000000, 0xFFFFFFFF,
         SEG_P_PRESENT | SEG_DPL0 | SEG_S_NORMAL | SEG_TYPE_CODE
         | SEG_TYPE_RW | SEG_D | SEG_G);
+
+    // 这里虽然设置的代码段和数据段范围还是0x0-0xFFFFFFFF，但使用该段的段选择子访问的方式为特权级3
+    segment_desc_set(APP_SELECTOR_CS,0x0,0xFFFFFFFF,
+        SEG_P_PRESENT | SEG_DPL3 | SEG_S_NORMAL | SEG_TYPE_CODE | SEG_TYPE_RW | SEG_D
+    );
+    segment_desc_set(APP_SELECTOR_DS,0x0,0xFFFFFFFF,
+        SEG_P_PRESENT | SEG_DPL3 | SEG_S_NORMAL | SEG_TYPE_DATA | SEG_TYPE_RW | SEG_D
+    );
     gate_desc_set((gate_desc_t*)(gdt_table+(SELECTOR_SYSCALL >> 3)),
         KERNEL_SELECTOR_CS,(uint32_t)exception_handler_syscall,
         GATE_P_PRESENT | GATE_DPL3 | GATE_TYPE_SYSCALL | SYSCALL_PARAM_COUNT
@@ -60,6 +74,38 @@ void gate_desc_set(gate_desc_t* desc,uint16_t selector,uint32_t offset,uint16_t
     desc->offset31_16=(offset>>16)&0xFFFF;
 }
 
+/**
+ * @brief 设置SYSENTER的入口，内核栈在每次任务切换时更新
+ * @note 早期的Pentium Pro虽然报告SEP位但并不支持该指令
+ */
+static void sysenter_init(void){
+    uint32_t eax,ebx,ecx,edx;
+    cpuid(1,&eax,&ebx,&ecx,&edx);
+
+    uint32_t family=(eax >> 8) & 0xF;
+    uint32_t model=(eax >> 4) & 0xF;
+    uint32_t stepping=eax & 0xF;
+    if(!(edx & CPUID_EDX_SEP) || (family==6 && model<3 && stepping<3)){
+        sysenter_supported=0;
+        return;
+    }
+
+    wrmsr(MSR_SYSENTER_CS,KERNEL_SELECTOR_CS);
+    wrmsr(MSR_SYSENTER_ESP,0);
+    wrmsr(MSR_SYSENTER_EIP,(uint32_t)exception_handler_sysenter);
+    sysenter_supported=1;
+}
+
+/**
+ * @brief 设置SYSENTER进入内核后使用的栈，需与当前任务TSS中的esp0一致
+ * @param esp0 当前任务的内核栈顶
+ */
+void cpu_set_sysenter_stack(uint32_t esp0){
+    if(sysenter_supported){
+        wrmsr(MSR_SYSENTER_ESP,esp0);
+    }
+}
+
 /**
  * @brief 初始化mutex锁以及gdt表
  * @return void
@@ -67,6 +113,7 @@ void gate_desc_set(gate_desc_t* desc,uint16_t selector,uint32_t offset,uint16_t
 void cpu_init(void){
     mutex_init(&mutex);
     init_gdt();
+    sysenter_init();
 }
 
 /**
@@ -75,9 +122,12 @@ void cpu_init(void){
 */
 int gdt_alloc_desc(){
     mutex_lock(&mutex);
-    for(int i=1;i<GDT_TABLE_SIZE;i++){
+    for(int i=gdt_free_hint;i<GDT_TABLE_SIZE;i++){
         segment_desc_t* desc=gdt_table+i;
         if(desc->attr==0){
+            // 先占用该表项，防止在调用者设置之前被重复分配
+            desc->attr=SEG_P_PRESENT;
+            gdt_free_hint=i+1;
             mutex_unlock(&mutex);
             return i*sizeof(segment_desc_t);
         }
@@ -92,6 +142,10 @@ void switch_to_tss(int tss_sel){
 
 void gdt_free_sel(int sel){
     mutex_lock(&mutex);
-    gdt_table[sel/sizeof(segment_desc_set)].attr=0;
+    int index=sel/sizeof(segment_desc_t);
+    gdt_table[index].attr=0;
+    if(index<gdt_free_hint){
+        gdt_free_hint=index;
+    }
     mutex_unlock(&mutex);
 }
\ No newline at end of file
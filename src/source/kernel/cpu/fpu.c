@@ -0,0 +1,205 @@
+#include "cpu/fpu.h"
+#include "core/memory.h"
+#include "comm/cpu_instr.h"
+#include "tools/log.h"
+
+/// @brief 当前浮点寄存器中保存的是哪个任务的状态
+static task_t* fpu_owner;
+
+/// @brief 处理器是否支持FXSAVE/FXRSTOR，不支持时使用FNSAVE/FRSTOR
+static int fpu_has_fxsr;
+
+/// @brief 空闲的浮点状态保存区，从整页中切分，保证16字节对齐
+static list_t fpu_free_list;
+
+/**
+ * @brief 分配一个浮点状态保存区
+ * @return 保存区的地址，失败返回0
+ */
+static void* fpu_state_alloc(void){
+    irq_state_t state=irq_enter_protection();
+    list_node_t* node=list_remove_first(&fpu_free_list);
+    irq_leave_protection(state);
+
+    if(node==(list_node_t*)0){
+        uint32_t page=memory_alloc_page();
+        if(page==0){
+            return (void*)0;
+        }
+
+        state=irq_enter_protection();
+        for(uint32_t offset=FPU_STATE_SIZE;offset<MEM_PAGE_SIZE;offset+=FPU_STATE_SIZE){
+            list_insert_last(&fpu_free_list,(list_node_t*)(page+offset));
+        }
+        irq_leave_protection(state);
+
+        node=(list_node_t*)page;
+    }
+
+    return (void*)node;
+}
+
+/**
+ * @brief 释放浮点状态保存区
+ * @param fpu_state 保存区的地址
+ */
+static void fpu_state_free(void* fpu_state){
+    irq_state_t state=irq_enter_protection();
+    list_insert_first(&fpu_free_list,(list_node_t*)fpu_state);
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief 将浮点寄存器保存到内存中
+ * @param fpu_state 保存区的地址
+ */
+static void fpu_save(void* fpu_state){
+    if(fpu_has_fxsr){
+        __asm__ __volatile__("fxsave (%0)"::"r"(fpu_state):"memory");
+    }
+    else{
+        __asm__ __volatile__("fnsave (%0)"::"r"(fpu_state):"memory");
+    }
+}
+
+/**
+ * @brief 从内存中恢复浮点寄存器
+ * @param fpu_state 保存区的地址
+ */
+static void fpu_restore(void* fpu_state){
+    if(fpu_has_fxsr){
+        __asm__ __volatile__("fxrstor (%0)"::"r"(fpu_state):"memory");
+    }
+    else{
+        __asm__ __volatile__("frstor (%0)"::"r"(fpu_state):"memory");
+    }
+}
+
+/**
+ * @brief 初始化浮点单元并打开SSE支持
+ *        硬件任务切换时处理器会自动设置TS位，任务第一次使用浮点指令时
+ *        产生#NM异常，此时才保存上一个任务的浮点状态并恢复当前任务的状态
+ */
+void fpu_init(void){
+    list_init(&fpu_free_list);
+    fpu_owner=(task_t*)0;
+
+    uint32_t eax,ebx,ecx,edx;
+    cpuid(1,&eax,&ebx,&ecx,&edx);
+    if(!(edx & CPUID_EDX_FPU)){
+        log_printf("no fpu found.");
+        return;
+    }
+
+    uint32_t cr0=read_cr0();
+    cr0&=~CR0_EM;
+    cr0|=CR0_MP | CR0_NE;
+    write_cr0(cr0);
+
+    fpu_has_fxsr=(edx & CPUID_EDX_FXSR) ? 1 : 0;
+    if(fpu_has_fxsr && (edx & CPUID_EDX_SSE)){
+        write_cr4(read_cr4() | CR4_OSFXSR | CR4_OSXMMEXCPT);
+    }
+
+    __asm__ __volatile__("fninit");
+
+    // 设置TS位，第一个使用浮点指令的任务也走#NM的流程
+    write_cr0(read_cr0() | CR0_TS);
+}
+
+/**
+ * @brief #NM异常的处理，切换浮点寄存器的所有者
+ * @return 成功返回0，无法为当前任务分配浮点状态时返回-1，此时TS位保持置位
+ */
+int fpu_device_unavailable(void){
+    clts();
+
+    task_t* curr=task_current();
+    if(fpu_owner==curr){
+        return 0;
+    }
+
+    if(fpu_owner){
+        fpu_save(fpu_owner->fpu_state);
+    }
+
+    if(curr->fpu_state==(void*)0){
+        curr->fpu_state=fpu_state_alloc();
+        if(curr->fpu_state==(void*)0){
+            // 没有保存的位置，不能让任务继续使用浮点单元
+            log_printf("task %s: alloc fpu state failed.",curr->name);
+            fpu_owner=(task_t*)0;
+            write_cr0(read_cr0() | CR0_TS);
+            return -1;
+        }
+
+        // 第一次使用浮点单元的任务从初始状态开始
+        __asm__ __volatile__("fninit");
+        if(fpu_has_fxsr){
+            uint32_t mxcsr=MXCSR_DEFAULT;
+            if(read_cr4() & CR4_OSFXSR){
+                __asm__ __volatile__("ldmxcsr %0"::"m"(mxcsr));
+            }
+        }
+    }
+    else{
+        fpu_restore(curr->fpu_state);
+    }
+
+    fpu_owner=curr;
+    return 0;
+}
+
+/**
+ * @brief 复制任务的浮点状态，用于fork
+ * @param to 新的任务
+ * @param from 被复制的任务
+ * @return 0 成功，-1 失败
+ */
+int fpu_copy(task_t* to,task_t* from){
+    if(from->fpu_state==(void*)0){
+        return 0;
+    }
+
+    to->fpu_state=fpu_state_alloc();
+    if(to->fpu_state==(void*)0){
+        return -1;
+    }
+
+    irq_state_t state=irq_enter_protection();
+    if(fpu_owner==from){
+        // 最新的状态还在寄存器中，先写回内存
+        clts();
+        fpu_save(from->fpu_state);
+        if(!fpu_has_fxsr){
+            // FNSAVE会重新初始化浮点单元，需要恢复
+            fpu_restore(from->fpu_state);
+        }
+    }
+    kernel_memcpy(to->fpu_state,from->fpu_state,FPU_STATE_SIZE);
+    irq_leave_protection(state);
+
+    return 0;
+}
+
+/**
+ * @brief 丢弃任务的浮点状态，用于任务退出和加载新程序
+ * @param task 需要释放的任务
+ */
+void fpu_release(task_t* task){
+    irq_state_t state=irq_enter_protection();
+    if(fpu_owner==task){
+        fpu_owner=(task_t*)0;
+
+        // 寄存器中的状态已作废，下次使用浮点指令时重新初始化
+        if(task==task_current()){
+            write_cr0(read_cr0() | CR0_TS);
+        }
+    }
+    irq_leave_protection(state);
+
+    if(task->fpu_state){
+        fpu_state_free(task->fpu_state);
+        task->fpu_state=(void*)0;
+    }
+}
\ No newline at end of file
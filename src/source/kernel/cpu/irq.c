@@ -1,5 +1,36 @@
 #include "cpu/irq.h"
 #include "core/task.h"
+#include "cpu/fpu.h"
+#include "dev/clock.h"
+#include "cpu/apic.h"
+#include "core/memory.h"
+
+/**
+ * @brief 关中断区间的内部统计，时间以时钟周期记录，读取时再换算
+ * @param enter_ip 关中断的调用位置
+ * @param leave_ip 开中断的调用位置
+ * @param max 最长的时钟周期数
+ * @param count 进入统计的次数
+ */
+typedef struct _irqoff_site_t{
+    uint32_t enter_ip;
+    uint32_t leave_ip;
+    uint64_t max;
+    uint32_t count;
+}irqoff_site_t;
+
+/// @brief 统计是否开启，关闭时关中断和开中断只多一次判断
+static int irqoff_enabled;
+
+/// @brief 当前关中断区间的开始时间和位置，start为0表示没有在统计的区间
+static uint64_t irqoff_start;
+static uint32_t irqoff_ip;
+
+/// @brief 按调用位置记录的最长关中断区间，以及全部区间的汇总
+static irqoff_site_t irqoff_sites[IRQOFF_TOP_NR];
+static uint32_t irqoff_count;
+static uint64_t irqoff_total;
+static uint64_t irqoff_max;
 
 // 初始化8259，开启中断
 static void init_pic(void){
@@ -17,13 +48,15 @@ static void init_pic(void){
 	outb(PIC1_IMR, 0xFF);
 }
 
-// 关中断
+// 关中断，直接开关中断的区间同样计入关中断统计
 void irq_disable_global(void){
 	cli();
+	irqoff_trace_begin((uint32_t)__builtin_return_address(0));
 }
 
 // 开中断
 void irq_enable_global(void){
+	irqoff_trace_end((uint32_t)__builtin_return_address(0));
 	sti();
 }
 
@@ -33,6 +66,10 @@ void irq_enable(int irq_num){
 		return;
 	}
 	irq_num-=IRQ_PIC_START;
+	if(apic_active()){
+		ioapic_enable_irq(irq_num);
+		return;
+	}
 	if(irq_num<8){
 		uint8_t mask=inb(PIC0_IMR) & ~(1<<irq_num);
 		outb(PIC0_IMR,mask);
@@ -50,6 +87,10 @@ void irq_disable(int irq_num){
 		return;
 	}
 	irq_num-=IRQ_PIC_START;
+	if(apic_active()){
+		ioapic_disable_irq(irq_num);
+		return;
+	}
 	if(irq_num<8){
 		uint8_t mask=inb(PIC0_IMR) | (1<<irq_num);
 		outb(PIC0_IMR,mask);
@@ -175,7 +216,21 @@ void do_handler_invalid_opcode(exception_frame_t * frame) {
 }
 
 void do_handler_device_unavailable(exception_frame_t * frame) {
-	do_default_handler(frame, "Device Not Available.");
+	if(fpu_device_unavailable()==0){
+		return;
+	}
+
+	// 浮点状态无处保存，用户态任务直接结束，内核态则陷入死循环
+	log_printf("IRQ/Exception happend: Device Not Available.");
+	dump_core_regs(frame);
+	if(frame->cs & 0x3){
+		sys_exit(-1);
+	}
+	else{
+		while (1) {
+			hlt();
+		}
+	}
 }
 
 void do_handler_double_fault(exception_frame_t * frame) {
@@ -276,6 +331,10 @@ void do_handler_virtual_exception(exception_frame_t * frame) {
 }
 
 void pic_send_eoi(int irq_num){
+	if(apic_active()){
+		lapic_eoi();
+		return;
+	}
 	irq_num-=IRQ_PIC_START;
 	if(irq_num >=8){
 		outb(PIC1_OCW2,PIC_OCW2_EOI);
@@ -289,7 +348,12 @@ void pic_send_eoi(int irq_num){
  */
 irq_state_t irq_enter_protection(void){
 	irq_state_t state=read_eflags();
-	irq_disable_global();
+	cli();
+
+	// 只统计最外层的关中断，已关中断时进入的临界区属于外层的区间，如中断入口开始的区间
+	if(state & EFLAGS_IF){
+		irqoff_trace_begin((uint32_t)__builtin_return_address(0));
+	}
 	return state;
 	
 }
@@ -299,6 +363,133 @@ irq_state_t irq_enter_protection(void){
  * @param state 进入临界区时的状态
  */
 void irq_leave_protection(irq_state_t state){
+	if(state & EFLAGS_IF){
+		irqoff_trace_end((uint32_t)__builtin_return_address(0));
+	}
 	write_eflags(state);
 }
 
+/**
+ * @brief 开始记录一段关中断区间
+ * @param ip 关中断的调用位置
+ * @note 需要在关中断后调用，已有正在统计的区间时不重新开始
+ */
+void irqoff_trace_begin(uint32_t ip){
+	if(!irqoff_enabled || irqoff_start){
+		return;
+	}
+
+	irqoff_start=rdtsc();
+	irqoff_ip=ip;
+}
+
+/**
+ * @brief 结束当前的关中断区间，按调用位置更新最长区间表
+ * @param ip 开中断的调用位置
+ * @note 需要在开中断前调用
+ */
+void irqoff_trace_end(uint32_t ip){
+	if(irqoff_start==0){
+		return;
+	}
+
+	uint64_t cycles=rdtsc()-irqoff_start;
+	irqoff_start=0;
+
+	irqoff_count++;
+	irqoff_total+=cycles;
+	if(cycles>irqoff_max){
+		irqoff_max=cycles;
+	}
+
+	// 同一对调用位置只占一项，表满时替换最短的一项
+	irqoff_site_t* min=irqoff_sites;
+	for(int i=0;i<IRQOFF_TOP_NR;i++){
+		irqoff_site_t* site=irqoff_sites+i;
+		if((site->enter_ip==irqoff_ip) && (site->leave_ip==ip)){
+			site->count++;
+			if(cycles>site->max){
+				site->max=cycles;
+			}
+			return;
+		}
+
+		if(site->max<min->max){
+			min=site;
+		}
+	}
+
+	if(cycles>min->max){
+		min->enter_ip=irqoff_ip;
+		min->leave_ip=ip;
+		min->max=cycles;
+		min->count=1;
+	}
+}
+
+/**
+ * @brief 获取关中断时间的统计，最长的区间按时间从大到小排列
+ * @param info 保存统计结果，可以为0
+ * @param flags IRQOFF_RESET清除统计，IRQOFF_ENABLE开启统计，IRQOFF_DISABLE关闭统计
+ * @return 成功返回0，失败返回-1
+ */
+int sys_irqoff_trace(irqoff_info_t* info,int flags){
+	irqoff_site_t sites[IRQOFF_TOP_NR];
+	if(memory_check_user(info,sizeof(irqoff_info_t),1)<0){
+		return -1;
+	}
+
+	irq_state_t state=irq_enter_protection();
+	kernel_memcpy(sites,irqoff_sites,sizeof(sites));
+	uint32_t count=irqoff_count;
+	uint64_t total=irqoff_total;
+	uint64_t max=irqoff_max;
+	if(flags & IRQOFF_RESET){
+		kernel_memset(irqoff_sites,0,sizeof(irqoff_sites));
+		irqoff_count=0;
+		irqoff_total=0;
+		irqoff_max=0;
+	}
+	if(flags & IRQOFF_ENABLE){
+		irqoff_enabled=1;
+	}else if(flags & IRQOFF_DISABLE){
+		irqoff_enabled=0;
+		irqoff_start=0;
+	}
+	int enabled=irqoff_enabled;
+	irq_leave_protection(state);
+
+	if(info==(irqoff_info_t*)0){
+		return 0;
+	}
+
+	kernel_memset(info,0,sizeof(irqoff_info_t));
+	info->count=count;
+	info->enabled=enabled;
+	info->max_ns=(uint32_t)clock_cycles_to_ns(max);
+	if(count){
+		info->avg_ns=(uint32_t)clock_cycles_to_ns(div_u64_rem(total,count,(uint32_t*)0));
+	}
+
+	// 选择排序，表项很少
+	for(int i=0;i<IRQOFF_TOP_NR;i++){
+		int best=-1;
+		for(int j=0;j<IRQOFF_TOP_NR;j++){
+			if(sites[j].count && ((best<0) || (sites[j].max>sites[best].max))){
+				best=j;
+			}
+		}
+		if(best<0){
+			break;
+		}
+
+		irqoff_span_t* span=info->spans+info->nr++;
+		span->enter_ip=sites[best].enter_ip;
+		span->leave_ip=sites[best].leave_ip;
+		span->max_ns=(uint32_t)clock_cycles_to_ns(sites[best].max);
+		span->count=sites[best].count;
+		sites[best].count=0;
+	}
+	return 0;
+}
+
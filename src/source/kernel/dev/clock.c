@@ -0,0 +1,184 @@
+#include "dev/clock.h"
+#include "dev/time.h"
+#include "dev/rtc.h"
+#include "comm/cpu_instr.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+#include "core/vdso.h"
+#include "core/memory.h"
+
+/// @brief 系统唯一的时钟源
+static clocksource_t clocksource;
+
+static void clock_update_vdso(void);
+
+/**
+ * @brief 用PIT通道2计时CLOCK_CALIBRATE_MS毫秒，测量TSC的频率
+ * @return TSC的频率，单位kHz
+ */
+static uint32_t tsc_calibrate(void){
+    uint32_t latch=PIT_OSC_FREQ/(1000/CLOCK_CALIBRATE_MS);
+
+    // 打开通道2的门控，关闭扬声器
+    uint8_t gate=inb(PIT_GATE_PORT);
+    outb(PIT_GATE_PORT,(gate & ~PIT_SPEAKER_ENABLE) | PIT_GATE2_ENABLE);
+
+    // 模式0：计数到0时输出变为高电平
+    outb(PIT_COMMAND_MODE_PORT,PIT_CHANNEL2 | PIT_LOAD_LOHI | PIT_MODE0);
+    outb(PIT_CHANNEL2_DATA_PORT,latch & 0xFF);
+    outb(PIT_CHANNEL2_DATA_PORT,(latch >> 8) & 0xFF);
+
+    uint64_t start=rdtsc();
+    while(!(inb(PIT_GATE_PORT) & PIT_OUT2_HIGH)){
+    }
+    uint64_t end=rdtsc();
+
+    outb(PIT_GATE_PORT,gate);
+
+    // CLOCK_CALIBRATE_MS毫秒内的周期数不会超过32位
+    return (uint32_t)(end-start)/CLOCK_CALIBRATE_MS;
+}
+
+/**
+ * @brief 初始化时钟源：校准TSC并读取RTC的墙上时间
+ */
+void clock_init(void){
+    kernel_memset(&clocksource,0,sizeof(clocksource_t));
+    clocksource.name="jiffies";
+
+    uint32_t eax,ebx,ecx,edx;
+    cpuid(1,&eax,&ebx,&ecx,&edx);
+    if(edx & CPUID_EDX_TSC){
+        uint32_t khz=tsc_calibrate();
+        if(khz>0){
+            clocksource.name="tsc";
+            clocksource.khz=khz;
+            clocksource.shift=CLOCK_SHIFT;
+            clocksource.mult=(uint32_t)div_u64_rem((uint64_t)NSEC_PER_MSEC << CLOCK_SHIFT,khz,(uint32_t*)0);
+            clocksource.cycle_last=rdtsc();
+        }
+    }
+
+    clocksource.boot_sec=rtc_get_epoch();
+    clock_update_vdso();
+    log_printf("clocksource: %s, %d kHz, boot time: %d",
+        clocksource.name,clocksource.khz,clocksource.boot_sec);
+}
+
+/**
+ * @brief 将TSC周期数转换为纳秒
+ * @param cycles 周期数
+ * @return 纳秒数，没有TSC时返回0
+ * @note 分成高低两部分相乘，cycles*mult直接相乘在开机约73分钟后就会溢出64位
+ */
+uint64_t clock_cycles_to_ns(uint64_t cycles){
+    uint32_t shift=clocksource.shift;
+    uint64_t low=cycles & ((1ULL << shift)-1);
+    return (cycles >> shift)*clocksource.mult+((low*clocksource.mult) >> shift);
+}
+
+/**
+ * @brief 获取TSC的频率
+ * @return 频率，单位kHz，没有TSC时返回0
+ */
+uint32_t clock_tsc_khz(void){
+    return clocksource.khz;
+}
+
+/**
+ * @brief 将时钟源的参数和当前值同步到共享页，用户态据此直接计算时间
+ */
+static void clock_update_vdso(void){
+    vdso_data_t* vdso=vdso_data();
+    if(vdso==(vdso_data_t*)0){
+        return;
+    }
+
+    vdso_write_begin(vdso);
+    vdso->tick=time_get_tick();
+    vdso->tick_ms=OS_TICK_MS;
+    vdso->khz=clocksource.khz;
+    vdso->mult=clocksource.mult;
+    vdso->shift=clocksource.shift;
+    vdso->cycle_last=clocksource.cycle_last;
+    vdso->mono_ns=clocksource.mono_ns;
+    vdso->boot_sec=clocksource.boot_sec;
+    vdso_write_end(vdso);
+}
+
+/**
+ * @brief 在时钟中断中累加单调时间，避免长时间的周期数相乘溢出
+ */
+void clock_tick(void){
+    if(clocksource.khz==0){
+        clocksource.mono_ns+=OS_TICK_MS*NSEC_PER_MSEC;
+    }
+    else{
+        uint64_t now=rdtsc();
+        clocksource.mono_ns+=clock_cycles_to_ns(now-clocksource.cycle_last);
+        clocksource.cycle_last=now;
+    }
+    clock_update_vdso();
+}
+
+/**
+ * @brief 读取启动以来的单调时间
+ * @return 纳秒数
+ */
+uint64_t clock_monotonic_ns(void){
+    irq_state_t state=irq_enter_protection();
+    uint64_t ns=clocksource.mono_ns;
+    if(clocksource.khz){
+        ns+=clock_cycles_to_ns(rdtsc()-clocksource.cycle_last);
+    }
+    irq_leave_protection(state);
+    return ns;
+}
+
+/**
+ * @brief 获取指定时钟的时间
+ * @param clk_id CLOCK_MONOTONIC或CLOCK_REALTIME
+ * @param ts 存放读取的时间
+ * @return 0 成功，-1 失败
+ */
+int sys_clock_gettime(int clk_id,struct timespec* ts){
+    if((ts==(struct timespec*)0) || (memory_check_user(ts,sizeof(struct timespec),1)<0)){
+        return -1;
+    }
+
+    uint64_t ns=clock_monotonic_ns();
+    uint32_t nsec;
+    uint64_t sec=div_u64_rem(ns,NSEC_PER_SEC,&nsec);
+
+    switch(clk_id){
+        case CLOCK_MONOTONIC:
+            break;
+        case CLOCK_REALTIME:
+            sec+=clocksource.boot_sec;
+            break;
+        default:
+            return -1;
+    }
+
+    ts->tv_sec=sec;
+    ts->tv_nsec=nsec;
+    return 0;
+}
+
+/**
+ * @brief 获取墙上时间，精度为微秒
+ * @param tv 存放读取的时间
+ * @param tz 不支持时区，忽略
+ * @return 0 成功，-1 失败
+ */
+int sys_gettimeofday(struct timeval* tv,void* tz){
+    if((tv==(struct timeval*)0) || (memory_check_user(tv,sizeof(struct timeval),1)<0)){
+        return -1;
+    }
+
+    struct timespec ts;
+    sys_clock_gettime(CLOCK_REALTIME,&ts);
+    tv->tv_sec=ts.tv_sec;
+    tv->tv_usec=ts.tv_nsec/NSEC_PER_USEC;
+    return 0;
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "dev/dev.h"
 #include "cpu/irq.h"
+#include "applib/lib_syscall.h"
 
 #define DEV_TABLE_SIZE         128
 
@@ -106,6 +107,24 @@ int dev_control(int dev_id,int cmd,int arg0,int arg1){
     return dev->desc->control(dev,cmd,arg0,arg1);
 }
 
+/**
+ * @brief 查询设备的读写状态
+ * @param dev_id 设备id
+ * @param table poll表，为0时只查询不等待
+ * @return POLLIN、POLLOUT等标志的组合
+ */
+int dev_poll(int dev_id,struct _poll_table_t* table){
+    if(is_devid_bad(dev_id)){
+        return POLLNVAL;
+    }
+
+    device_t* dev=dev_tb+dev_id;
+    if(dev->desc->poll==0){
+        return POLLIN | POLLOUT;
+    }
+    return dev->desc->poll(dev,table);
+}
+
 void dev_close(int dev_id){
     if(is_devid_bad(dev_id)){
         return;
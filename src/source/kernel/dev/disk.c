@@ -4,10 +4,13 @@
 #include "comm/cpu_instr.h"
 #include "comm/boot_info.h"
 #include "dev/dev.h"
+#include "core/softirq.h"
 
 
 static mutex_t disk_mutex;
 static sem_t op_sem;
+static tasklet_t disk_tasklet;
+static void disk_tasklet_func(tasklet_t* tasklet);
 
 /// @brief 有进程引起磁盘中断的标志位
 static int task_on_op=0;
@@ -189,6 +192,7 @@ void disk_init(void){
 
     mutex_init(&disk_mutex);
     sem_init(&op_sem,0);
+    tasklet_init(&disk_tasklet,disk_tasklet_func);
 
     kernel_memset(disk_buf,0,sizeof(disk_buf));
     for(int i=0;i<DISK_CNT;i++){
@@ -337,11 +341,19 @@ void disk_close(device_t* dev){
 
 }
 
+/**
+ * @brief 磁盘的下半部，唤醒等待磁盘操作完成的任务
+ * @param tasklet 未使用
+ */
+static void disk_tasklet_func(tasklet_t* tasklet){
+    sem_notify(&op_sem);
+}
+
 void do_handler_ide_primary(exception_frame_t* frame){
     pic_send_eoi(IRQ14_HARDDISK_PRIMARY);
 
     if(task_on_op && task_current()){
-       sem_notify(&op_sem); 
+        tasklet_schedule(&disk_tasklet);
     }
 }
 
@@ -4,9 +4,17 @@
 #include "tools/log.h"
 #include "tools/klib.h"
 #include "dev/tty.h"
+#include "core/softirq.h"
 
 static kbd_state_t kbd_stat;
 
+/// @brief 中断处理函数读出的扫描码，由kbd_tasklet解析
+static uint8_t kbd_buf[KBD_BUF_SIZE];
+static volatile uint32_t kbd_buf_read;
+static volatile uint32_t kbd_buf_write;
+static tasklet_t kbd_tasklet;
+static void kbd_tasklet_func(tasklet_t* tasklet);
+
 static const key_map_t map_table[]={
         [0x2] = {'1', '!'},
         [0x3] = {'2', '@'},
@@ -72,6 +80,8 @@ void kbd_init(void){
 
     if(!inited){
         kernel_memset(&kbd_stat,0,sizeof(kbd_stat));
+        kbd_buf_read=kbd_buf_write=0;
+        tasklet_init(&kbd_tasklet,kbd_tasklet_func);
         irq_install(IRQ1_KEYBOARD,(irq_handler_t)exception_handler_kbd);
         irq_enable(IRQ1_KEYBOARD);
 
@@ -173,20 +183,16 @@ void do_e0_key(uint8_t raw_code){
     }
 }
 
-void do_handler_kbd(exception_frame_t *frame){
+/**
+ * @brief 解析一个扫描码，处理按键状态并将字符送入tty
+ * @param raw_code 扫描码
+ */
+static void kbd_decode(uint8_t raw_code){
     static enum{
         NORMAL,
         BEGIN_E0,
         BEGIN_E1,
     }recv_state=NORMAL;
-    uint8_t status=inb(KBD_PORT_STAT);
-
-    if(!(status & KBD_STAT_RECV_READY)){
-        pic_send_eoi(IRQ1_KEYBOARD);
-        return;
-    }
-
-    uint8_t raw_code=inb(KBD_PORT_DATA);
 
     if(raw_code == KEY_E0){
         recv_state=BEGIN_E0;
@@ -212,6 +218,40 @@ void do_handler_kbd(exception_frame_t *frame){
             break;
         }
     }
+}
+
+/**
+ * @brief 键盘的下半部，在软中断中解析中断期间收到的所有扫描码
+ * @param tasklet 未使用
+ */
+static void kbd_tasklet_func(tasklet_t* tasklet){
+    for(;;){
+        irq_state_t state=irq_enter_protection();
+        if(kbd_buf_read==kbd_buf_write){
+            irq_leave_protection(state);
+            break;
+        }
+        uint8_t raw_code=kbd_buf[kbd_buf_read++ & (KBD_BUF_SIZE-1)];
+        irq_leave_protection(state);
+
+        kbd_decode(raw_code);
+    }
+}
 
+void do_handler_kbd(exception_frame_t *frame){
+    uint8_t status=inb(KBD_PORT_STAT);
+
+    if(!(status & KBD_STAT_RECV_READY)){
+        pic_send_eoi(IRQ1_KEYBOARD);
+        return;
+    }
+
+    // 中断中只读出扫描码，缓冲区满时丢弃
+    uint8_t raw_code=inb(KBD_PORT_DATA);
+    if(kbd_buf_write-kbd_buf_read<KBD_BUF_SIZE){
+        kbd_buf[kbd_buf_write++ & (KBD_BUF_SIZE-1)]=raw_code;
+    }
     pic_send_eoi(IRQ1_KEYBOARD);
+
+    tasklet_schedule(&kbd_tasklet);
 }
\ No newline at end of file
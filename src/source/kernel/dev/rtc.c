@@ -0,0 +1,107 @@
+#include "dev/rtc.h"
+#include "comm/cpu_instr.h"
+#include "tools/klib.h"
+
+/**
+ * @brief 读取CMOS寄存器
+ * @param reg 寄存器索引
+ * @return 寄存器的值
+ */
+static uint8_t cmos_read(uint8_t reg){
+    outb(CMOS_ADDR_PORT,reg);
+    return inb(CMOS_DATA_PORT);
+}
+
+/**
+ * @brief 将BCD码转换为二进制
+ */
+static int bcd_to_bin(uint8_t v){
+    return (v & 0x0F)+(v >> 4)*10;
+}
+
+/**
+ * @brief 读取一次RTC的原始寄存器值
+ * @param time 存放读取的结果
+ */
+static void rtc_read_raw(rtc_time_t* time){
+    // 等待RTC更新结束，避免读到正在变化的值
+    while(cmos_read(RTC_REG_STATUS_A) & RTC_STATUS_A_UIP){
+    }
+
+    time->second=cmos_read(RTC_REG_SECOND);
+    time->minute=cmos_read(RTC_REG_MINUTE);
+    time->hour=cmos_read(RTC_REG_HOUR);
+    time->day=cmos_read(RTC_REG_DAY);
+    time->month=cmos_read(RTC_REG_MONTH);
+    time->year=cmos_read(RTC_REG_YEAR) | (cmos_read(RTC_REG_CENTURY) << 8);
+}
+
+/**
+ * @brief 读取RTC中的日期和时间
+ * @param time 存放读取的结果
+ */
+void rtc_read_time(rtc_time_t* time){
+    rtc_time_t last;
+
+    // 连续两次读取的结果相同才认为有效
+    rtc_read_raw(time);
+    do{
+        kernel_memcpy(&last,time,sizeof(rtc_time_t));
+        rtc_read_raw(time);
+    }while(kernel_memcmp(&last,time,sizeof(rtc_time_t)));
+
+    uint8_t status_b=cmos_read(RTC_REG_STATUS_B);
+    int pm=time->hour & RTC_HOUR_PM;
+    time->hour&=~RTC_HOUR_PM;
+
+    int century=time->year >> 8;
+    time->year&=0xFF;
+
+    if(!(status_b & RTC_STATUS_B_BINARY)){
+        time->second=bcd_to_bin(time->second);
+        time->minute=bcd_to_bin(time->minute);
+        time->hour=bcd_to_bin(time->hour);
+        time->day=bcd_to_bin(time->day);
+        time->month=bcd_to_bin(time->month);
+        time->year=bcd_to_bin(time->year);
+        century=bcd_to_bin(century);
+    }
+
+    // 12小时制的小时为1~12，12 AM为0点，12 PM为12点
+    if(!(status_b & RTC_STATUS_B_24H)){
+        time->hour=time->hour%12+(pm ? 12 : 0);
+    }
+
+    // 世纪寄存器不一定存在，无效时按20xx处理
+    if((century<19) || (century>99)){
+        century=20;
+    }
+    time->year+=century*100;
+}
+
+/**
+ * @brief 读取RTC并转换为1970-01-01 00:00:00 UTC以来的秒数
+ * @return 秒数
+ */
+uint32_t rtc_get_epoch(void){
+    static const int month_days[]={0,31,59,90,120,151,181,212,243,273,304,334};
+
+    rtc_time_t time;
+    rtc_read_time(&time);
+
+    if((time.month<1) || (time.month>12) || (time.year<1970)){
+        return 0;
+    }
+
+    uint32_t days=(time.year-1970)*365;
+    // 1970年以来的闰年数，不含当年
+    days+=((time.year-1)/4-1969/4)-((time.year-1)/100-1969/100)+((time.year-1)/400-1969/400);
+    days+=month_days[time.month-1]+time.day-1;
+
+    int leap=((time.year%4==0) && (time.year%100!=0)) || (time.year%400==0);
+    if(leap && (time.month>2)){
+        days++;
+    }
+
+    return ((days*24+time.hour)*60+time.minute)*60+time.second;
+}
\ No newline at end of file
@@ -1,12 +1,27 @@
 #include "dev/time.h"
+#include "dev/clock.h"
+#include "cpu/apic.h"
+#include "core/profile.h"
 
 // 定时器计数
 static uint32_t sys_tick;
 
 void do_handler_time(exception_frame_t* frame){
     sys_tick++;
+    clock_tick();
     pic_send_eoi(IRQ0_TIMER);
-    task_time_tick();
+    prof_tick(frame);
+
+    // 根据被中断时的特权级区分用户态与内核态时间
+    task_time_tick((frame->cs & 0x3)==SEG_CPL3);
+}
+
+/**
+ * @brief 获取系统启动后的tick数
+ * @return tick数，每个tick为OS_TICK_MS毫秒
+ */
+uint32_t time_get_tick(void){
+    return sys_tick;
 }
 
 // 定时器硬件初始化
@@ -25,5 +40,12 @@ static void init_pit(void){
 // 定时器初始化
 void time_init(void){
     sys_tick=0;
+    clock_init();
+
+    // 优先使用LAPIC定时器，此时IOAPIC上PIT的引脚保持屏蔽
+    irq_install(IRQ0_TIMER, (irq_handler_t)exception_handler_time);
+    if(lapic_timer_init(IRQ0_TIMER,OS_TICK_MS)==0){
+        return;
+    }
     init_pit();
 }
\ No newline at end of file
@@ -80,6 +80,7 @@ int tty_open(device_t* dev){
     sem_init(&tty->osem,TTY_OBUF_SIZE);
     tty_fifo_init(&tty->ififo,tty->ibuf,TTY_IBUF_SIZE);
     sem_init(&tty->isem,0);
+    wait_queue_init(&tty->iwq);
 
     tty->oflags=TTY_OCRLF;
     tty->console_index=idx;
@@ -205,6 +206,22 @@ void tty_close(device_t* dev){
 
 }
 
+/**
+ * @brief 查询tty的读写状态，输出直接写到控制台，总是可写
+ * @param dev tty设备
+ * @param table poll表
+ * @return 输入缓存中有字符时包含POLLIN
+ */
+int tty_poll(device_t* dev,poll_table_t* table){
+    tty_t* tty=get_tty(dev);
+    if(!tty){
+        return POLLNVAL;
+    }
+
+    poll_wait(&tty->iwq,table);
+    return (sem_count(&tty->isem) ? POLLIN : 0) | POLLOUT;
+}
+
 /**
 * @brief 选择curr_tty索引的tty设备，然后将ch放入tty的输入缓存中
 * @param ch 要放入tty设备的输入缓存中的字符
@@ -218,6 +235,7 @@ void tty_in(char ch){
 
     tty_fifo_put(&tty->ififo,ch);
     sem_notify(&tty->isem);
+    wait_queue_wakeup(&tty->iwq);
 
 }
 
@@ -240,4 +258,5 @@ dev_desc_t dev_tty_desc={
     .write=tty_write,
     .control=tty_control,
     .close=tty_close,
+    .poll=tty_poll,
 };
\ No newline at end of file
@@ -0,0 +1,204 @@
+#include "fs/aio.h"
+#include "fs/fs.h"
+#include "core/task.h"
+#include "core/kmalloc.h"
+#include "cpu/mmu.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+/// @brief 执行异步I/O的工作队列，请求轮流分配到各队列
+static workqueue_t aio_wq[AIO_WORKER_NR];
+
+/// @brief 下一个请求使用的工作队列
+static int aio_next_wq;
+
+/**
+ * @brief 创建异步I/O的工作线程
+ */
+void aio_init(void){
+    for(int i=0;i<AIO_WORKER_NR;i++){
+        workqueue_create(aio_wq+i,"aio");
+    }
+}
+
+/**
+ * @brief 释放异步I/O上下文，由mm_put在地址空间销毁时调用，此时已没有未完成的操作
+ * @param ctx 异步I/O上下文，环所在的页随页表一起释放
+ */
+void aio_ctx_free(aio_ctx_t* ctx){
+    ASSERT(ctx->inflight==0);
+    kfree(ctx);
+}
+
+/**
+ * @brief 将完成项写入完成队列，并唤醒等待者
+ * @param ctx 异步I/O上下文
+ * @param user_data 提交项的user_data
+ * @param res 操作的返回值
+ */
+static void aio_complete(aio_ctx_t* ctx,uint32_t user_data,int res){
+    irq_state_t state=irq_enter_protection();
+    aio_ring_t* ring=ctx->ring;
+
+    // 提交时已为每个操作预留了完成队列的空间
+    aio_cqe_t* cqe=ring->cqes+(ring->cq_tail & (AIO_CQ_ENTRIES-1));
+    cqe->user_data=user_data;
+    cqe->res=res;
+    ring->cq_tail++;
+    ring->inflight=--ctx->inflight;
+
+    if(ctx->waiting){
+        ctx->waiting--;
+        sem_notify(&ctx->sem);
+    }
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief 在工作线程中执行一个操作，完成后释放请求持有的引用
+ * @param work 请求中的工作项
+ */
+static void aio_work_func(work_t* work){
+    aio_req_t* req=list_node_parent(work,aio_req_t,work);
+    aio_sqe_t* sqe=&req->sqe;
+
+    int res=-1;
+    switch(sqe->op){
+        case AIO_OP_READ:
+        case AIO_OP_WRITE:
+            res=fs_file_rw(req->file,req->mm->page_dir,(uint32_t)sqe->buf,sqe->len,
+                sqe->offset,sqe->op==AIO_OP_WRITE);
+            break;
+        case AIO_OP_FSYNC:
+            res=fs_file_fsync(req->file);
+            break;
+        default:
+            break;
+    }
+
+    mm_t* mm=req->mm;
+    aio_complete(mm->aio,sqe->user_data,res);
+    fs_close_file(req->file);
+    kfree(req);
+
+    // 进程可能已经退出，此时由最后一个请求销毁地址空间
+    mm_put(mm);
+}
+
+/**
+ * @brief 创建当前进程的异步I/O环，并映射到用户空间的AIO_RING_ADDR
+ * @return 异步I/O环的用户地址，已创建时返回原来的环，失败返回0
+ */
+aio_ring_t* sys_aio_setup(void){
+    mm_t* mm=task_current()->mm;
+    aio_ring_t* ring=(aio_ring_t*)0;
+
+    mutex_lock(&mm->mutex);
+    if(mm->aio){
+        ring=(aio_ring_t*)AIO_RING_ADDR;
+        goto aio_setup_end;
+    }
+
+    aio_ctx_t* ctx=(aio_ctx_t*)kzalloc(sizeof(aio_ctx_t));
+    if(ctx==(aio_ctx_t*)0){
+        goto aio_setup_end;
+    }
+
+    memory_alloc_for_page_dir(mm->page_dir,AIO_RING_ADDR,MEM_PAGE_SIZE,PTE_P | PTE_U | PTE_W);
+    uint32_t paddr=memory_get_paddr(mm->page_dir,AIO_RING_ADDR);
+    if(paddr==0){
+        log_printf("alloc aio ring failed.");
+        kfree(ctx);
+        goto aio_setup_end;
+    }
+
+    ctx->ring=(aio_ring_t*)paddr;
+    kernel_memset(ctx->ring,0,MEM_PAGE_SIZE);
+    sem_init(&ctx->sem,0);
+    mm->aio=ctx;
+    ring=(aio_ring_t*)AIO_RING_ADDR;
+
+aio_setup_end:
+    mutex_unlock(&mm->mutex);
+    return ring;
+}
+
+/**
+ * @brief 提交一个提交项，文件和地址空间的引用由请求持有到操作完成
+ * @param mm 当前进程的地址空间
+ * @param sqe 提交项
+ * @return 0 已加入工作队列或已直接完成，-1 失败
+ */
+static int aio_submit_one(mm_t* mm,aio_sqe_t* sqe){
+    aio_ctx_t* ctx=mm->aio;
+
+    irq_state_t state=irq_enter_protection();
+    ctx->inflight++;
+    ctx->ring->inflight=ctx->inflight;
+    irq_leave_protection(state);
+
+    file_t* file=task_file(sqe->fd);
+    if((sqe->op==AIO_OP_NOP) || (file==(file_t*)0)){
+        aio_complete(ctx,sqe->user_data,sqe->op==AIO_OP_NOP ? 0 : -1);
+        return 0;
+    }
+
+    aio_req_t* req=(aio_req_t*)kmalloc(sizeof(aio_req_t));
+    if(req==(aio_req_t*)0){
+        aio_complete(ctx,sqe->user_data,-1);
+        return -1;
+    }
+
+    file_inc_ref(file);
+    req->file=file;
+    req->mm=mm_get(mm);
+    req->sqe=*sqe;
+    work_init(&req->work,aio_work_func);
+
+    queue_work(aio_wq+aio_next_wq,&req->work);
+    aio_next_wq=(aio_next_wq+1) % AIO_WORKER_NR;
+    return 0;
+}
+
+/**
+ * @brief 提交环中全部已填写的提交项，并等待完成队列中至少有min_complete项
+ * @param min_complete 等待的完成项数，不能为负数，已提交的操作全部完成后不再等待
+ * @return 本次提交的项数，没有异步I/O环或参数错误返回-1
+ */
+int sys_aio_enter(int min_complete){
+    mm_t* mm=task_current()->mm;
+    aio_ctx_t* ctx=mm->aio;
+    if((ctx==(aio_ctx_t*)0) || (min_complete<0)){
+        return -1;
+    }
+
+    // 多个线程可能同时提交，持有mm->mutex依次取出提交项
+    mutex_lock(&mm->mutex);
+    aio_ring_t* ring=ctx->ring;
+    int submitted=0;
+    while(ring->sq_head!=ring->sq_tail){
+        // 为每个操作预留完成队列的空间，完成队列满时留待下次提交
+        if(ring->cq_tail-ring->cq_head+ctx->inflight>=AIO_CQ_ENTRIES){
+            break;
+        }
+
+        aio_sqe_t sqe=ring->sqes[ring->sq_head & (AIO_SQ_ENTRIES-1)];
+        ring->sq_head++;
+        aio_submit_one(mm,&sqe);
+        submitted++;
+    }
+    mutex_unlock(&mm->mutex);
+
+    for(;;){
+        irq_state_t state=irq_enter_protection();
+        if((ring->cq_tail-ring->cq_head>=(uint32_t)min_complete) || (ctx->inflight==0)){
+            irq_leave_protection(state);
+            break;
+        }
+        ctx->waiting++;
+        irq_leave_protection(state);
+
+        sem_wait(&ctx->sem);
+    }
+    return submitted;
+}
\ No newline at end of file
@@ -75,6 +75,10 @@ int devfs_ioctl(file_t *file,int cmd,int arg0,int arg1){
     return dev_control(file->dev_id,cmd,arg0,arg1);
 }
 
+int devfs_poll(file_t* file,struct _poll_table_t* table){
+    return dev_poll(file->dev_id,table);
+}
+
 fs_op_t devfs_op={
     .mount=devfs_mount,
     .unmount=devfs_unmount,
@@ -85,4 +89,5 @@ fs_op_t devfs_op={
     .seek=devfs_seek,
     .stat=devfs_stat,
     .ioctl=devfs_ioctl,
+    .poll=devfs_poll,
 };
\ No newline at end of file
@@ -309,6 +309,7 @@ int fatfs_mount(struct _fs_t *fs,int major,int minor){
     fat->cluster_byte_size=fat->sec_per_cluster*dbr->BPB_BytsPerSec;
     fat->fs=fs;
     fat->curr_sector=-1; // 初始化当前扇区为-1
+    mutex_init(&fat->mutex);
 
 
     fs->type=FS_FAT16;
@@ -424,7 +425,7 @@ static int write_dir_entry(fat_t *fat,diritem_t *item,int index){
     return bwrite_sector(fat, sector);
 }
 
-int fatfs_open(struct _fs_t *fs,const char *path,file_t *file){
+static int fatfs_open_nolock(struct _fs_t *fs,const char *path,file_t *file){
  fat_t * fat = (fat_t *)fs->data;
     diritem_t * file_item = (diritem_t *)0;
     int p_index = -1;
@@ -483,6 +484,20 @@ int fatfs_open(struct _fs_t *fs,const char *path,file_t *file){
     return -1;
 }
 
+/**
+ * @brief 查找或创建文件
+ * @note 对外的接口在fat->mutex内调用对应的_nolock函数，读写只在访问fat_buff和FAT表时持有
+ */
+int fatfs_open(struct _fs_t *fs,const char *path,file_t *file){
+    fat_t *fat=(fat_t *)fs->data;
+
+    mutex_lock(&fat->mutex);
+    int err=fatfs_open_nolock(fs,path,file);
+    mutex_unlock(&fat->mutex);
+
+    return err;
+}
+
 
 /**
  * @brief 移动文件指针
@@ -546,17 +561,22 @@ int fatfs_read(char *buf,int size,file_t *file){
                 curr_read=fat->cluster_byte_size - cluster_offset;
             }
 
+            // 不足一簇时经过fat_buff中转，整簇读取直接读到用户缓冲区，不需要加锁
+            mutex_lock(&fat->mutex);
             fat->curr_sector=-1; // 重置当前扇区
             int err=dev_read(fat->fs->dev_id,start_sector,fat->fat_buff,fat->sec_per_cluster);
 
             kernel_memcpy(buf,fat->fat_buff+cluster_offset,curr_read);
+            mutex_unlock(&fat->mutex);
         }
 
         buf+=curr_read;
         nbytes-=curr_read;
         total_read+=curr_read;
 
+        mutex_lock(&fat->mutex);
         int err=move_file_pos(file,fat,curr_read,0);
+        mutex_unlock(&fat->mutex);
         if(err < 0){
             return total_read;
         }
@@ -578,7 +598,9 @@ int fatfs_write(char *buf,int size,file_t *file){
     // 如果文件大小不够，则先扩展文件大小
     if (file->pos + size > file->size) {
         int inc_size = file->pos + size - file->size;
+        mutex_lock(&fat->mutex);
         int err = expand_file(file, inc_size);
+        mutex_unlock(&fat->mutex);
         if (err < 0) {
             return 0;
         }
@@ -592,7 +614,7 @@ int fatfs_write(char *buf,int size,file_t *file){
 		uint32_t cluster_offset = file->pos % fat->cluster_byte_size;
         uint32_t start_sector = fat->data_start + (file->cblk - 2)* fat->sec_per_cluster;  // 从2开始
 
-        // 如果是整簇, 写整簇
+        // 如果是整簇, 直接从调用者的缓冲区写整簇，不需要加锁
         if ((cluster_offset == 0) && (nbytes == fat->cluster_byte_size)) {
             int err = dev_write(fat->fs->dev_id, start_sector, buf, fat->sec_per_cluster);
             if (err < 0) {
@@ -606,15 +628,19 @@ int fatfs_write(char *buf,int size,file_t *file){
                 curr_write = fat->cluster_byte_size - cluster_offset;
             }
 
+            // 不足一簇时经过fat_buff中转
+            mutex_lock(&fat->mutex);
             fat->curr_sector = -1;
             int err = dev_read(fat->fs->dev_id, start_sector, fat->fat_buff, fat->sec_per_cluster);
             if (err < 0) {
+                mutex_unlock(&fat->mutex);
                 return total_write;
             }
             kernel_memcpy(fat->fat_buff + cluster_offset, buf, curr_write);        
             
             // 写整个簇，然后从中拷贝
             err = dev_write(fat->fs->dev_id, start_sector, fat->fat_buff, fat->sec_per_cluster);
+            mutex_unlock(&fat->mutex);
             if (err < 0) {
                 return total_write;
             }
@@ -625,8 +651,10 @@ int fatfs_write(char *buf,int size,file_t *file){
         total_write += curr_write;
         file->size += curr_write;
 
-        // 前移文件指针
+        // 前移文件指针，跨簇时会读写FAT表
+        mutex_lock(&fat->mutex);
 		int err = move_file_pos(file, fat, curr_write, 1);
+        mutex_unlock(&fat->mutex);
 		if (err < 0) {
             return total_write;
         }
@@ -635,7 +663,7 @@ int fatfs_write(char *buf,int size,file_t *file){
     return total_write;
 }
 
-void fatfs_close(file_t *file){
+static void fatfs_close_nolock(file_t *file){
     if(file->mode == O_RDONLY){
         return;
     }
@@ -654,7 +682,26 @@ void fatfs_close(file_t *file){
 
 }
 
-int fatfs_seek(file_t *file,uint32_t offset,int dir){
+/**
+ * @brief 关闭文件，回写目录项
+ */
+void fatfs_close(file_t *file){
+    fat_t *fat=(fat_t *)file->fs->data;
+
+    mutex_lock(&fat->mutex);
+    fatfs_close_nolock(file);
+    mutex_unlock(&fat->mutex);
+}
+
+/**
+ * @brief 将文件的大小和起始簇回写到目录项，数据扇区在写入时已直接写到磁盘
+ */
+int fatfs_fsync(file_t *file){
+    fatfs_close(file);
+    return 0;
+}
+
+static int fatfs_seek_nolock(file_t *file,uint32_t offset,int dir){
     if(dir!=0){
         return -1;
     }
@@ -689,6 +736,19 @@ int fatfs_seek(file_t *file,uint32_t offset,int dir){
     return 0;
 }
 
+/**
+ * @brief 移动文件的读写位置
+ */
+int fatfs_seek(file_t *file,uint32_t offset,int dir){
+    fat_t *fat=(fat_t *)file->fs->data;
+
+    mutex_lock(&fat->mutex);
+    int err=fatfs_seek_nolock(file,offset,dir);
+    mutex_unlock(&fat->mutex);
+
+    return err;
+}
+
 int fatfs_stat(file_t *file,struct stat *st){
     return -1;
 }
@@ -699,7 +759,7 @@ int fatfs_opendir(struct _fs_t *fs,const char *name,DIR *dir){
 
 }
 
-int fatfs_readdir(struct _fs_t *fs,DIR *dir,struct dirent *dirent){
+static int fatfs_readdir_nolock(struct _fs_t *fs,DIR *dir,struct dirent *dirent){
     fat_t *fat=(fat_t*)fs->data;
 
     while(dir->index < fat->root_ent_cnt){
@@ -729,6 +789,19 @@ int fatfs_readdir(struct _fs_t *fs,DIR *dir,struct dirent *dirent){
     return -1;
 }
 
+/**
+ * @brief 读取目录项
+ */
+int fatfs_readdir(struct _fs_t *fs,DIR *dir,struct dirent *dirent){
+    fat_t *fat=(fat_t *)fs->data;
+
+    mutex_lock(&fat->mutex);
+    int err=fatfs_readdir_nolock(fs,dir,dirent);
+    mutex_unlock(&fat->mutex);
+
+    return err;
+}
+
 int fatfs_closedir(struct _fs_t *fs,DIR *dir){
     return 0;
 }
@@ -738,7 +811,7 @@ int fatfs_closedir(struct _fs_t *fs,DIR *dir){
  * @param fs 文件系统数据结构
  * @param path 要删除的文件或目录的路径
  */
-int fatfs_unlink(struct _fs_t *fs,const char *path){
+static int fatfs_unlink_nolock(struct _fs_t *fs,const char *path){
   fat_t * fat = (fat_t *)fs->data;
 
     // 遍历根目录的数据区，找到已经存在的匹配项
@@ -774,6 +847,19 @@ int fatfs_unlink(struct _fs_t *fs,const char *path){
     return -1;
 }
 
+/**
+ * @brief 删除文件
+ */
+int fatfs_unlink(struct _fs_t *fs,const char *path){
+    fat_t *fat=(fat_t *)fs->data;
+
+    mutex_lock(&fat->mutex);
+    int err=fatfs_unlink_nolock(fs,path);
+    mutex_unlock(&fat->mutex);
+
+    return err;
+}
+
 fs_op_t fatfs_op={
     .mount=fatfs_mount,
     .unmount=fatfs_unmount,
@@ -787,4 +873,5 @@ fs_op_t fatfs_op={
     .readdir=fatfs_readdir,
     .closedir=fatfs_closedir,
     .unlink=fatfs_unlink,
+    .fsync=fatfs_fsync,
 };
@@ -7,6 +7,9 @@ static file_t file_table[FILE_TABLE_SIZE];
 /// @brief 文件互斥锁
 static mutex_t file_alloc_mutex; 
 
+/// @brief 每个文件的读写锁，保护读写位置，与file_table一一对应
+static mutex_t file_mutex_table[FILE_TABLE_SIZE];
+
 file_t* file_alloc(void){
     file_t* file=(file_t*)0;
 
@@ -39,10 +42,25 @@ void file_free(file_t* file){
 void file_table_init(void){
     mutex_init(&file_alloc_mutex);
     kernel_memset(file_table,0,sizeof(file_table));
+    for(int i=0;i<FILE_TABLE_SIZE;i++){
+        mutex_init(file_mutex_table+i);
+    }
 }
 
 void file_inc_ref(file_t* file){
     mutex_lock(&file_alloc_mutex);
     file->ref++;
     mutex_unlock(&file_alloc_mutex);
+}
+
+/**
+ * @brief 锁定文件，同一文件的读写和定位操作串行进行，不同文件互不影响
+ * @param file 文件
+ */
+void file_lock(file_t* file){
+    mutex_lock(file_mutex_table+(file-file_table));
+}
+
+void file_unlock(file_t* file){
+    mutex_unlock(file_mutex_table+(file-file_table));
 }
\ No newline at end of file
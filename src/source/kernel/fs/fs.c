@@ -9,6 +9,13 @@
 #include "core/task.h"
 #include "dev/tty.h"
 #include "dev/disk.h"
+#include "fs/pipe.h"
+#include "fs/socket.h"
+#include "ipc/waitq.h"
+#include "core/kmalloc.h"
+#include "core/memory.h"
+#include "dev/time.h"
+#include "os_cfg.h"
 
 #include <sys/file.h>
 
@@ -101,15 +108,43 @@ int path_begin_with(const char* path,const char* str){
 }
 
 
+/**
+ * @brief 共享持有文件系统，用于不修改目录结构的操作，多个任务可以同时进行
+ * @param fs 文件系统
+ */
 static void fs_protect(fs_t* fs){
-    if(fs->mutex){
-        mutex_lock(fs->mutex);
-    }
+    rwsem_read_lock(&fs->rwsem);
 }
 
 static void fs_unprotect(fs_t* fs){
-    if(fs->mutex){
-        mutex_unlock(fs->mutex);
+    rwsem_read_unlock(&fs->rwsem);
+}
+
+/**
+ * @brief 独占持有文件系统，用于删除文件等会使其它操作失效的修改
+ * @param fs 文件系统
+ */
+static void fs_write_protect(fs_t* fs){
+    rwsem_write_lock(&fs->rwsem);
+}
+
+static void fs_write_unprotect(fs_t* fs){
+    rwsem_write_unlock(&fs->rwsem);
+}
+
+/**
+ * @brief 锁定文件的读写位置，只有普通文件需要，tty等设备的读操作可能长时间阻塞
+ * @param file 文件
+ */
+static void file_protect(file_t* file){
+    if(file->type==FILE_NORMAL){
+        file_lock(file);
+    }
+}
+
+static void file_unprotect(file_t* file){
+    if(file->type==FILE_NORMAL){
+        file_unlock(file);
     }
 }
 
@@ -183,6 +218,11 @@ int sys_read(int file,char* ptr,int len){
         return 0;
     }
 
+    // 内核直接写入用户缓冲区，需确认各页存在且用户可写
+    if(memory_check_user(ptr,len,1)<0){
+        return -1;
+    }
+
         
     file_t* p_file=task_file(file);
     if(!p_file){
@@ -198,9 +238,11 @@ int sys_read(int file,char* ptr,int len){
 
     fs_t* fs=p_file->fs;
 
+    file_protect(p_file);
     fs_protect(fs);
     int err=fs->op->read(ptr,len,p_file);
     fs_unprotect(fs);
+    file_unprotect(p_file);
 
     return err;
 }
@@ -211,6 +253,10 @@ int sys_write(int fd,char* ptr,int len){
         return 0;
     }
 
+    if(memory_check_user(ptr,len,0)<0){
+        return -1;
+    }
+
     file_t* p_file=task_file(fd);
     if(!p_file){
         log_printf("file not opened");
@@ -224,9 +270,11 @@ int sys_write(int fd,char* ptr,int len){
 
     fs_t* fs=p_file->fs;
 
+    file_protect(p_file);
     fs_protect(fs);
     int err=fs->op->write(ptr,len,p_file);
     fs_unprotect(fs);
+    file_unprotect(p_file);
 
     return err;
 }
@@ -243,24 +291,104 @@ int sys_lseek(int file,int ptr,int dir){
     }
 
     fs_t* fs=p_file->fs;
+    file_protect(p_file);
     fs_protect(fs);
     int err=fs->op->seek(p_file,ptr,dir);
     fs_unprotect(fs);
+    file_unprotect(p_file);
 
     return err;
 }   
 
-int sys_close(int file){
-    if(is_fd_bad(file)){
-        log_printf("file error");
+/**
+ * @brief 读写另一个地址空间中的缓冲区，用于在内核线程中代替用户进程执行读写
+ * @param p_file 文件
+ * @param page_dir 缓冲区所在地址空间的页表
+ * @param vaddr 缓冲区的用户地址
+ * @param size 读写的字节数
+ * @param offset 文件内的偏移，0xFFFFFFFF表示当前位置
+ * @param write 1为写，0为读
+ * @return 读写的字节数，失败返回-1
+ */
+int fs_file_rw(file_t* p_file,uint32_t page_dir,uint32_t vaddr,int size,uint32_t offset,int write){
+    if((vaddr<MEMORY_TASK_BASE) || (size<0) || (vaddr+size<vaddr) || (p_file->mode==(write ? O_RDONLY : O_WRONLY))){
         return -1;
     }
 
-    file_t* p_file=task_file(file);
-    if(!p_file){
-        log_printf("file not opened");
-        return -1;
+    // 先检查整个缓冲区，内核经物理地址访问时不受页表权限限制
+    // 读文件时内核写入缓冲区，需要该页可写，避免改写vdso等只读页
+    int pages=((vaddr & (MEM_PAGE_SIZE-1))+size+MEM_PAGE_SIZE-1)/MEM_PAGE_SIZE;
+    for(int i=0;i<pages;i++){
+        if(memory_get_user_paddr(page_dir,(vaddr & ~(MEM_PAGE_SIZE-1))+i*MEM_PAGE_SIZE,!write)==0){
+            return -1;
+        }
+    }
+
+    fs_t* fs=p_file->fs;
+    file_protect(p_file);
+    fs_protect(fs);
+
+    int total=-1;
+    if((offset!=0xFFFFFFFF) && (fs->op->seek(p_file,offset,0)<0)){
+        goto fs_file_rw_end;
+    }
+
+    // 缓冲区在物理上不连续，按页分段读写
+    total=0;
+    while(total<size){
+        uint32_t paddr=memory_get_user_paddr(page_dir,vaddr+total,!write);
+        if(paddr==0){
+            total=total ? total : -1;
+            break;
+        }
+
+        int curr_size=MEM_PAGE_SIZE-(paddr & (MEM_PAGE_SIZE-1));
+        if(curr_size>size-total){
+            curr_size=size-total;
+        }
+
+        int cnt=write ? fs->op->write((char*)paddr,curr_size,p_file)
+                      : fs->op->read((char*)paddr,curr_size,p_file);
+        if(cnt<0){
+            total=total ? total : -1;
+            break;
+        }
+        total+=cnt;
+        if(cnt<curr_size){
+            break;
+        }
+    }
+
+fs_file_rw_end:
+    fs_unprotect(fs);
+    file_unprotect(p_file);
+    return total;
+}
+
+/**
+ * @brief 将文件的元数据写回磁盘
+ * @param p_file 文件
+ * @return 0 成功，-1 失败
+ */
+int fs_file_fsync(file_t* p_file){
+    fs_t* fs=p_file->fs;
+    if(fs->op->fsync==0){
+        return 0;
     }
+
+    file_protect(p_file);
+    fs_protect(fs);
+    int err=fs->op->fsync(p_file);
+    fs_unprotect(fs);
+    file_unprotect(p_file);
+    return err;
+}
+
+/**
+ * @brief 减少文件的引用计数，最后一个引用释放时关闭文件
+ * @param p_file 要释放的文件
+ */
+void fs_close_file(file_t* p_file){
     ASSERT(p_file->ref>0);
 
     fs_t* fs=p_file->fs;
@@ -272,9 +400,23 @@ int sys_close(int file){
         file_free(p_file);
         
     }
+}
 
-    task_remove_fd(file);
+int sys_close(int file){
+    if(is_fd_bad(file)){
+        log_printf("file error");
+        return -1;
+    }
 
+    file_t* p_file=task_file(file);
+    if(!p_file){
+        log_printf("file not opened");
+        return -1;
+    }
+
+    // 先从文件表中移除，避免同一进程的其它线程继续使用正在关闭的文件
+    task_remove_fd(file);
+    fs_close_file(p_file);
 
     return 0;
 
@@ -300,6 +442,9 @@ int sys_fstat(int file,struct stat* st){
     if(is_fd_bad(file)){
         return 0;
     }
+    if(memory_check_user(st,sizeof(struct stat),1)<0){
+        return -1;
+    }
 
     file_t* p_file=task_file(file);
     if(!p_file){
@@ -376,6 +521,7 @@ static fs_t* mount(fs_type_t type,char* mount_point,int dev_major,int minor){
 
     kernel_memset(fs,0,sizeof(fs_t));
     kernel_strncpy(fs->mount_point,mount_point,FS_MOUNT_SIZE);
+    rwsem_init(&fs->rwsem);
 
     fs->op=op;
     
@@ -397,6 +543,8 @@ mount_failed:
 void fs_init(void){
     mount_list_init();
     file_table_init();
+    pipe_fs_init();
+    socket_init();
 
     disk_init();
 
@@ -435,6 +583,10 @@ int sys_dup(int file){
 }
 
 int sys_opendir(const char* path, DIR* dir){
+    if(memory_check_user(dir,sizeof(DIR),1)<0){
+        return -1;
+    }
+
     fs_protect(root_fs);
     int err=root_fs->op->opendir(root_fs, path, dir);
     fs_unprotect(root_fs);
@@ -443,6 +595,10 @@ int sys_opendir(const char* path, DIR* dir){
 }
 
 int sys_readdir(DIR* dir, struct dirent* dirent){
+    if((memory_check_user(dir,sizeof(DIR),1)<0) || (memory_check_user(dirent,sizeof(struct dirent),1)<0)){
+        return -1;
+    }
+
     fs_protect(root_fs);
     int err=root_fs->op->readdir(root_fs,dir,dirent);
     fs_unprotect(root_fs);
@@ -479,10 +635,157 @@ int sys_ioctl(int fd,int cmd,int arg0,int arg1){
     return err;
 }
 
+/**
+ * @brief 创建管道
+ * @param fds 保存两个文件描述符，fds[0]为读端，fds[1]为写端
+ * @return 0 成功，-1 失败
+ */
+int sys_pipe(int* fds){
+    if((fds==(int*)0) || (memory_check_user(fds,sizeof(int)*2,1)<0)){
+        return -1;
+    }
+
+    int read_fd=-1,write_fd=-1;
+    file_t* read_file=file_alloc();
+    file_t* write_file=file_alloc();
+    if(!read_file || !write_file){
+        goto sys_pipe_failed;
+    }
+
+    read_fd=task_alloc_fd(read_file);
+    if(read_fd<0){
+        goto sys_pipe_failed;
+    }
+    write_fd=task_alloc_fd(write_file);
+    if(write_fd<0){
+        goto sys_pipe_failed;
+    }
+
+    if(pipe_open(read_file,write_file)<0){
+        goto sys_pipe_failed;
+    }
+
+    fds[0]=read_fd;
+    fds[1]=write_fd;
+    return 0;
+
+sys_pipe_failed:
+    if(read_fd>=0){
+        task_remove_fd(read_fd);
+    }
+    if(write_fd>=0){
+        task_remove_fd(write_fd);
+    }
+    if(read_file){
+        file_free(read_file);
+    }
+    if(write_file){
+        file_free(write_file);
+    }
+    return -1;
+}
+
+/**
+ * @brief 查询文件的读写状态，文件系统没有提供poll时视为总是可读写
+ * @param file 文件
+ * @param table poll表，为0时只查询
+ * @return POLLIN、POLLOUT等标志的组合
+ */
+static int fs_poll_file(file_t* file,poll_table_t* table){
+    fs_t* fs=file->fs;
+    if(fs->op->poll==0){
+        return POLLIN | POLLOUT;
+    }
+    return fs->op->poll(file,table);
+}
+
+/**
+ * @brief 查询一组文件的状态，结果写入revents
+ * @param fds 查询的文件
+ * @param files fds对应的文件，无效的项为0
+ * @param nfds 文件数量
+ * @param table poll表，为0时只查询不加入等待队列
+ * @return 有事件的文件数量
+ */
+static int fs_poll_scan(struct pollfd* fds,file_t** files,int nfds,poll_table_t* table){
+    int ready=0;
+    for(int i=0;i<nfds;i++){
+        struct pollfd* pfd=fds+i;
+        if(pfd->fd<0){
+            pfd->revents=0;
+            continue;
+        }
+
+        int mask=files[i] ? fs_poll_file(files[i],table) : POLLNVAL;
+        pfd->revents=mask & (pfd->events | POLLERR | POLLHUP | POLLNVAL);
+        if(pfd->revents){
+            ready++;
+        }
+    }
+    return ready;
+}
+
+/**
+ * @brief 等待多个文件中的任意一个可读写
+ * @param fds 查询的文件
+ * @param nfds 文件数量，最多POLL_MAX_FDS个
+ * @param timeout_ms 超时时间，小于0表示一直等待，0表示立即返回
+ * @return 有事件的文件数量，超时返回0，失败返回-1
+ */
+int sys_poll(struct pollfd* fds,int nfds,int timeout_ms){
+    if((fds==(struct pollfd*)0) || (nfds<0) || (nfds>POLL_MAX_FDS)
+        || (memory_check_user(fds,sizeof(struct pollfd)*nfds,1)<0)){
+        return -1;
+    }
+
+    poll_table_t* table=(poll_table_t*)kmalloc(sizeof(poll_table_t));
+    if(table==(poll_table_t*)0){
+        return -1;
+    }
+    poll_table_init(table);
+
+    // 等待期间持有文件的引用，避免其它线程关闭文件后释放等待队列
+    file_t* files[POLL_MAX_FDS];
+    for(int i=0;i<nfds;i++){
+        files[i]=is_fd_bad(fds[i].fd) ? (file_t*)0 : task_file(fds[i].fd);
+        if(files[i]){
+            file_inc_ref(files[i]);
+        }
+    }
+
+    uint32_t timeout_ticks=(timeout_ms+(OS_TICK_MS-1))/OS_TICK_MS;
+    uint32_t start=time_get_tick();
+
+    // 第一次查询时加入等待队列，之后只查询状态
+    int ready=fs_poll_scan(fds,files,nfds,timeout_ms ? table : (poll_table_t*)0);
+    while(ready==0 && timeout_ms){
+        int ticks=-1;
+        if(timeout_ms>0){
+            uint32_t elapsed=time_get_tick()-start;
+            if(elapsed>=timeout_ticks){
+                break;
+            }
+            ticks=timeout_ticks-elapsed;
+        }
+
+        poll_table_sleep(table,ticks);
+        ready=fs_poll_scan(fds,files,nfds,(poll_table_t*)0);
+    }
+
+    poll_table_free(table);
+    for(int i=0;i<nfds;i++){
+        if(files[i]){
+            fs_close_file(files[i]);
+        }
+    }
+    kfree(table);
+    return ready;
+}
+
 int sys_unlink(const char *path){
-    fs_protect(root_fs);
+    fs_write_protect(root_fs);
     int err=root_fs->op->unlink(root_fs, path);
-    fs_unprotect(root_fs);
+    fs_write_unprotect(root_fs);
 
     return err;
 }
\ No newline at end of file
@@ -0,0 +1,353 @@
+#include "fs/pipe.h"
+#include "core/kmalloc.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+#include <sys/file.h>
+
+extern fs_op_t pipe_op;
+
+/// @brief 管道文件所属的文件系统，不挂载到任何路径，只能通过pipe系统调用创建
+static fs_t pipe_fs;
+
+/**
+ * @brief 唤醒在信号量上等待的全部任务
+ * @param sem 信号量
+ * @param waiting 等待者的数量，唤醒后清零
+ */
+static void pipe_wakeup(sem_t* sem,int* waiting){
+    while(*waiting){
+        (*waiting)--;
+        sem_notify(sem);
+    }
+}
+
+/**
+ * @brief 在持有管道锁时等待，等待期间释放锁，返回时重新持有
+ * @param pipe 管道
+ * @param sem 等待的信号量
+ * @param waiting 等待者计数
+ */
+static void pipe_wait(pipe_t* pipe,sem_t* sem,int* waiting){
+    (*waiting)++;
+    mutex_unlock(&pipe->mutex);
+
+    // 唤醒可能在释放锁之后、等待之前到来，信号量会保留这次唤醒
+    sem_wait(sem);
+    mutex_lock(&pipe->mutex);
+}
+
+/**
+ * @brief 创建管道缓冲区，读端和写端各有一个使用者，管道文件和本地套接字都使用它
+ * @return 管道，失败返回0
+ */
+pipe_t* pipe_create(void){
+    pipe_t* pipe=(pipe_t*)kzalloc(sizeof(pipe_t));
+    if(pipe==(pipe_t*)0){
+        log_printf("alloc pipe failed");
+        return (pipe_t*)0;
+    }
+
+    pipe->buf=(char*)memory_alloc_pages(PIPE_PAGES);
+    if(pipe->buf==(char*)0){
+        log_printf("alloc pipe buffer failed");
+        kfree(pipe);
+        return (pipe_t*)0;
+    }
+
+    mutex_init(&pipe->mutex);
+    sem_init(&pipe->read_sem,0);
+    sem_init(&pipe->write_sem,0);
+    wait_queue_init(&pipe->wq);
+    pipe->readers=1;
+    pipe->writers=1;
+    return pipe;
+}
+
+/**
+ * @brief 创建管道，并将读端和写端文件关联到管道
+ * @param read_file 读端文件
+ * @param write_file 写端文件
+ * @return 0 成功，-1 失败
+ */
+int pipe_open(file_t* read_file,file_t* write_file){
+    pipe_t* pipe=pipe_create();
+    if(pipe==(pipe_t*)0){
+        return -1;
+    }
+
+    read_file->type=FILE_PIPE;
+    read_file->mode=O_RDONLY;
+    read_file->fs=&pipe_fs;
+    read_file->data=pipe;
+    kernel_strncpy(read_file->file_name,"pipe",FILE_NAME_SIZE);
+
+    write_file->type=FILE_PIPE;
+    write_file->mode=O_WRONLY;
+    write_file->fs=&pipe_fs;
+    write_file->data=pipe;
+    kernel_strncpy(write_file->file_name,"pipe",FILE_NAME_SIZE);
+    return 0;
+}
+
+/**
+ * @brief 检查读者登记的缓冲区是否每一页都是用户可写的
+ * @param page_dir 读者的页表
+ * @param buf 缓冲区地址
+ * @param size 字节数
+ * @return 全部可写返回1，否则返回0，此时读者改为经环形缓冲区复制
+ */
+static int pipe_direct_ok(uint32_t page_dir,uint32_t buf,int size){
+    if((size<=0) || (buf+size<buf)){
+        return 0;
+    }
+
+    uint32_t start=down2(buf,MEM_PAGE_SIZE);
+    uint32_t pages=(buf-start+size+MEM_PAGE_SIZE-1)/MEM_PAGE_SIZE;
+    for(uint32_t i=0;i<pages;i++){
+        if(memory_get_user_paddr(page_dir,start+i*MEM_PAGE_SIZE,1)==0){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief 从管道读取数据，缓冲区为空时等待，直到有数据或写端全部关闭
+ * @return 读取的字节数，写端全部关闭且没有数据时返回0
+ */
+int pipe_recv(pipe_t* pipe,char* buf,int size){
+    int direct=0;
+
+    mutex_lock(&pipe->mutex);
+    while(pipe->write_pos==pipe->read_pos){
+        if(pipe->writers==0){
+            break;
+        }
+
+        // 读用户缓冲区的读者登记缓冲区，写者可以直接复制过来，同时只有一个读者登记
+        uint32_t page_dir=task_current()->tss.cr3;
+        if(!direct && (pipe->direct_buf==0) && ((uint32_t)buf>=MEMORY_TASK_BASE) && pipe_direct_ok(page_dir,(uint32_t)buf,size)){
+            pipe->direct_buf=(uint32_t)buf;
+            pipe->direct_size=size;
+            pipe->direct_page_dir=page_dir;
+            pipe->direct_done=0;
+            direct=1;
+        }
+        pipe_wait(pipe,&pipe->read_sem,&pipe->read_waiting);
+
+        if(direct && pipe->direct_done){
+            int count=pipe->direct_done;
+            pipe->direct_buf=0;
+            pipe->direct_done=0;
+            pipe_wakeup(&pipe->write_sem,&pipe->write_waiting);
+            mutex_unlock(&pipe->mutex);
+            wait_queue_wakeup(&pipe->wq);
+            return count;
+        }
+    }
+
+    if(direct){
+        pipe->direct_buf=0;
+    }
+    if(pipe->write_pos==pipe->read_pos){
+        mutex_unlock(&pipe->mutex);
+        return 0;
+    }
+
+    uint32_t count=pipe->write_pos-pipe->read_pos;
+    if(count>size){
+        count=size;
+    }
+
+    // 环形缓冲区的数据可能分为尾部和头部两段
+    uint32_t offset=pipe->read_pos % PIPE_BUF_SIZE;
+    uint32_t first=PIPE_BUF_SIZE-offset;
+    if(first>count){
+        first=count;
+    }
+    kernel_memcpy(buf,pipe->buf+offset,first);
+    kernel_memcpy(buf+first,pipe->buf,count-first);
+    pipe->read_pos+=count;
+
+    pipe_wakeup(&pipe->write_sem,&pipe->write_waiting);
+    mutex_unlock(&pipe->mutex);
+    wait_queue_wakeup(&pipe->wq);
+    return count;
+}
+
+/**
+ * @brief 向管道写入数据，缓冲区已满时等待，直到全部写入或读端全部关闭
+ * @return 写入的字节数，读端全部关闭时一个字节也没写入则返回-1
+ */
+int pipe_send(pipe_t* pipe,char* buf,int size){
+    int written=0;
+
+    mutex_lock(&pipe->mutex);
+    while(written<size){
+        if(pipe->readers==0){
+            break;
+        }
+
+        // 缓冲区为空且有读者登记了缓冲区时，直接复制到读者的地址空间
+        if((pipe->write_pos==pipe->read_pos) && pipe->direct_buf && !pipe->direct_done){
+            int count=size-written;
+            if(count>pipe->direct_size){
+                count=pipe->direct_size;
+            }
+            int err=memory_copy_uvm_data(pipe->direct_buf,pipe->direct_page_dir,(uint32_t)buf+written,count);
+            pipe->direct_done=err<0 ? -1 : count;
+            if(err==0){
+                written+=count;
+            }
+            pipe_wakeup(&pipe->read_sem,&pipe->read_waiting);
+            continue;
+        }
+
+        uint32_t free=PIPE_BUF_SIZE-(pipe->write_pos-pipe->read_pos);
+        if(free==0){
+            pipe_wait(pipe,&pipe->write_sem,&pipe->write_waiting);
+            continue;
+        }
+
+        uint32_t count=size-written;
+        if(count>free){
+            count=free;
+        }
+
+        uint32_t offset=pipe->write_pos % PIPE_BUF_SIZE;
+        uint32_t first=PIPE_BUF_SIZE-offset;
+        if(first>count){
+            first=count;
+        }
+        kernel_memcpy(pipe->buf+offset,buf+written,first);
+        kernel_memcpy(pipe->buf,buf+written+first,count-first);
+        pipe->write_pos+=count;
+        written+=count;
+
+        // 每写入一段就唤醒读者，让读写交替进行
+        pipe_wakeup(&pipe->read_sem,&pipe->read_waiting);
+    }
+    mutex_unlock(&pipe->mutex);
+    if(written){
+        wait_queue_wakeup(&pipe->wq);
+    }
+
+    if(written==0 && size>0){
+        log_printf("write to pipe with no reader");
+        return -1;
+    }
+    return written;
+}
+
+/**
+ * @brief 关闭管道的一端，唤醒另一端的等待者，两端都关闭后释放管道
+ * @param pipe 管道
+ * @param reader 1为读端，0为写端
+ */
+void pipe_shutdown(pipe_t* pipe,int reader){
+    mutex_lock(&pipe->mutex);
+    if(reader){
+        pipe->readers--;
+        pipe_wakeup(&pipe->write_sem,&pipe->write_waiting);
+    }
+    else{
+        pipe->writers--;
+        pipe_wakeup(&pipe->read_sem,&pipe->read_waiting);
+    }
+    int release=(pipe->readers==0) && (pipe->writers==0);
+    mutex_unlock(&pipe->mutex);
+    wait_queue_wakeup(&pipe->wq);
+
+    if(release){
+        memory_free_pages((uint32_t)pipe->buf,PIPE_PAGES);
+        kfree(pipe);
+    }
+}
+
+int pipe_read(char* buf,int size,file_t* file){
+    return pipe_recv((pipe_t*)file->data,buf,size);
+}
+
+int pipe_write(char* buf,int size,file_t* file){
+    return pipe_send((pipe_t*)file->data,buf,size);
+}
+
+void pipe_close(file_t* file){
+    pipe_shutdown((pipe_t*)file->data,file->mode==O_RDONLY);
+    file->data=(void*)0;
+}
+
+int pipe_seek(file_t* file,uint32_t offset,int dir){
+    return -1;
+}
+
+int pipe_stat(file_t* file,struct stat* st){
+    pipe_t* pipe=(pipe_t*)file->data;
+
+    st->st_mode=S_IFIFO;
+    st->st_size=pipe->write_pos-pipe->read_pos;
+    st->st_blksize=PIPE_BUF_SIZE;
+    return 0;
+}
+
+int pipe_ioctl(file_t* file,int cmd,int arg0,int arg1){
+    return -1;
+}
+
+/**
+ * @brief 查询管道一端的读写状态
+ * @param pipe 管道
+ * @param reader 1为读端，0为写端
+ * @param table poll表
+ * @return 读端：有数据时POLLIN，写端全部关闭时POLLHUP；写端：有空间时POLLOUT，读端全部关闭时POLLERR
+ */
+int pipe_events(pipe_t* pipe,int reader,poll_table_t* table){
+    poll_wait(&pipe->wq,table);
+
+    // 只读取状态，不需要持有锁
+    uint32_t count=pipe->write_pos-pipe->read_pos;
+    int mask=0;
+    if(reader){
+        if(count){
+            mask|=POLLIN;
+        }
+        if(pipe->writers==0){
+            mask|=POLLHUP;
+        }
+    }
+    else{
+        if(pipe->readers==0){
+            mask|=POLLERR;
+        }
+        else if(count<PIPE_BUF_SIZE){
+            mask|=POLLOUT;
+        }
+    }
+    return mask;
+}
+
+int pipe_poll(file_t* file,poll_table_t* table){
+    return pipe_events((pipe_t*)file->data,file->mode==O_RDONLY,table);
+}
+
+/**
+ * @brief 初始化管道文件系统
+ */
+void pipe_fs_init(void){
+    kernel_memset(&pipe_fs,0,sizeof(fs_t));
+    kernel_strncpy(pipe_fs.mount_point,"pipe",FS_MOUNT_SIZE);
+    rwsem_init(&pipe_fs.rwsem);
+    pipe_fs.type=FS_PIPE;
+    pipe_fs.op=&pipe_op;
+}
+
+fs_op_t pipe_op={
+    .read=pipe_read,
+    .write=pipe_write,
+    .close=pipe_close,
+    .seek=pipe_seek,
+    .stat=pipe_stat,
+    .ioctl=pipe_ioctl,
+    .poll=pipe_poll,
+};
\ No newline at end of file
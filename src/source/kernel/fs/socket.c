@@ -0,0 +1,405 @@
+#include "fs/socket.h"
+#include "core/task.h"
+#include "core/kmalloc.h"
+#include "core/memory.h"
+#include "ipc/mutex.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+#include <sys/file.h>
+
+extern fs_op_t sock_op;
+
+/// @brief 套接字文件所属的文件系统，不挂载到任何路径，只能通过socket系统调用创建
+static fs_t sock_fs;
+
+/// @brief 已绑定名字的套接字，名字在此表中唯一
+static list_t sock_bound_list;
+
+/// @brief 保护名字表、监听队列和套接字的状态
+static mutex_t sock_mutex;
+
+/**
+ * @brief 创建一个未连接的套接字
+ * @return 套接字，失败返回0
+ */
+static sock_t* sock_alloc(void){
+    sock_t* sock=(sock_t*)kzalloc(sizeof(sock_t));
+    if(sock==(sock_t*)0){
+        log_printf("alloc socket failed");
+        return (sock_t*)0;
+    }
+
+    sock->state=SOCK_UNCONNECTED;
+    list_node_init(&sock->node);
+    list_node_init(&sock->accept_node);
+    list_init(&sock->accept_list);
+    sem_init(&sock->accept_sem,0);
+    wait_queue_init(&sock->wq);
+    return sock;
+}
+
+/**
+ * @brief 释放套接字，已连接的套接字关闭两个管道的本端
+ * @param sock 套接字，调用者已将其从名字表和监听队列中移除
+ */
+static void sock_free(sock_t* sock){
+    if(sock->state==SOCK_CONNECTED){
+        pipe_shutdown(sock->rx,1);
+        pipe_shutdown(sock->tx,0);
+    }
+    kfree(sock);
+}
+
+/**
+ * @brief 将套接字关联到文件并分配文件描述符
+ * @param sock 套接字
+ * @return 文件描述符，失败返回-1
+ */
+static int sock_alloc_fd(sock_t* sock){
+    file_t* file=file_alloc();
+    if(file==(file_t*)0){
+        return -1;
+    }
+
+    int fd=task_alloc_fd(file);
+    if(fd<0){
+        file_free(file);
+        return -1;
+    }
+
+    file->type=FILE_SOCKET;
+    file->mode=O_RDWR;
+    file->fs=&sock_fs;
+    file->data=sock;
+    kernel_strncpy(file->file_name,"socket",FILE_NAME_SIZE);
+    return fd;
+}
+
+/**
+ * @brief 获取文件描述符对应的套接字
+ * @param fd 文件描述符
+ * @return 套接字，不是套接字时返回0
+ */
+static sock_t* sock_from_fd(int fd){
+    file_t* file=task_file(fd);
+    if((file==(file_t*)0) || (file->type!=FILE_SOCKET)){
+        return (sock_t*)0;
+    }
+    return (sock_t*)file->data;
+}
+
+/**
+ * @brief 在名字表中查找套接字，调用者持有sock_mutex
+ * @param name 名字
+ * @return 套接字，没有找到返回0
+ */
+static sock_t* sock_find(const char* name){
+    list_node_t* node=list_first(&sock_bound_list);
+    while(node){
+        sock_t* sock=list_node_parent(node,sock_t,node);
+        if(kernel_strncmp(sock->name,name,SOCK_NAME_SIZE)==0){
+            return sock;
+        }
+        node=list_node_next(node);
+    }
+    return (sock_t*)0;
+}
+
+/**
+ * @brief 检查地址是否有效
+ * @param addr 地址
+ * @param len 地址的长度
+ * @return 1 有效，0 无效
+ */
+static int sock_addr_valid(const struct sockaddr_un* addr,int len){
+    if((addr==(const struct sockaddr_un*)0) || (len<(int)sizeof(struct sockaddr_un))){
+        return 0;
+    }
+    return (addr->sun_family==AF_LOCAL) && (addr->sun_path[0]!='\0');
+}
+
+/**
+ * @brief 创建套接字
+ * @param domain 只支持AF_LOCAL
+ * @param type 只支持SOCK_STREAM
+ * @param protocol 必须为0
+ * @return 文件描述符，失败返回-1
+ */
+int sys_socket(int domain,int type,int protocol){
+    if((domain!=AF_LOCAL) || (type!=SOCK_STREAM) || protocol){
+        return -1;
+    }
+
+    sock_t* sock=sock_alloc();
+    if(sock==(sock_t*)0){
+        return -1;
+    }
+
+    int fd=sock_alloc_fd(sock);
+    if(fd<0){
+        sock_free(sock);
+    }
+    return fd;
+}
+
+/**
+ * @brief 给套接字绑定名字，名字在套接字关闭时释放
+ * @param fd 文件描述符
+ * @param addr 地址，sun_path为名字
+ * @param len 地址的长度
+ * @return 0 成功，-1 失败
+ */
+int sys_bind(int fd,const struct sockaddr_un* addr,int len){
+    sock_t* sock=sock_from_fd(fd);
+    if((sock==(sock_t*)0) || !sock_addr_valid(addr,len)){
+        return -1;
+    }
+
+    int err=-1;
+    mutex_lock(&sock_mutex);
+    if(!sock->bound && (sock->state==SOCK_UNCONNECTED) && !sock_find(addr->sun_path)){
+        kernel_strncpy(sock->name,addr->sun_path,SOCK_NAME_SIZE);
+        sock->name[SOCK_NAME_SIZE-1]='\0';
+        list_insert_last(&sock_bound_list,&sock->node);
+        sock->bound=1;
+        err=0;
+    }
+    mutex_unlock(&sock_mutex);
+    return err;
+}
+
+/**
+ * @brief 开始监听已绑定名字的套接字
+ * @param fd 文件描述符
+ * @param backlog 未accept的连接数上限，超过时connect失败
+ * @return 0 成功，-1 失败
+ */
+int sys_listen(int fd,int backlog){
+    sock_t* sock=sock_from_fd(fd);
+    if(sock==(sock_t*)0){
+        return -1;
+    }
+
+    int err=-1;
+    mutex_lock(&sock_mutex);
+    if(sock->bound && (sock->state!=SOCK_CONNECTED)){
+        sock->state=SOCK_LISTENING;
+        sock->backlog=((backlog<=0) || (backlog>SOCK_BACKLOG_MAX)) ? SOCK_BACKLOG_MAX : backlog;
+        err=0;
+    }
+    mutex_unlock(&sock_mutex);
+    return err;
+}
+
+/**
+ * @brief 连接到监听中的套接字，连接加入监听队列后立即返回，不等待对方accept
+ * @param fd 文件描述符
+ * @param addr 监听套接字的地址
+ * @param len 地址的长度
+ * @return 0 成功，-1 失败
+ */
+int sys_connect(int fd,const struct sockaddr_un* addr,int len){
+    sock_t* sock=sock_from_fd(fd);
+    if((sock==(sock_t*)0) || !sock_addr_valid(addr,len)){
+        return -1;
+    }
+
+    // 分配可能等待，在持有锁之前完成
+    sock_t* peer=sock_alloc();
+    pipe_t* c2s=pipe_create();
+    pipe_t* s2c=pipe_create();
+    if(!peer || !c2s || !s2c){
+        goto connect_failed;
+    }
+
+    mutex_lock(&sock_mutex);
+    sock_t* listener=sock_find(addr->sun_path);
+    if((sock->state!=SOCK_UNCONNECTED) || (listener==(sock_t*)0)
+        || (listener->state!=SOCK_LISTENING) || (listener->pending>=listener->backlog)){
+        mutex_unlock(&sock_mutex);
+        goto connect_failed;
+    }
+
+    sock->rx=s2c;
+    sock->tx=c2s;
+    sock->state=SOCK_CONNECTED;
+    peer->rx=c2s;
+    peer->tx=s2c;
+    peer->state=SOCK_CONNECTED;
+
+    list_insert_last(&listener->accept_list,&peer->accept_node);
+    listener->pending++;
+    sem_notify(&listener->accept_sem);
+    mutex_unlock(&sock_mutex);
+
+    wait_queue_wakeup(&listener->wq);
+    return 0;
+
+connect_failed:
+    if(c2s){
+        pipe_shutdown(c2s,1);
+        pipe_shutdown(c2s,0);
+    }
+    if(s2c){
+        pipe_shutdown(s2c,1);
+        pipe_shutdown(s2c,0);
+    }
+    if(peer){
+        kfree(peer);
+    }
+    return -1;
+}
+
+/**
+ * @brief 取出一个已建立的连接，没有连接时等待
+ * @param fd 监听套接字的文件描述符
+ * @param addr 保存对方的地址，对方没有名字时sun_path为空，可以为0
+ * @param len 地址的长度，可以为0
+ * @return 新连接的文件描述符，失败返回-1
+ */
+int sys_accept(int fd,struct sockaddr_un* addr,int* len){
+    if((memory_check_user(addr,addr ? sizeof(struct sockaddr_un) : 0,1)<0)
+        || (memory_check_user(len,len ? sizeof(int) : 0,1)<0)){
+        return -1;
+    }
+
+    file_t* file=task_file(fd);
+    if((file==(file_t*)0) || (file->type!=FILE_SOCKET)
+        || (((sock_t*)file->data)->state!=SOCK_LISTENING)){
+        return -1;
+    }
+    sock_t* listener=(sock_t*)file->data;
+
+    // 等待期间持有监听套接字的引用，避免其它线程关闭后释放
+    file_inc_ref(file);
+    sem_wait(&listener->accept_sem);
+
+    mutex_lock(&sock_mutex);
+    list_node_t* node=list_remove_first(&listener->accept_list);
+    if(node){
+        listener->pending--;
+    }
+    mutex_unlock(&sock_mutex);
+    fs_close_file(file);
+
+    if(node==(list_node_t*)0){
+        return -1;
+    }
+
+    sock_t* sock=list_node_parent(node,sock_t,accept_node);
+    int new_fd=sock_alloc_fd(sock);
+    if(new_fd<0){
+        sock_free(sock);
+        return -1;
+    }
+
+    if(addr && len && (*len>=(int)sizeof(struct sockaddr_un))){
+        kernel_memset(addr,0,sizeof(struct sockaddr_un));
+        addr->sun_family=AF_LOCAL;
+        *len=sizeof(struct sockaddr_un);
+    }
+    return new_fd;
+}
+
+int sock_read(char* buf,int size,file_t* file){
+    sock_t* sock=(sock_t*)file->data;
+    if(sock->state!=SOCK_CONNECTED){
+        return -1;
+    }
+    return pipe_recv(sock->rx,buf,size);
+}
+
+int sock_write(char* buf,int size,file_t* file){
+    sock_t* sock=(sock_t*)file->data;
+    if(sock->state!=SOCK_CONNECTED){
+        return -1;
+    }
+    return pipe_send(sock->tx,buf,size);
+}
+
+/**
+ * @brief 关闭套接字，监听套接字同时关闭尚未accept的连接，对方将读到文件结束
+ */
+void sock_close(file_t* file){
+    sock_t* sock=(sock_t*)file->data;
+
+    mutex_lock(&sock_mutex);
+    if(sock->bound){
+        list_remove(&sock_bound_list,&sock->node);
+        sock->bound=0;
+    }
+
+    list_t pending;
+    list_init(&pending);
+    list_node_t* node;
+    while((node=list_remove_first(&sock->accept_list))!=(list_node_t*)0){
+        list_insert_last(&pending,node);
+    }
+    sock->pending=0;
+    mutex_unlock(&sock_mutex);
+
+    while((node=list_remove_first(&pending))!=(list_node_t*)0){
+        sock_free(list_node_parent(node,sock_t,accept_node));
+    }
+
+    sock_free(sock);
+    file->data=(void*)0;
+}
+
+int sock_seek(file_t* file,uint32_t offset,int dir){
+    return -1;
+}
+
+int sock_stat(file_t* file,struct stat* st){
+    st->st_mode=S_IFSOCK;
+    st->st_blksize=PIPE_BUF_SIZE;
+    return 0;
+}
+
+int sock_ioctl(file_t* file,int cmd,int arg0,int arg1){
+    return -1;
+}
+
+/**
+ * @brief 查询套接字的读写状态
+ * @return 监听套接字有连接时POLLIN；已连接的套接字为接收和发送两个管道的状态之和
+ */
+int sock_poll(file_t* file,poll_table_t* table){
+    sock_t* sock=(sock_t*)file->data;
+
+    switch(sock->state){
+        case SOCK_LISTENING:
+            poll_wait(&sock->wq,table);
+            return sock->pending ? POLLIN : 0;
+        case SOCK_CONNECTED:
+            return pipe_events(sock->rx,1,table) | pipe_events(sock->tx,0,table);
+        default:
+            poll_wait(&sock->wq,table);
+            return 0;
+    }
+}
+
+/**
+ * @brief 初始化套接字文件系统和名字表
+ */
+void socket_init(void){
+    list_init(&sock_bound_list);
+    mutex_init(&sock_mutex);
+
+    kernel_memset(&sock_fs,0,sizeof(fs_t));
+    kernel_strncpy(sock_fs.mount_point,"socket",FS_MOUNT_SIZE);
+    rwsem_init(&sock_fs.rwsem);
+    sock_fs.type=FS_SOCKET;
+    sock_fs.op=&sock_op;
+}
+
+fs_op_t sock_op={
+    .read=sock_read,
+    .write=sock_write,
+    .close=sock_close,
+    .seek=sock_seek,
+    .stat=sock_stat,
+    .ioctl=sock_ioctl,
+    .poll=sock_poll,
+};
\ No newline at end of file
@@ -0,0 +1,12 @@
+#ifndef BOOTTIME_H
+#define BOOTTIME_H
+
+#include "comm/types.h"
+#include "comm/boot_info.h"
+#include "applib/lib_syscall.h"
+
+void boot_time_init(boot_info_t* boot_info);
+void boot_time_mark(const char* name);
+void boot_time_finish(const char* name);
+int sys_boot_time(boot_phase_t* buf,int count);
+#endif
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef KMALLOC_H
+#define KMALLOC_H
+
+#include "comm/types.h"
+#include "tools/list.h"
+
+/// @brief 最小分配块为16字节，最大为2048字节，更大的请求直接按页分配
+#define KMALLOC_MIN_SHIFT       4
+#define KMALLOC_MAX_SHIFT       11
+#define KMALLOC_CLASS_NR        (KMALLOC_MAX_SHIFT-KMALLOC_MIN_SHIFT+1)
+
+/// @brief 按页分配的内存块的order标记
+#define KMALLOC_ORDER_PAGE      0
+
+/**
+ * @brief 分配块的头部，位于返回给调用者的地址之前
+ * @param order 分配块大小为(1<<order)，按页分配时为KMALLOC_ORDER_PAGE
+ * @param pages 按页分配时占用的页数
+ */
+typedef struct _kmalloc_hdr_t{
+    uint32_t order;
+    uint32_t pages;
+}kmalloc_hdr_t;
+
+void kmalloc_init(void);
+void* kmalloc(uint32_t size);
+void* kzalloc(uint32_t size);
+void kfree(void* ptr);
+#endif
\ No newline at end of file
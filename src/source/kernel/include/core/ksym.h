@@ -0,0 +1,33 @@
+#ifndef KSYM_H
+#define KSYM_H
+
+#include "comm/types.h"
+
+/// @brief 为内核符号表预留的空间，构建后由script/ksym-gen.py生成并填入.ksyms段
+#define KSYM_AREA_SIZE      (20*1024)
+
+/// @brief 符号表头部的标识，"KSYM"
+#define KSYM_MAGIC          0x4D59534B
+
+/**
+ * @brief 符号表的头部，后面紧跟count个按地址升序排列的表项
+ */
+typedef struct _ksym_header_t{
+    uint32_t magic;
+    uint32_t count;
+}ksym_header_t;
+
+/**
+ * @brief 符号表项
+ * @param addr 函数的起始地址
+ * @param name 函数名相对符号表起始的偏移
+ */
+typedef struct _ksym_entry_t{
+    uint32_t addr;
+    uint32_t name;
+}ksym_entry_t;
+
+void ksym_init(void);
+uint32_t ksym_find(uint32_t addr,const char** name);
+int sys_ksym_lookup(uint32_t addr,char* name,int size);
+#endif
\ No newline at end of file
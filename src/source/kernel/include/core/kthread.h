@@ -0,0 +1,13 @@
+#ifndef KTHREAD_H
+#define KTHREAD_H
+
+#include "core/task.h"
+
+/// @brief 内核线程的入口函数类型
+typedef void (*kthread_fn_t)(void* arg);
+
+task_t* kthread_create(const char* name,kthread_fn_t fn,void* arg);
+int kthread_stop(task_t* task);
+int kthread_should_stop(void);
+void kthread_exit(int status);
+#endif
\ No newline at end of file
@@ -12,6 +12,10 @@
 #define MEM_PAGE_SIZE       4096
 #define MEMORY_TASK_BASE    0x80000000
 
+/// @brief 内核中映射设备寄存器和BIOS表的区域，占用用户空间之下的一个页表
+#define MEM_MMIO_START      (MEMORY_TASK_BASE - 4*1024*1024)
+#define MEM_MMIO_END        MEMORY_TASK_BASE
+
 #define MEM_TASK_STACK_TOP  0xE0000000
 #define MEM_TASK_STACK_SIZE (MEM_PAGE_SIZE*500)
 #define MEM_TASK_ARG_SIZE   (MEM_PAGE_SIZE*4)
@@ -31,17 +35,44 @@ typedef struct _memory_map_t{
     uint32_t perm;
 }memory_map_t;
 
+/**
+ * @brief 描述一个用户地址空间，同一进程的线程共享同一个mm_t
+ * @param page_dir 页目录表的物理地址
+ * @param heap_start 堆的起始地址
+ * @param heap_end 堆的结束地址
+ * @param ref 引用计数，减为0时销毁页表
+ * @param mutex 保护堆的修改，多个线程可能同时调用sbrk
+ * @param aio 异步I/O上下文，没有创建异步I/O环时为0
+ */
+typedef struct _mm_t{
+    uint32_t page_dir;
+    uint32_t heap_start;
+    uint32_t heap_end;
+    int ref;
+    mutex_t mutex;
+    struct _aio_ctx_t* aio;
+}mm_t;
+
 void memory_init(boot_info_t* boot_info);
 
 int memory_alloc_page_for(uint32_t addr,uint32_t size,int perm);
 int memory_alloc_for_page_dir(uint32_t page_dir,uint32_t vaddr,uint32_t size,int perm);
 uint32_t memory_alloc_page(void);
 void memory_free_page(uint32_t addr);
+uint32_t memory_alloc_pages(int page_count);
+void memory_free_pages(uint32_t addr,int page_count);
 
+uint32_t memory_kernel_page_dir(void);
+void* memory_map_mmio(uint32_t paddr,uint32_t size);
 uint32_t memory_create_uvm(void);
 void memory_destroy_uvm(uint32_t page_dir);
 uint32_t memory_copy_uvm(uint32_t page_dir);
+mm_t* mm_create(uint32_t page_dir);
+mm_t* mm_get(mm_t* mm);
+void mm_put(mm_t* mm);
 uint32_t memory_get_paddr(uint32_t page_dir,uint32_t vaddr);
+uint32_t memory_get_user_paddr(uint32_t page_dir,uint32_t vaddr,int write);
+int memory_check_user(const void* addr,uint32_t size,int write);
 int memory_copy_uvm_data(uint32_t to,uint32_t page_dir,uint32_t from,uint32_t size);
 
 char* sys_sbrk(int incr);
@@ -0,0 +1,22 @@
+#ifndef PID_H
+#define PID_H
+
+#include "comm/types.h"
+#include "tools/list.h"
+
+struct _task_t;
+
+/// @brief 可分配的最大pid，pid 0保留表示空闲任务
+#define PID_MAX             32768
+
+/// @brief pid哈希表的桶数量，必须是2的幂
+#define PID_HASH_SIZE       256
+
+void pid_init(void);
+int pid_alloc(void);
+void pid_free(int pid);
+
+void pid_hash_insert(struct _task_t* task);
+void pid_hash_remove(struct _task_t* task);
+struct _task_t* pid_find_task(int pid);
+#endif
\ No newline at end of file
@@ -0,0 +1,11 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "comm/types.h"
+#include "cpu/irq.h"
+#include "applib/lib_syscall.h"
+
+void prof_tick(exception_frame_t* frame);
+int sys_prof_ctl(int cmd,int period_ms);
+int sys_prof_read(prof_sample_t* buf,int start,int count,prof_info_t* info);
+#endif
\ No newline at end of file
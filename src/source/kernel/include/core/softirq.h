@@ -0,0 +1,49 @@
+#ifndef SOFTIRQ_H
+#define SOFTIRQ_H
+
+#include "comm/types.h"
+#include "tools/list.h"
+
+/// @brief 软中断编号，编号越小越先处理
+#define SOFTIRQ_TIMER           0
+#define SOFTIRQ_TASKLET         1
+#define SOFTIRQ_NR              2
+
+/// @brief 中断退出时最多重复处理软中断的轮数，超过后交给ksoftirqd
+#define SOFTIRQ_MAX_RESTART     8
+
+/// @brief tasklet已在队列中等待执行
+#define TASKLET_STATE_SCHED     (1<<0)
+
+/// @brief 软中断的处理函数类型
+typedef void (*softirq_fn_t)(void);
+
+struct _tasklet_t;
+
+/// @brief tasklet的处理函数类型
+typedef void (*tasklet_fn_t)(struct _tasklet_t* tasklet);
+
+/**
+ * @brief tasklet，在软中断上下文中执行的下半部，通常嵌入到驱动的结构体中
+ * @param node 挂在tasklet队列上的结点
+ * @param func 处理函数，执行时中断已打开，但不允许睡眠
+ * @param state TASKLET_STATE_xxx
+ */
+typedef struct _tasklet_t{
+    list_node_t node;
+    tasklet_fn_t func;
+    int state;
+}tasklet_t;
+
+void softirq_init(void);
+void ksoftirqd_init(void);
+void softirq_register(int nr,softirq_fn_t func);
+void softirq_raise(int nr);
+int in_interrupt(void);
+
+void irq_enter(void);
+void irq_exit(void);
+
+void tasklet_init(tasklet_t* tasklet,tasklet_fn_t func);
+int tasklet_schedule(tasklet_t* tasklet);
+#endif
\ No newline at end of file
@@ -12,6 +12,25 @@
 #define SYS_YIELD          4
 #define SYS_EXIT           5
 #define SYS_WAIT           6
+#define SYS_WAITPID        7
+#define SYS_TASK_INFO      8
+#define SYS_SYS_INFO       9
+#define SYS_SCHED_LAT      10
+#define SYS_CLOCK_GETTIME  11
+#define SYS_GETTIMEOFDAY   12
+#define SYS_THREAD_CREATE  13
+#define SYS_THREAD_JOIN    14
+#define SYS_FUTEX          15
+#define SYS_SETPRIO        16
+#define SYS_IRQOFF_TRACE   17
+#define SYS_BATCH          18
+#define SYS_SYSCALL_CTL    19
+#define SYS_SYSCALL_STAT   20
+#define SYS_SYSCALL_TRACE  21
+#define SYS_PROF_CTL       22
+#define SYS_PROF_READ      23
+#define SYS_KSYM_LOOKUP    24
+#define SYS_BOOT_TIME      25
 
 #define SYS_OPEN           50
 #define SYS_READ           51
@@ -30,6 +49,15 @@
 #define SYS_READDIR        61
 #define SYS_CLOSEDIR       62
 #define SYS_UNLINK         63
+#define SYS_PIPE           64
+#define SYS_POLL           65
+#define SYS_AIO_SETUP      66
+#define SYS_AIO_ENTER      67
+#define SYS_SOCKET         68
+#define SYS_BIND           69
+#define SYS_LISTEN         70
+#define SYS_ACCEPT         71
+#define SYS_CONNECT        72
           
 
 typedef struct _syscall_frame_t{
@@ -42,5 +70,10 @@ typedef struct _syscall_frame_t{
 }syscall_frame_t;
 
 void exception_handler_syscall(void);
+void exception_handler_sysenter(void);
+
+struct _task_t;
+void syscall_init(void);
+void syscall_track_free(struct _task_t* task);
 
 #endif
\ No newline at end of file
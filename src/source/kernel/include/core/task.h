@@ -10,22 +10,67 @@
 #include "comm/cpu_instr.h"
 #include "cpu/irq.h"
 #include "fs/file.h"
+#include "applib/lib_syscall.h"
 
 #define TASK_NAME_SIZE 32
 #define TASK_TIME_SLICE_DEFAULT 10
 
 #define TASK_FLAGS_SYSTEM       (1 << 0)
 
-/// @brief 打开的文件表数量
-#define TASK_OFILE_NR 128
+/// @brief 内核线程，只运行在内核态，没有用户地址空间
+#define TASK_FLAGS_KTHREAD      (1 << 1)
+
+/// @brief 用户线程，与创建者共享地址空间和打开文件表
+#define TASK_FLAGS_THREAD       (1 << 2)
+
+/// @brief 任务优先级，数值越小优先级越高
+#define TASK_PRIO_HIGHEST       0
+#define TASK_PRIO_LOWEST        31
+#define TASK_PRIO_DEFAULT       16
+
+/// @brief 计算平均负载的周期，单位为tick
+#define TASK_LOAD_FREQ          (5000/OS_TICK_MS)
+
+/// @brief 平均负载的定点数表示，与Linux的计算方法相同
+#define FSHIFT                  11
+#define FIXED_1                 (1 << FSHIFT)
+#define EXP_1                   1884
+#define EXP_5                   2014
+#define EXP_15                  2037
+
+/// @brief waitpid的选项，没有已结束的子进程时立即返回，与newlib的WNOHANG一致
+#define WAIT_NOHANG             1
+
+/// @brief waitpid的选项，只返回已结束的子进程而不回收，之后仍可读取其状态
+#define WAIT_NOWAIT             4
+
+/// @brief 打开的文件表的初始大小，不够时成倍扩大
+#define TASK_OFILE_INIT 8
+
+/// @brief 打开的文件表的最大大小
+#define TASK_OFILE_NR 1024
+
+/**
+ * @brief 打开文件表，同一进程的线程共享
+ * @param table 文件指针数组，按需扩大
+ * @param size 文件表的大小
+ * @param ref 引用计数，减为0时关闭所有文件
+ */
+typedef struct _files_t{
+    file_t** table;
+    int size;
+    int ref;
+}files_t;
+
+struct _mm_t;
+struct _mutex_t;
 
 /**
  * @brief 描述任务的结构体
  * @param state 任务的状态
  * @param pid 任务的pid
  * @param parent 任务的父进程
- * @param heap_start 任务的堆的起始地址
- * @param heap_end 任务的堆的结束地址
+ * @param mm 任务的用户地址空间，内核线程为0
  * @param sleep_ticks 任务的睡眠时间片
  * @param slice_ticks 任务的时间片
  * @param time_ticks 任务的时间片
@@ -33,10 +78,29 @@
  * @param run_node 任务在就绪队列中的节点
  * @param all_node 任务在所有任务链表中的节点
  * @param wait_node 任务在等待队列中的节点
+ * @param pid_node 任务在pid哈希表中的节点
+ * @param child_list 任务的子进程链表
+ * @param child_node 任务在父进程子进程链表中的节点
  * @param tss 任务的TSS结构体
  * @param tss_sel 任务的TSS选择子
- * @param file_table 任务的打开文件表
+ * @param files 任务的打开文件表
  * @param status 任务的状态值，注意与state的区别
+ * @param flags 任务创建时的标志位
+ * @param should_stop 内核线程是否被要求退出
+ * @param utime 任务在用户态运行的tick数
+ * @param stime 任务在内核态运行的tick数
+ * @param nvcsw 主动让出cpu的次数
+ * @param nivcsw 被抢占的次数
+ * @param wait_ticks 在就绪队列中等待的tick数
+ * @param ready_tick 最近一次进入就绪队列的时间
+ * @param ready_tsc 最近一次进入就绪队列时的时间戳计数
+ * @param sched_lat 任务的调度延迟统计
+ * @param fpu_state 浮点状态保存区，第一次使用浮点指令时才分配
+ * @param prio 当前的优先级，可能因优先级继承而高于base_prio
+ * @param base_prio 任务自身的优先级
+ * @param held_list 持有的互斥锁链表，用于解锁时恢复优先级
+ * @param blocked_on 正在等待的互斥锁，用于链式传递优先级
+ * @param sys_track 系统调用的统计和跟踪记录，未开启时为0
  */
 typedef struct _task_t{
     enum{
@@ -50,8 +114,7 @@ typedef struct _task_t{
 
     int pid;
     struct _task_t* parent;
-    uint32_t heap_start;
-    uint32_t heap_end;
+    struct _mm_t* mm;
 
     int sleep_ticks;
     int slice_ticks;
@@ -59,16 +122,42 @@ typedef struct _task_t{
 
     char name[TASK_NAME_SIZE];
 
-    file_t* file_table[TASK_OFILE_NR];
+    files_t* files;
 
     list_node_t run_node;
     list_node_t all_node;
     list_node_t wait_node;
+    list_node_t pid_node;
+
+    list_t child_list;
+    list_node_t child_node;
 
     tss_t tss;
     int tss_sel;
 
     int status;
+
+    int flags;
+    int should_stop;
+
+    uint32_t utime;
+    uint32_t stime;
+    uint32_t nvcsw;
+    uint32_t nivcsw;
+    uint32_t wait_ticks;
+    uint32_t ready_tick;
+
+    uint64_t ready_tsc;
+    sched_lat_t sched_lat;
+
+    void* fpu_state;
+
+    int prio;
+    int base_prio;
+    list_t held_list;
+    struct _mutex_t* blocked_on;
+
+    struct _syscall_track_t* sys_track;
 }task_t;
 
 typedef struct _task_arg_t{
@@ -89,6 +178,17 @@ typedef struct _task_manager_t{
 
     int app_code_sel;
     int app_data_sel;
+
+    int task_count;
+    int task_limit;
+
+    uint32_t load_ticks;
+    uint32_t loadavg[3];
+
+    uint32_t pending_ticks;
+    int need_resched;
+
+    sched_lat_t sched_lat;
 }task_manager_t;
 
 void task_manager_init(void);
@@ -99,12 +199,14 @@ void task_switch_from_to(task_t*from,task_t*to);
 task_t* task_first_task(void);
 void task_set_ready(task_t* task);
 void task_set_block(task_t*task);
+void task_set_prio(task_t* task,int prio);
 void task_start(task_t* task);
 int sys_sched_yield(void);
 void task_dispatch(void);
+void task_resched(void);
 task_t* task_current(void);
 task_t* task_next_run(void);
-void task_time_tick(void);
+void task_time_tick(int user_mode);
 
 void task_set_sleep(task_t* task,uint32_t ticks);
 void task_set_wakeup(task_t*task);
@@ -112,6 +214,8 @@ void sys_msleep(uint32_t ms);
 int sys_getpid(void);
 int sys_fork(void);
 int sys_execve(char* name,char** argv,char** env);
+int sys_thread_create(uint32_t entry,uint32_t arg,uint32_t stack_top);
+int sys_thread_join(int tid,int* status);
 
 
 int task_alloc_fd(file_t* file);
@@ -120,5 +224,17 @@ file_t* task_file(int fd);
 
 void sys_exit(int status);
 
+task_t* alloc_task(void);
+int task_set_limit(int limit);
+void free_task(task_t* task);
+void task_uninit(task_t* task);
+void task_set_parent(task_t* task,task_t* parent);
+
 int sys_wait(int* status);
+int sys_waitpid(int pid,int* status,int options);
+
+int sys_get_task_info(task_info_t* info,int count);
+int sys_get_sys_info(sys_info_t* info);
+int sys_sched_lat(int pid,sched_lat_t* lat,int reset);
+int sys_setprio(int pid,int prio);
 #endif
\ No newline at end of file
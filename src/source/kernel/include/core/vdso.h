@@ -0,0 +1,13 @@
+#ifndef VDSO_H
+#define VDSO_H
+
+#include "comm/types.h"
+#include "applib/lib_syscall.h"
+
+void vdso_init(void);
+uint32_t vdso_paddr(void);
+vdso_data_t* vdso_data(void);
+void vdso_write_begin(vdso_data_t* vdso);
+void vdso_write_end(vdso_data_t* vdso);
+void vdso_set_pid(int pid);
+#endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef WORKQUEUE_H
+#define WORKQUEUE_H
+
+#include "tools/list.h"
+#include "ipc/sem.h"
+#include "core/kthread.h"
+
+struct _work_t;
+
+/// @brief 工作项的处理函数类型
+typedef void (*work_fn_t)(struct _work_t* work);
+
+/**
+ * @brief 工作项，通常嵌入到使用者的结构体中
+ * @param node 挂在工作队列上的结点
+ * @param func 处理函数，在工作线程中执行
+ * @param pending 工作项是否已在队列中等待执行
+ */
+typedef struct _work_t{
+    list_node_t node;
+    work_fn_t func;
+    int pending;
+}work_t;
+
+/**
+ * @brief 工作队列，由一个内核线程依次执行队列中的工作项
+ * @param work_list 等待执行的工作项
+ * @param sem 工作项计数，工作线程在此等待
+ * @param worker 工作线程
+ * @param stopping 工作队列正在销毁，不再接收新的工作项
+ */
+typedef struct _workqueue_t{
+    list_t work_list;
+    sem_t sem;
+    task_t* worker;
+    int stopping;
+}workqueue_t;
+
+void work_init(work_t* work,work_fn_t func);
+int workqueue_create(workqueue_t* wq,const char* name);
+void workqueue_destroy(workqueue_t* wq);
+int queue_work(workqueue_t* wq,work_t* work);
+int schedule_work(work_t* work);
+
+void workqueue_init(void);
+#endif
\ No newline at end of file
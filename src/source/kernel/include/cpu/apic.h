@@ -0,0 +1,210 @@
+#ifndef APIC_H
+#define APIC_H
+
+#include "comm/types.h"
+
+/// @brief cpuid功能号1返回的edx中的APIC特性位
+#define CPUID_EDX_APIC          (1 << 9)
+
+/// @brief IA32_APIC_BASE寄存器及其全局使能位
+#define MSR_APIC_BASE           0x1B
+#define MSR_APIC_BASE_ENABLE    (1 << 11)
+
+/// @brief 默认的LAPIC和IOAPIC物理地址
+#define LAPIC_DEFAULT_ADDR      0xFEE00000
+#define IOAPIC_DEFAULT_ADDR     0xFEC00000
+
+/// @brief LAPIC寄存器偏移
+#define LAPIC_ID                0x020
+#define LAPIC_TPR               0x080
+#define LAPIC_EOI               0x0B0
+#define LAPIC_SVR               0x0F0
+#define LAPIC_ESR               0x280
+#define LAPIC_LVT_TIMER         0x320
+#define LAPIC_LVT_LINT0         0x350
+#define LAPIC_LVT_LINT1         0x360
+#define LAPIC_LVT_ERROR         0x370
+#define LAPIC_TIMER_INIT        0x380
+#define LAPIC_TIMER_CURR        0x390
+#define LAPIC_TIMER_DIV         0x3E0
+
+#define LAPIC_SVR_ENABLE        (1 << 8)
+#define LAPIC_LVT_MASKED        (1 << 16)
+#define LAPIC_LVT_NMI           (4 << 8)
+#define LAPIC_TIMER_PERIODIC    (1 << 17)
+#define LAPIC_TIMER_DIV16       0x3
+
+/// @brief LAPIC伪中断的向量号，低4位需全为1，且需在IDT_TABLE_NR范围内
+#define APIC_SPURIOUS_VECTOR    0x7F
+
+/// @brief 校准LAPIC定时器时等待的时长
+#define LAPIC_CALIBRATE_MS      10
+
+/// @brief IOAPIC的寄存器选择和数据窗口，以及版本寄存器和重定向表
+#define IOAPIC_REGSEL           0x00
+#define IOAPIC_WIN              0x10
+#define IOAPIC_REG_VER          0x01
+#define IOAPIC_REG_REDTBL       0x10
+
+#define IOAPIC_POLARITY_LOW     (1 << 13)
+#define IOAPIC_TRIGGER_LEVEL    (1 << 15)
+#define IOAPIC_MASKED           (1 << 16)
+
+/// @brief ISA总线的中断数量
+#define ISA_IRQ_NR              16
+
+/// @brief IMCR寄存器，MP表中标记时需将中断从8259切换到APIC
+#define IMCR_ADDR_PORT          0x22
+#define IMCR_DATA_PORT          0x23
+#define IMCR_SELECT             0x70
+#define IMCR_APIC               0x01
+
+/// @brief BIOS数据区中EBDA段地址的位置，以及ACPI和MP表的搜索区域
+#define BDA_EBDA_SEG            0x40E
+#define BIOS_ROM_START          0xE0000
+#define BIOS_ROM_END            0x100000
+
+/// @brief MPS/ACPI中断标志中的极性和触发方式
+#define INTI_POLARITY_MASK      0x3
+#define INTI_POLARITY_LOW       0x3
+#define INTI_TRIGGER_MASK       (0x3 << 2)
+#define INTI_TRIGGER_LEVEL      (0x3 << 2)
+
+#pragma pack(1)
+/**
+ * @brief ACPI的根系统描述指针
+ */
+typedef struct _acpi_rsdp_t{
+    char signature[8];
+    uint8_t checksum;
+    char oem_id[6];
+    uint8_t revision;
+    uint32_t rsdt_addr;
+}acpi_rsdp_t;
+
+/**
+ * @brief ACPI系统描述表的公共表头
+ */
+typedef struct _acpi_sdt_t{
+    char signature[4];
+    uint32_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+}acpi_sdt_t;
+
+/**
+ * @brief ACPI的MADT表，表头后为变长的中断控制器结构
+ */
+typedef struct _acpi_madt_t{
+    acpi_sdt_t header;
+    uint32_t lapic_addr;
+    uint32_t flags;
+}acpi_madt_t;
+
+/// @brief MADT中的结构类型
+#define MADT_TYPE_IOAPIC        1
+#define MADT_TYPE_OVERRIDE      2
+
+typedef struct _madt_entry_t{
+    uint8_t type;
+    uint8_t length;
+}madt_entry_t;
+
+typedef struct _madt_ioapic_t{
+    madt_entry_t header;
+    uint8_t id;
+    uint8_t reserved;
+    uint32_t addr;
+    uint32_t gsi_base;
+}madt_ioapic_t;
+
+typedef struct _madt_override_t{
+    madt_entry_t header;
+    uint8_t bus;
+    uint8_t source;
+    uint32_t gsi;
+    uint16_t flags;
+}madt_override_t;
+
+/**
+ * @brief MP浮动指针结构
+ */
+typedef struct _mp_float_t{
+    char signature[4];
+    uint32_t config_addr;
+    uint8_t length;
+    uint8_t spec_rev;
+    uint8_t checksum;
+    uint8_t feature1;
+    uint8_t feature2;
+    uint8_t reserved[3];
+}mp_float_t;
+
+/// @brief feature2中表示存在IMCR寄存器的位
+#define MP_FEATURE2_IMCRP       (1 << 7)
+
+/**
+ * @brief MP配置表的表头，之后为entry_count个表项
+ */
+typedef struct _mp_config_t{
+    char signature[4];
+    uint16_t length;
+    uint8_t spec_rev;
+    uint8_t checksum;
+    char oem_id[8];
+    char product_id[12];
+    uint32_t oem_table;
+    uint16_t oem_table_size;
+    uint16_t entry_count;
+    uint32_t lapic_addr;
+    uint16_t ext_length;
+    uint8_t ext_checksum;
+    uint8_t reserved;
+}mp_config_t;
+
+/// @brief MP配置表的表项类型，处理器表项为20字节，其余为8字节
+#define MP_ENTRY_PROCESSOR      0
+#define MP_ENTRY_BUS            1
+#define MP_ENTRY_IOAPIC         2
+#define MP_ENTRY_IOINT          3
+#define MP_ENTRY_LOCALINT       4
+
+typedef struct _mp_bus_t{
+    uint8_t type;
+    uint8_t bus_id;
+    char bus_type[6];
+}mp_bus_t;
+
+typedef struct _mp_ioapic_t{
+    uint8_t type;
+    uint8_t id;
+    uint8_t version;
+    uint8_t flags;
+    uint32_t addr;
+}mp_ioapic_t;
+
+typedef struct _mp_ioint_t{
+    uint8_t type;
+    uint8_t int_type;
+    uint16_t flags;
+    uint8_t src_bus;
+    uint8_t src_irq;
+    uint8_t dst_ioapic;
+    uint8_t dst_intin;
+}mp_ioint_t;
+#pragma pack()
+
+void apic_init(void);
+int apic_active(void);
+void lapic_eoi(void);
+int lapic_timer_init(int vector,uint32_t ms);
+void ioapic_enable_irq(int irq);
+void ioapic_disable_irq(int irq);
+
+void exception_handler_spurious(void);
+#endif
\ No newline at end of file
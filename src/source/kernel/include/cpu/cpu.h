@@ -110,11 +110,20 @@ typedef struct _gate_desc_t{
 /// @brief 开中断
 #define EFLAGS_IF      (1<<9)
 
+/// @brief cpuid功能号1返回的edx中的SYSENTER/SYSEXIT特性位
+#define CPUID_EDX_SEP           (1 << 11)
+
+/// @brief SYSENTER使用的代码段、栈和入口地址
+#define MSR_SYSENTER_CS         0x174
+#define MSR_SYSENTER_ESP        0x175
+#define MSR_SYSENTER_EIP        0x176
+
 void cpu_init(void);
 void segment_desc_set(int selector,uint32_t base,uint32_t limit,uint16_t attr);
 void gate_desc_set(gate_desc_t* desc,uint16_t selector,uint32_t offset,uint16_t attr);
 int gdt_alloc_desc();
 void gdt_free_sel(int tss_sel);
+void cpu_set_sysenter_stack(uint32_t esp0);
 typedef struct _tss_t{
     uint32_t pre_link;
     uint32_t esp0,ss0,esp1,ss1,esp2,ss2;
@@ -0,0 +1,32 @@
+#ifndef FPU_H
+#define FPU_H
+
+#include "comm/types.h"
+#include "core/task.h"
+
+/// @brief cr0寄存器中与浮点单元相关的位
+#define CR0_MP              (1 << 1)
+#define CR0_EM              (1 << 2)
+#define CR0_TS              (1 << 3)
+#define CR0_NE              (1 << 5)
+
+/// @brief cr4寄存器中开启SSE的位
+#define CR4_OSFXSR          (1 << 9)
+#define CR4_OSXMMEXCPT      (1 << 10)
+
+/// @brief cpuid功能号1返回的edx中的特性位
+#define CPUID_EDX_FPU       (1 << 0)
+#define CPUID_EDX_FXSR      (1 << 24)
+#define CPUID_EDX_SSE       (1 << 25)
+
+/// @brief FXSAVE保存区的大小，需要16字节对齐
+#define FPU_STATE_SIZE      512
+
+/// @brief MXCSR的默认值，屏蔽所有SSE异常
+#define MXCSR_DEFAULT       0x1F80
+
+void fpu_init(void);
+int fpu_device_unavailable(void);
+int fpu_copy(task_t* to,task_t* from);
+void fpu_release(task_t* task);
+#endif
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "comm/cpu_instr.h"
 #include "os_cfg.h"
 #include "tools/log.h"
+#include "applib/lib_syscall.h"
 
 // 设置中断号码
 #define IRQ0_DE             0
@@ -121,4 +122,8 @@ typedef uint32_t irq_state_t;
 
 irq_state_t irq_enter_protection(void);
 void irq_leave_protection(irq_state_t state);
+
+void irqoff_trace_begin(uint32_t ip);
+void irqoff_trace_end(uint32_t ip);
+int sys_irqoff_trace(irqoff_info_t* info,int flags);
 #endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include "comm/types.h"
+#include "applib/lib_syscall.h"
+
+#define NSEC_PER_SEC            1000000000
+#define NSEC_PER_MSEC           1000000
+#define NSEC_PER_USEC           1000
+
+/// @brief PIT通道2，用于校准TSC，其门控和输出状态通过0x61端口控制和读取
+#define PIT_CHANNEL2_DATA_PORT  0x42
+#define PIT_CHANNEL2            (2 << 6)
+#define PIT_MODE0               (0 << 1)
+#define PIT_GATE_PORT           0x61
+#define PIT_GATE2_ENABLE        (1 << 0)
+#define PIT_SPEAKER_ENABLE      (1 << 1)
+#define PIT_OUT2_HIGH           (1 << 5)
+
+/// @brief 校准TSC时PIT计数的时长
+#define CLOCK_CALIBRATE_MS      50
+
+/// @brief 周期数转换为纳秒时使用的移位数，ns=(cycles*mult)>>shift
+#define CLOCK_SHIFT             22
+
+/// @brief cpuid功能号1返回的edx中的TSC特性位
+#define CPUID_EDX_TSC           (1 << 4)
+
+/**
+ * @brief 时钟源，在每个时钟中断中累加单调时间
+ * @param name 时钟源名称
+ * @param khz 计数频率，单位kHz，为0表示没有可用的TSC
+ * @param mult 周期数转换为纳秒的乘数
+ * @param shift 周期数转换为纳秒的移位数
+ * @param cycle_last 上一次更新时的计数值
+ * @param mono_ns 上一次更新时的单调时间，单位纳秒
+ * @param boot_sec 启动时RTC的墙上时间，1970年以来的秒数
+ */
+typedef struct _clocksource_t{
+    const char* name;
+    uint32_t khz;
+    uint32_t mult;
+    uint32_t shift;
+    uint64_t cycle_last;
+    uint64_t mono_ns;
+    uint32_t boot_sec;
+}clocksource_t;
+
+void clock_init(void);
+void clock_tick(void);
+uint64_t clock_monotonic_ns(void);
+uint64_t clock_cycles_to_ns(uint64_t cycles);
+uint32_t clock_tsc_khz(void);
+
+int sys_clock_gettime(int clk_id,struct timespec* ts);
+int sys_gettimeofday(struct timeval* tv,void* tz);
+#endif
\ No newline at end of file
@@ -11,6 +11,7 @@ enum{
 };
 
 struct _dev_desc_t;
+struct _poll_table_t;
 
 /**
  * @brief 设备结构体
@@ -41,6 +42,7 @@ typedef struct _device_t{
  * @param write 写设备的函数指针
  * @param control 控制设备的函数指针
  * @param close 关闭设备的函数指针
+ * @param poll 查询设备是否可读写，并将poll表加入设备的等待队列，为0时总是可读写
  */
 typedef struct _dev_desc_t{
 
@@ -52,6 +54,7 @@ typedef struct _dev_desc_t{
     int (*write)(device_t* dev,int addr,char* buf,int size);
     int (*control)(device_t* dev,int cmd,int arg0,int arg1);
     void (*close)(device_t* dev);
+    int (*poll)(device_t* dev,struct _poll_table_t* table);
 }dev_desc_t;
 
 
@@ -60,5 +63,6 @@ int dev_read(int dev_id,int addr,char* buf,int size);
 int dev_write(int dev_id,int addr,char* buf,int size);
 int dev_control(int dev_id,int cmd,int arg0,int arg1);
 void dev_close(int dev_id);
+int dev_poll(int dev_id,struct _poll_table_t* table);
 
 #endif
\ No newline at end of file
@@ -28,6 +28,9 @@
 
 #define KBD_STAT_RECV_READY     (1 << 0)
 
+/// @brief 中断中暂存扫描码的缓冲区大小，需为2的幂
+#define KBD_BUF_SIZE            32
+
 typedef struct _key_map_t{
     uint8_t normal;
     uint8_t func;
@@ -0,0 +1,45 @@
+#ifndef RTC_H
+#define RTC_H
+
+#include "comm/types.h"
+
+/// @brief CMOS的索引端口和数据端口
+#define CMOS_ADDR_PORT          0x70
+#define CMOS_DATA_PORT          0x71
+
+/// @brief CMOS中RTC时间寄存器的索引
+#define RTC_REG_SECOND          0x00
+#define RTC_REG_MINUTE          0x02
+#define RTC_REG_HOUR            0x04
+#define RTC_REG_DAY             0x07
+#define RTC_REG_MONTH           0x08
+#define RTC_REG_YEAR            0x09
+#define RTC_REG_CENTURY         0x32
+#define RTC_REG_STATUS_A        0x0A
+#define RTC_REG_STATUS_B        0x0B
+
+/// @brief 状态寄存器A：正在更新时间
+#define RTC_STATUS_A_UIP        (1 << 7)
+
+/// @brief 状态寄存器B：24小时制、二进制格式
+#define RTC_STATUS_B_24H        (1 << 1)
+#define RTC_STATUS_B_BINARY     (1 << 2)
+
+/// @brief 12小时制下小时寄存器的PM标志
+#define RTC_HOUR_PM             0x80
+
+/**
+ * @brief RTC中读出的日期和时间
+ */
+typedef struct _rtc_time_t{
+    int year;
+    int month;
+    int day;
+    int hour;
+    int minute;
+    int second;
+}rtc_time_t;
+
+void rtc_read_time(rtc_time_t* time);
+uint32_t rtc_get_epoch(void);
+#endif
\ No newline at end of file
@@ -16,5 +16,6 @@
 #define PIT_LOAD_LOHI               (3 << 4)
 #define PIT_MODE3                   (3 << 1)
 void time_init(void);
+uint32_t time_get_tick(void);
 void exception_handler_time(void);
 #endif
\ No newline at end of file
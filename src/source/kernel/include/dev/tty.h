@@ -3,6 +3,7 @@
 
 #include "dev/dev.h"
 #include "ipc/sem.h"
+#include "ipc/waitq.h"
 
 // tty设备的缓存大小
 #define TTY_OBUF_SIZE  512
@@ -46,6 +47,7 @@ typedef struct _tty_fifo_t{
  * @param console_index 对应的console的索引号
  * @param osem 输出信号量
  * @param isem 输入信号量
+ * @param iwq 输入的等待队列，收到字符时唤醒poll等待者
  * @param iflags 输入标志
  * @param oflags 输出标志
 */
@@ -61,6 +63,7 @@ typedef struct _tty_t{
     sem_t osem;
 
     sem_t isem;
+    wait_queue_t iwq;
 
     int iflags; 
     int oflags; 
@@ -71,6 +74,7 @@ int tty_read(device_t* dev,int addr,char* buf,int size);
 int tty_write(device_t* dev,int addr,char* buf,int size);
 int tty_control(device_t*dev,int cmd,int arg0,int arg1);
 void tty_close(device_t* dev);
+int tty_poll(device_t* dev,poll_table_t* table);
 
 void tty_fifo_init(tty_fifo_t* fifo,char* buf,int size);
 int tty_fifo_put(tty_fifo_t* fifo,char c);
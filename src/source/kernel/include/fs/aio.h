@@ -0,0 +1,47 @@
+#ifndef AIO_H
+#define AIO_H
+
+#include "comm/types.h"
+#include "fs/file.h"
+#include "core/memory.h"
+#include "core/workqueue.h"
+#include "ipc/sem.h"
+#include "applib/lib_syscall.h"
+
+/// @brief 执行异步I/O的工作线程数，读tty等可能长时间阻塞的操作不会让其它请求全部停下
+#define AIO_WORKER_NR           2
+
+/**
+ * @brief 进程的异步I/O上下文，随地址空间一起释放
+ * @param ring 共享的异步I/O环，内核通过物理地址访问
+ * @param inflight 已提交但未完成的操作数
+ * @param waiting 在sem上等待完成的任务数
+ * @param sem 操作完成时唤醒aio_enter中的等待者
+ */
+typedef struct _aio_ctx_t{
+    aio_ring_t* ring;
+    int inflight;
+    int waiting;
+    sem_t sem;
+}aio_ctx_t;
+
+/**
+ * @brief 一个已提交的操作，由工作线程执行
+ * @param work 工作项
+ * @param mm 提交者的地址空间，执行期间持有其引用
+ * @param file 操作的文件，执行期间持有其引用
+ * @param sqe 提交项的副本，避免用户在执行期间修改
+ */
+typedef struct _aio_req_t{
+    work_t work;
+    mm_t* mm;
+    file_t* file;
+    aio_sqe_t sqe;
+}aio_req_t;
+
+void aio_init(void);
+void aio_ctx_free(aio_ctx_t* ctx);
+aio_ring_t* sys_aio_setup(void);
+int sys_aio_enter(int min_complete);
+
+#endif
\ No newline at end of file
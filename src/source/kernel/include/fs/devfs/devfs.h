@@ -22,5 +22,6 @@ int devfs_write(char*buf,int size,file_t* file);
 void devfs_close(file_t* file);
 int devfs_seek(file_t* file,uint32_t offset,int dir);
 int devfs_stat(file_t*file,struct stat* st);
+int devfs_poll(file_t* file,struct _poll_table_t* table);
 
 #endif
\ No newline at end of file
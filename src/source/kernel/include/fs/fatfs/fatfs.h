@@ -2,6 +2,7 @@
 #define FATFS_H
 
 #include "comm/types.h"
+#include "ipc/mutex.h"
 
 #pragma pack(1)
 
@@ -132,6 +133,7 @@ typedef struct _dbr_t{
  * @param fs 文件系统指针
  * @param fat_buff 用来存储扇区数据的缓冲区
  * @param curr_sector fat_buff存储的扇区的扇区号
+ * @param mutex 保护fat_buff和FAT表，文件系统只被共享持有时多个任务会同时访问
  */
 typedef struct _fat_t{
     uint32_t tbl_start;
@@ -151,7 +153,7 @@ typedef struct _fat_t{
 
     int curr_sector;
 
-
+    mutex_t mutex;
 }fat_t;
 
 typedef uint16_t cluster_t;
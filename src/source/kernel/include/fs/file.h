@@ -15,12 +15,16 @@
  * @param FILE_TYPE_TTY tty设备文件
  * @param FILE_DIR 目录文件
  * @param FILE_NORMAL 普通文件
+ * @param FILE_PIPE 管道
+ * @param FILE_SOCKET 本地套接字
  */
 typedef enum _file_type_t{
     FILE_UNKNOWN=0, 
     FILE_TYPE_TTY, 
     FILE_DIR,
     FILE_NORMAL,
+    FILE_PIPE,
+    FILE_SOCKET,
 }file_type_t;
 
 /**
@@ -36,6 +40,7 @@ typedef enum _file_type_t{
  * @param p_index 文件在文件目录中的索引
  * @param sblk 文件起始块号
  * @param cblk 文件当前读取的块号
+ * @param data 文件类型私有的数据，管道文件指向pipe_t，套接字指向sock_t
  */
 typedef struct _file_t{
     char file_name[FILE_NAME_SIZE];
@@ -49,10 +54,13 @@ typedef struct _file_t{
     int p_index;
     int sblk;
     int cblk;
+    void* data;
 }file_t;
 
 file_t* file_alloc(void);
 void file_free(file_t* file);
 void file_table_init(void);
 void file_inc_ref(file_t* file);
+void file_lock(file_t* file);
+void file_unlock(file_t* file);
 #endif
\ No newline at end of file
@@ -6,10 +6,12 @@
 #include "fs/file.h"
 #include "tools/list.h"
 #include "ipc/mutex.h"
+#include "ipc/rwsem.h"
 #include "fs/fatfs/fatfs.h"
 #include "applib/lib_syscall.h"
 
 struct _fs_t;
+struct _poll_table_t;
 
 /**
  * @brief 文件系统操作函数表
@@ -26,6 +28,8 @@ struct _fs_t;
  * @param closedir 关闭目录
  * @param ioctl 控制文件操作
  * @param unlink 删除文件
+ * @param poll 查询文件是否可读写，并将poll表加入文件的等待队列，为0时总是可读写
+ * @param fsync 将文件的元数据写回磁盘，为0时不需要
  */
 typedef struct _fs_op_t{
     int (*mount)(struct _fs_t* fs,int major,int minor);
@@ -45,6 +49,8 @@ typedef struct _fs_op_t{
 
     int (*ioctl)(file_t* file,int cmd,int arg0,int arg1);
     int (*unlink)(struct _fs_t *fs,const char *path);
+    int (*poll)(file_t* file,struct _poll_table_t* table);
+    int (*fsync)(file_t* file);
 }fs_op_t;
 
 /// @brief 文件挂载点名称的大小
@@ -54,10 +60,14 @@ typedef struct _fs_op_t{
  * @brief 文件系统类型
  * @param FS_DEVFS 设备文件系统
  * @param FS_FAT16 FAT16文件系统
+ * @param FS_PIPE 管道，不挂载到路径上
+ * @param FS_SOCKET 本地套接字，不挂载到路径上
  */
 typedef enum _fs_type_t{
     FS_DEVFS,
     FS_FAT16,
+    FS_PIPE,
+    FS_SOCKET,
 }fs_type_t;
 
 /**
@@ -68,7 +78,7 @@ typedef enum _fs_type_t{
  * @param data 文件系统需要保存的数据
  * @param dev_id 设备号,用来识别磁盘分区
  * @param node 链表节点
- * @param mutex 互斥锁
+ * @param rwsem 读写信号量，查找等操作共享持有，删除文件时独占持有
  * @param fat_data FAT文件系统数据,如果是FAT文件系统,则包含FAT相关的数据
  */
 typedef struct _fs_t{
@@ -79,7 +89,7 @@ typedef struct _fs_t{
     void* data;
     int dev_id;
     list_node_t node;
-    mutex_t* mutex;
+    rwsem_t rwsem;
 
     union{
         fat_t fat_data;
@@ -94,6 +104,9 @@ int sys_read(int file,char* ptr,int len);
 int sys_write(int file,char* ptr,int len);
 int sys_lseek(int file,int ptr,int dir);
 int sys_close(int file);
+void fs_close_file(file_t* p_file);
+int fs_file_rw(file_t* p_file,uint32_t page_dir,uint32_t vaddr,int size,uint32_t offset,int write);
+int fs_file_fsync(file_t* p_file);
 
 int sys_isatty(int file);
 int sys_fstat(int file,struct stat* st);
@@ -109,4 +122,6 @@ int sys_closedir(DIR* dir);
 
 int sys_ioctl(int fd,int cmd,int arg0,int arg1);
 int sys_unlink(const char* path);
+int sys_pipe(int* fds);
+int sys_poll(struct pollfd* fds,int nfds,int timeout_ms);
 #endif
\ No newline at end of file
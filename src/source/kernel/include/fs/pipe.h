@@ -0,0 +1,60 @@
+#ifndef PIPE_H
+#define PIPE_H
+
+#include "fs/fs.h"
+#include "ipc/sem.h"
+#include "ipc/mutex.h"
+#include "ipc/waitq.h"
+#include "core/memory.h"
+
+/// @brief 管道缓冲区的页数，缓冲区为连续的物理页组成的环形缓冲区
+#define PIPE_PAGES              4
+#define PIPE_BUF_SIZE           (PIPE_PAGES*MEM_PAGE_SIZE)
+
+/**
+ * @brief 管道，读端和写端各对应一个file_t，file_t的引用计数归零时关闭该端
+ * @param buf 环形缓冲区
+ * @param read_pos 累计读出的字节数，对缓冲区大小取模得到读位置
+ * @param write_pos 累计写入的字节数，与read_pos之差为缓冲区中的数据量
+ * @param readers 未关闭的读端数量
+ * @param writers 未关闭的写端数量
+ * @param mutex 保护缓冲区和读写位置
+ * @param read_sem 缓冲区为空时读者在此等待
+ * @param write_sem 缓冲区已满时写者在此等待
+ * @param read_waiting 正在等待read_sem的读者数量
+ * @param write_waiting 正在等待write_sem的写者数量
+ * @param wq 读写位置或端的数量变化时唤醒poll等待者
+ * @param direct_buf 缓冲区为空时等待的读者登记的用户缓冲区，写者直接复制到这里，省去经过环形缓冲区的一次复制
+ * @param direct_size direct_buf的大小
+ * @param direct_page_dir direct_buf所在地址空间的页表
+ * @param direct_done 直接复制的字节数，0表示还未复制，-1表示复制失败
+ */
+typedef struct _pipe_t{
+    char* buf;
+    uint32_t read_pos;
+    uint32_t write_pos;
+    int readers;
+    int writers;
+    mutex_t mutex;
+    sem_t read_sem;
+    sem_t write_sem;
+    int read_waiting;
+    int write_waiting;
+    wait_queue_t wq;
+
+    uint32_t direct_buf;
+    int direct_size;
+    uint32_t direct_page_dir;
+    int direct_done;
+}pipe_t;
+
+void pipe_fs_init(void);
+int pipe_open(file_t* read_file,file_t* write_file);
+
+pipe_t* pipe_create(void);
+int pipe_recv(pipe_t* pipe,char* buf,int size);
+int pipe_send(pipe_t* pipe,char* buf,int size);
+void pipe_shutdown(pipe_t* pipe,int reader);
+int pipe_events(pipe_t* pipe,int reader,poll_table_t* table);
+
+#endif
\ No newline at end of file
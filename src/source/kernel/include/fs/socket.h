@@ -0,0 +1,65 @@
+#ifndef SOCKET_H
+#define SOCKET_H
+
+#include "fs/fs.h"
+#include "fs/pipe.h"
+#include "tools/list.h"
+#include "ipc/sem.h"
+#include "ipc/waitq.h"
+#include "applib/lib_syscall.h"
+
+/// @brief 监听队列的最大长度
+#define SOCK_BACKLOG_MAX        16
+
+/**
+ * @brief 套接字的状态
+ * @param SOCK_UNCONNECTED 刚创建或已绑定名字
+ * @param SOCK_LISTENING 正在监听，可以accept
+ * @param SOCK_CONNECTED 已建立连接，可以读写
+ */
+typedef enum _sock_state_t{
+    SOCK_UNCONNECTED=0,
+    SOCK_LISTENING,
+    SOCK_CONNECTED,
+}sock_state_t;
+
+/**
+ * @brief 本地流式套接字，已连接的一对套接字共享两个方向相反的管道
+ * @param state 状态
+ * @param name 绑定的名字
+ * @param node 绑定名字后在名字表中的节点
+ * @param bound 是否已绑定名字
+ * @param accept_list 监听套接字上已建立但未accept的连接
+ * @param accept_node 未accept的连接在accept_list中的节点
+ * @param pending accept_list中的连接数
+ * @param backlog accept_list的最大长度
+ * @param accept_sem 每建立一个连接发出一次通知，accept在此等待
+ * @param wq 有新连接时唤醒poll等待者
+ * @param rx 接收方向的管道，本端为读端
+ * @param tx 发送方向的管道，本端为写端
+ */
+typedef struct _sock_t{
+    sock_state_t state;
+    char name[SOCK_NAME_SIZE];
+    list_node_t node;
+    int bound;
+
+    list_t accept_list;
+    list_node_t accept_node;
+    int pending;
+    int backlog;
+    sem_t accept_sem;
+    wait_queue_t wq;
+
+    pipe_t* rx;
+    pipe_t* tx;
+}sock_t;
+
+void socket_init(void);
+int sys_socket(int domain,int type,int protocol);
+int sys_bind(int fd,const struct sockaddr_un* addr,int len);
+int sys_listen(int fd,int backlog);
+int sys_accept(int fd,struct sockaddr_un* addr,int* len);
+int sys_connect(int fd,const struct sockaddr_un* addr,int len);
+
+#endif
\ No newline at end of file
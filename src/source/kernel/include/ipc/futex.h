@@ -0,0 +1,26 @@
+#ifndef FUTEX_H
+#define FUTEX_H
+#include "tools/list.h"
+#include "core/task.h"
+#include "cpu/irq.h"
+
+/// @brief 等待队列哈希表的大小
+#define FUTEX_HASH_SIZE         64
+
+/**
+ * @brief 在futex上等待的任务，位于等待任务的内核栈上
+ * @param node 在哈希桶中的节点
+ * @param key futex所在的物理地址
+ * @param task 等待的任务
+ * @param woken 是否已被FUTEX_WAKE唤醒
+ */
+typedef struct _futex_waiter_t{
+    list_node_t node;
+    uint32_t key;
+    task_t* task;
+    int woken;
+}futex_waiter_t;
+
+void futex_init(void);
+int sys_futex(int* uaddr,int op,int val,int timeout_ms);
+#endif
\ No newline at end of file
@@ -3,13 +3,25 @@
 #include "tools/list.h"
 #include "core/task.h"
 
+/// @brief owner的最低位，置位表示有任务在等待，解锁时需要进入慢速路径
+#define MUTEX_WAITERS           1
+
+/**
+ * @brief 支持优先级继承的互斥锁
+ * @param owner 持有锁的任务指针，最低位为MUTEX_WAITERS标志，0表示空闲
+ * @param locked_count 同一任务重复加锁的次数
+ * @param wait_list 按优先级排序的等待队列
+ * @param hold_node 有等待者时在持有者held_list中的节点
+ */
 typedef struct _mutex_t{
-    task_t* owner;
+    volatile uint32_t owner;
     int locked_count;
     list_t wait_list;
+    list_node_t hold_node;
 }mutex_t;
 
 void mutex_init(mutex_t* mutex);
 void mutex_lock(mutex_t* mutex);
 void mutex_unlock(mutex_t* mutex);
+void mutex_prio_changed(task_t* task);
 #endif
\ No newline at end of file
@@ -0,0 +1,34 @@
+#ifndef RWSEM_H
+#define RWSEM_H
+#include "tools/list.h"
+#include "core/task.h"
+#include "cpu/irq.h"
+
+/**
+ * @brief 读写信号量，允许多个读者同时持有，写者独占
+ * @param count 大于0为持有的读者数量，-1为写者持有，0为空闲
+ * @param wait_list 等待队列，按先来先得的顺序唤醒
+ */
+typedef struct _rwsem_t{
+    int count;
+    list_t wait_list;
+}rwsem_t;
+
+/**
+ * @brief 在读写信号量上等待的任务，位于等待任务的内核栈上
+ * @param node 在等待队列中的节点
+ * @param task 等待的任务
+ * @param write 是否为写者
+ */
+typedef struct _rwsem_waiter_t{
+    list_node_t node;
+    task_t* task;
+    int write;
+}rwsem_waiter_t;
+
+void rwsem_init(rwsem_t* sem);
+void rwsem_read_lock(rwsem_t* sem);
+void rwsem_read_unlock(rwsem_t* sem);
+void rwsem_write_lock(rwsem_t* sem);
+void rwsem_write_unlock(rwsem_t* sem);
+#endif
\ No newline at end of file
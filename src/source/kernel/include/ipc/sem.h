@@ -3,8 +3,15 @@
 #include "tools/list.h"
 #include "core/task.h"
 #include "cpu/irq.h"
+/**
+ * @brief 计数信号量
+ * @param count 大于等于0为可用的数量，小于0时其绝对值为等待者的数量
+ * @param wakeups 已经发出但等待者还未进入等待队列的唤醒次数
+ * @param wait_list 等待队列
+ */
 typedef struct _sem_t{
-    int count;
+    volatile int count;
+    int wakeups;
     list_t wait_list;
 }sem_t;
 
@@ -0,0 +1,55 @@
+#ifndef WAITQ_H
+#define WAITQ_H
+#include "tools/list.h"
+#include "core/task.h"
+#include "cpu/irq.h"
+
+/// @brief 一次poll最多等待的等待队列数量，每个文件最多加入两个等待队列（已连接的套接字）
+#define POLL_ENTRY_NR           32
+
+/**
+ * @brief 等待队列，文件的状态变化时唤醒队列中的poll等待者
+ * @param list poll_entry_t的链表
+ */
+typedef struct _wait_queue_t{
+    list_t list;
+}wait_queue_t;
+
+struct _poll_table_t;
+
+/**
+ * @brief poll等待者在一个等待队列中的表项
+ * @param node 在等待队列中的节点
+ * @param wq 所在的等待队列
+ * @param table 所属的poll表
+ */
+typedef struct _poll_entry_t{
+    list_node_t node;
+    wait_queue_t* wq;
+    struct _poll_table_t* table;
+}poll_entry_t;
+
+/**
+ * @brief 一次poll调用加入的全部等待队列
+ * @param task 等待的任务
+ * @param triggered 加入等待队列后是否有队列被唤醒
+ * @param sleeping 任务是否已进入等待，只有此时唤醒才需要将任务设置为就绪
+ * @param count 已使用的表项数量
+ * @param entries 表项
+ */
+typedef struct _poll_table_t{
+    task_t* task;
+    int triggered;
+    int sleeping;
+    int count;
+    poll_entry_t entries[POLL_ENTRY_NR];
+}poll_table_t;
+
+void wait_queue_init(wait_queue_t* wq);
+void wait_queue_wakeup(wait_queue_t* wq);
+
+void poll_table_init(poll_table_t* table);
+void poll_wait(wait_queue_t* wq,poll_table_t* table);
+int poll_table_sleep(poll_table_t* table,int ticks);
+void poll_table_free(poll_table_t* table);
+#endif
\ No newline at end of file
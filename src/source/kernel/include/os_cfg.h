@@ -1,8 +1,8 @@
 #ifndef OS_CFG_H
 #define OS_CFG_H
 
-/// @brief gdt表的大小
-#define GDT_TABLE_SIZE 256
+/// @brief gdt表的大小，每个任务占用一个TSS描述符，取x86允许的最大值
+#define GDT_TABLE_SIZE 8192
 
 /// @brief 设置内核代码段的索引
 #define KERNEL_SELECTOR_CS (1*8) 
@@ -22,11 +22,21 @@
 /// @brief 空闲任务的栈大小
 #define IDLE_TASK_SIZE          1024
 
+/// @brief 用户代码段和数据段，SYSEXIT要求二者紧随内核段之后依次排列
+#define APP_SELECTOR_CS         (3*8)
+#define APP_SELECTOR_DS         (4*8)
+
 /// @brief 系统调用的选择子的索引
-#define SELECTOR_SYSCALL        (3*8)
+#define SELECTOR_SYSCALL        (5*8)
+
+/// @brief 默认的最大任务数量，运行时可通过task_set_limit调整
+#define TASK_NR                 4096
+
+/// @brief 存在APIC时使用LAPIC和IOAPIC，为0时始终使用8259
+#define OS_USE_APIC             1
 
-/// @brief 任务的数量
-#define TASK_NR                 128
+/// @brief 使用APIC时以LAPIC定时器作为时钟中断源，为0时使用PIT
+#define OS_LAPIC_TIMER          1
 
 /// @brief 根文件系统的设备号
 #define ROOT_DEV             DEV_DISK,0xb1
@@ -13,6 +13,37 @@ static inline uint32_t up2(uint32_t size,uint32_t bound){
     return (size+bound-1) & ~(bound-1);
 }
 
+/**
+ * @brief 64位数除以32位数，内核不链接libgcc，不能直接使用64位除法
+ * @param n 被除数
+ * @param base 除数
+ * @param rem 存放余数，可以为0
+ * @return 商
+ */
+static inline uint64_t div_u64_rem(uint64_t n,uint32_t base,uint32_t* rem){
+    uint32_t high=(uint32_t)(n >> 32);
+    uint32_t low=(uint32_t)n;
+
+    // 先除高32位，保证divl的商不会溢出
+    uint32_t q_high=0;
+    if(high>=base){
+        q_high=high/base;
+        high%=base;
+    }
+
+    uint32_t q_low,r;
+    __asm__ __volatile__(
+        "divl %[base]"
+        :"=a"(q_low),"=d"(r)
+        :"a"(low),"d"(high),[base]"rm"(base)
+    );
+
+    if(rem){
+        *rem=r;
+    }
+    return ((uint64_t)q_high << 32) | q_low;
+}
+
 // 复制字符串
 void kernel_strcpy(char* dest,const char* src);
 // 复制字符串指明复制多个字符
@@ -44,7 +44,10 @@ int first_task_main(void){
 
         // 回收所有的孤儿进程
         int status=0;
-        wait(&status);
+        if(wait(&status)<0){
+            // 暂时没有子进程，等待新的孤儿进程
+            msleep(100);
+        }
         
     }
     return 0;
@@ -14,26 +14,55 @@
 #include "cpu/cpu.h"
 #include "dev/kbd.h"
 #include "fs/fs.h"
+#include "core/workqueue.h"
+#include "core/kmalloc.h"
+#include "cpu/fpu.h"
+#include "ipc/futex.h"
+#include "core/softirq.h"
+#include "cpu/apic.h"
+#include "core/vdso.h"
+#include "core/syscall.h"
+#include "fs/aio.h"
+#include "core/ksym.h"
+#include "core/boottime.h"
 
 void kernel_init(boot_info_t* boot_info){
+    // 每个初始化步骤结束时记录一次，统计各步骤的启动耗时
+    boot_time_init(boot_info);
     irq_init();
+    softirq_init();
+    boot_time_mark("irq_init");
 
     cpu_init();
+    fpu_init();
     log_init();
+    boot_time_mark("cpu_log_init");
 
     memory_init(boot_info);
+    kmalloc_init();
+    vdso_init();
+    boot_time_mark("memory_init");
+    apic_init();
+    boot_time_mark("apic_init");
+    syscall_init();
+    ksym_init();
     fs_init();
+    boot_time_mark("fs_init");
     
     time_init();
+    boot_time_mark("time_init");
 
     task_manager_init();
-
+    futex_init();
+    boot_time_mark("task_init");
 }
 
 void move_to_first_task(void){
     task_t* curr=task_current();
     ASSERT(curr!=0);
     tss_t* tss=&(curr->tss);
+    cpu_set_sysenter_stack(tss->esp0);
+    vdso_set_pid(curr->pid);
     __asm__ __volatile__(
         "push %[ss]\n\t"
         "push %[esp]\n\t"
@@ -51,5 +80,12 @@ void init_main(){
     int count=0;
     log_printf("Kernel is running....");
     task_first_init();
+    boot_time_mark("first_task_init");
+
+    // 内核线程排在first_task之后，保证first_task最先运行
+    workqueue_init();
+    ksoftirqd_init();
+    aio_init();
+    boot_time_mark("kthread_init");
     move_to_first_task();
 }
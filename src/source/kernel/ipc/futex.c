@@ -0,0 +1,135 @@
+#include "ipc/futex.h"
+#include "core/memory.h"
+
+/// @brief 按物理地址散列的等待队列，不同进程映射同一物理页时也能相互唤醒
+static list_t futex_hash[FUTEX_HASH_SIZE];
+
+void futex_init(void){
+    for(int i=0;i<FUTEX_HASH_SIZE;i++){
+        list_init(futex_hash+i);
+    }
+}
+
+static list_t* futex_bucket(uint32_t key){
+    return futex_hash+((key>>2)%FUTEX_HASH_SIZE);
+}
+
+/**
+ * @brief 获取用户地址对应的物理地址，作为futex的键
+ * @param uaddr 用户空间的地址，必须4字节对齐
+ * @return 成功返回物理地址，失败返回0
+ */
+static uint32_t futex_key(int* uaddr){
+    uint32_t vaddr=(uint32_t)uaddr;
+    if((vaddr<MEMORY_TASK_BASE) || (vaddr & 0x3)){
+        return 0;
+    }
+
+    return memory_get_paddr(task_current()->tss.cr3,vaddr);
+}
+
+/**
+ * @brief 如果*uaddr仍等于val，则在futex上等待，直到被唤醒或超时
+ * @param key futex的键
+ * @param uaddr 用户空间的地址
+ * @param val 期望的值
+ * @param timeout_ms 超时时间，0表示一直等待
+ * @return 被唤醒返回0，值不相等或超时返回-1
+ */
+static int futex_wait(uint32_t key,int* uaddr,int val,int timeout_ms){
+    task_t* curr=task_current();
+    futex_waiter_t waiter;
+    waiter.key=key;
+    waiter.task=curr;
+    waiter.woken=0;
+    list_node_init(&waiter.node);
+
+    list_t* bucket=futex_bucket(key);
+
+    // 检查值与加入等待队列在同一临界区内完成，避免错过检查后发生的唤醒
+    irq_state_t state=irq_enter_protection();
+    if(*uaddr!=val){
+        irq_leave_protection(state);
+        return -1;
+    }
+
+    list_insert_last(bucket,&waiter.node);
+    task_set_block(curr);
+    if(timeout_ms>0){
+        task_set_sleep(curr,(timeout_ms+(OS_TICK_MS-1))/OS_TICK_MS);
+    }
+    task_dispatch();
+
+    // 超时醒来时仍在等待队列中，需要自己移除
+    if(!waiter.woken){
+        list_remove(bucket,&waiter.node);
+    }
+    irq_leave_protection(state);
+
+    return waiter.woken ? 0 : -1;
+}
+
+/**
+ * @brief 唤醒在futex上等待的任务
+ * @param key futex的键
+ * @param count 最多唤醒的任务数量
+ * @return 实际唤醒的任务数量
+ */
+static int futex_wake(uint32_t key,int count){
+    list_t* bucket=futex_bucket(key);
+    int woken=0;
+
+    irq_state_t state=irq_enter_protection();
+    list_node_t* node=list_first(bucket);
+    while(node && (woken<count)){
+        list_node_t* next=list_node_next(node);
+        futex_waiter_t* waiter=list_node_parent(node,futex_waiter_t,node);
+        if(waiter->key==key){
+            list_remove(bucket,node);
+            waiter->woken=1;
+
+            // 带超时的等待者同时位于睡眠队列中，已超时的等待者已在就绪队列中
+            task_t* task=waiter->task;
+            if(task->state==TASK_SLEEP){
+                task_set_wakeup(task);
+                task_set_ready(task);
+            }
+            else if(task->state!=TASK_READY){
+                task_set_ready(task);
+            }
+            woken++;
+        }
+        node=next;
+    }
+
+    if(woken){
+        task_dispatch();
+    }
+    irq_leave_protection(state);
+
+    return woken;
+}
+
+/**
+ * @brief futex系统调用，用户态的锁只在发生竞争时才进入内核
+ * @param uaddr 用户空间中4字节对齐的整数地址
+ * @param op FUTEX_WAIT或FUTEX_WAKE
+ * @param val FUTEX_WAIT时为期望的值，FUTEX_WAKE时为最多唤醒的数量
+ * @param timeout_ms FUTEX_WAIT的超时时间，0表示一直等待
+ * @return FUTEX_WAIT成功返回0，FUTEX_WAKE返回唤醒的数量，失败返回-1
+ */
+int sys_futex(int* uaddr,int op,int val,int timeout_ms){
+    uint32_t key=futex_key(uaddr);
+    if(key==0){
+        return -1;
+    }
+
+    switch(op){
+        case FUTEX_WAIT:
+            return futex_wait(key,uaddr,val,timeout_ms);
+        case FUTEX_WAKE:
+            return futex_wake(key,val);
+        default:
+            return -1;
+    }
+}
\ No newline at end of file
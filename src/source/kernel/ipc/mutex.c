@@ -2,43 +2,218 @@
 
 void mutex_init(mutex_t* mutex){
     mutex->locked_count=0;
-    mutex->owner=(task_t*)0;
+    mutex->owner=0;
     list_init(&mutex->wait_list); 
+    list_node_init(&mutex->hold_node);
 }
 
-void mutex_lock(mutex_t* mutex){
-    irq_state_t state=irq_enter_protection();
-    task_t* curr=task_current();
-    if(mutex->locked_count==0){
-        mutex->locked_count=1;
-        mutex->owner=curr;
+/**
+ * @brief 获取互斥锁的持有者
+ * @param mutex 互斥锁
+ * @return 持有锁的任务，空闲时返回0
+ */
+static inline task_t* mutex_owner(mutex_t* mutex){
+    return (task_t*)(mutex->owner & ~MUTEX_WAITERS);
+}
+
+/**
+ * @brief 按优先级将任务插入互斥锁的等待队列，同优先级先来先得
+ * @param mutex 互斥锁
+ * @param task 等待的任务
+ */
+static void mutex_wait_insert(mutex_t* mutex,task_t* task){
+    list_node_t* node=list_first(&mutex->wait_list);
+    while(node){
+        task_t* curr=list_node_parent(node,task_t,wait_node);
+        if(curr->prio>task->prio){
+            break;
+        }
+        node=list_node_next(node);
     }
-    else if(mutex->owner==curr){
-        mutex->locked_count++;
+    list_insert_before(&mutex->wait_list,node,&task->wait_node);
+}
+
+/**
+ * @brief 将优先级沿着持有者链向上传递，持有者又在等待其它锁时继续提升
+ * @param mutex 开始传递的互斥锁
+ * @param prio 需要继承的优先级
+ */
+static void mutex_boost(mutex_t* mutex,int prio){
+    while(mutex){
+        task_t* owner=mutex_owner(mutex);
+        if((owner==(task_t*)0) || (owner->prio<=prio)){
+            break;
+        }
+
+        task_set_prio(owner,prio);
+
+        mutex=owner->blocked_on;
+        if(mutex){
+            list_remove(&mutex->wait_list,&owner->wait_node);
+            mutex_wait_insert(mutex,owner);
+        }
     }
-    else{
-        task_set_block(curr);
-        list_insert_last(&mutex->wait_list,&curr->wait_node);
-        task_dispatch();
+}
+
+/**
+ * @brief 根据自身优先级和持有的锁上等待者的最高优先级重新计算任务的优先级
+ * @param task 需要计算的任务
+ * @note 只有存在等待者的锁才在held_list中，快速路径获取的锁不影响优先级
+ */
+static void mutex_update_prio(task_t* task){
+    int prio=task->base_prio;
+
+    list_node_t* node=list_first(&task->held_list);
+    while(node){
+        mutex_t* mutex=list_node_parent(node,mutex_t,hold_node);
+        task_t* waiter=list_node_parent(list_first(&mutex->wait_list),task_t,wait_node);
+        if(waiter && (waiter->prio<prio)){
+            prio=waiter->prio;
+        }
+        node=list_node_next(node);
+    }
+
+    task_set_prio(task,prio);
+}
+
+/**
+ * @brief 任务的自身优先级改变后，更新其当前优先级，并沿等待的锁传递
+ * @param task 优先级改变的任务
+ */
+void mutex_prio_changed(task_t* task){
+    irq_state_t state=irq_enter_protection();
+    mutex_update_prio(task);
+
+    mutex_t* mutex=task->blocked_on;
+    if(mutex){
+        list_remove(&mutex->wait_list,&task->wait_node);
+        mutex_wait_insert(mutex,task);
+        mutex_boost(mutex,task->prio);
+
+        // 优先级降低时，被等待锁的持有者可能也需要降低
+        task_t* owner=mutex_owner(mutex);
+        if(owner){
+            mutex_update_prio(owner);
+        }
     }
     irq_leave_protection(state);
 }
 
-void mutex_unlock(mutex_t* mutex){
+/**
+ * @brief 锁被占用时的慢速路径，在临界区中设置等待标志并睡眠，被唤醒时已获得锁
+ * @param mutex 互斥锁
+ * @param curr 当前任务
+ */
+static void mutex_lock_slow(mutex_t* mutex,task_t* curr){
     irq_state_t state=irq_enter_protection();
-    task_t* curr=task_current();
-    if(mutex->owner==curr){
-        if(--mutex->locked_count==0){
-            mutex->owner=(task_t*)0;
-            if(list_count(&mutex->wait_list)){
-                list_node_t* node=list_remove_first(&mutex->wait_list);
-                task_t* task=list_node_parent(node,task_t,wait_node);
-                task_set_ready(task);
+
+    // 进入临界区前持有者可能已经释放了锁
+    for(;;){
+        uint32_t owner=mutex->owner;
+        if(owner==0){
+            if(atomic_cmpxchg(&mutex->owner,0,(uint32_t)curr)==0){
                 mutex->locked_count=1;
-                mutex->owner=task;
-                task_dispatch();
+                irq_leave_protection(state);
+                return;
             }
         }
+        else if(atomic_cmpxchg(&mutex->owner,owner,owner | MUTEX_WAITERS)==owner){
+            break;
+        }
     }
+
+    // 第一个等待者把锁挂到持有者的held_list上，用于解锁时恢复优先级
+    task_t* owner=mutex_owner(mutex);
+    if(list_is_empty(&mutex->wait_list)){
+        list_insert_last(&owner->held_list,&mutex->hold_node);
+    }
+
+    task_set_block(curr);
+    curr->blocked_on=mutex;
+    mutex_wait_insert(mutex,curr);
+
+    // 持有者的优先级低于自己时，临时提升持有者的优先级
+    mutex_boost(mutex,curr->prio);
+    task_dispatch();
+
     irq_leave_protection(state);
+}
+
+/**
+ * @brief 有等待者时的解锁慢速路径，将锁直接交给优先级最高的等待者
+ * @param mutex 互斥锁
+ * @param curr 当前任务
+ */
+static void mutex_unlock_slow(mutex_t* mutex,task_t* curr){
+    irq_state_t state=irq_enter_protection();
+
+    list_remove(&curr->held_list,&mutex->hold_node);
+
+    list_node_t* node=list_remove_first(&mutex->wait_list);
+    task_t* task=list_node_parent(node,task_t,wait_node);
+    task->blocked_on=(mutex_t*)0;
+    mutex->locked_count=1;
+
+    // 新的持有者继承其余等待者的优先级
+    if(list_is_empty(&mutex->wait_list)){
+        atomic_xchg(&mutex->owner,(uint32_t)task);
+    }
+    else{
+        atomic_xchg(&mutex->owner,(uint32_t)task | MUTEX_WAITERS);
+        list_insert_last(&task->held_list,&mutex->hold_node);
+    }
+    mutex_update_prio(task);
+    task_set_ready(task);
+
+    // 释放锁后恢复因该锁继承的优先级
+    mutex_update_prio(curr);
+    task_dispatch();
+
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief 获取互斥锁，没有竞争时只需一次cmpxchg，不需要关中断
+ * @param mutex 互斥锁
+ */
+void mutex_lock(mutex_t* mutex){
+    task_t* curr=task_current();
+
+    // 第一个任务运行前只有初始化流程在执行，不存在竞争
+    if(curr==(task_t*)0){
+        return;
+    }
+
+    if(atomic_cmpxchg(&mutex->owner,0,(uint32_t)curr)==0){
+        mutex->locked_count=1;
+        return;
+    }
+
+    if(mutex_owner(mutex)==curr){
+        mutex->locked_count++;
+        return;
+    }
+
+    mutex_lock_slow(mutex,curr);
+}
+
+/**
+ * @brief 释放互斥锁，没有等待者时只需一次cmpxchg，不需要关中断
+ * @param mutex 互斥锁
+ */
+void mutex_unlock(mutex_t* mutex){
+    task_t* curr=task_current();
+    if((curr==(task_t*)0) || (mutex_owner(mutex)!=curr)){
+        return;
+    }
+
+    if(--mutex->locked_count){
+        return;
+    }
+
+    if(atomic_cmpxchg(&mutex->owner,(uint32_t)curr,0)==(uint32_t)curr){
+        return;
+    }
+
+    mutex_unlock_slow(mutex,curr);
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "ipc/rwsem.h"
+
+void rwsem_init(rwsem_t* sem){
+    sem->count=0;
+    list_init(&sem->wait_list);
+}
+
+/**
+ * @brief 将当前任务加入等待队列并切换，被唤醒时已经获得了信号量
+ * @param sem 读写信号量
+ * @param write 是否为写者
+ * @note 调用者需要处于临界区中
+ */
+static void rwsem_wait(rwsem_t* sem,int write){
+    task_t* curr=task_current();
+    rwsem_waiter_t waiter;
+    waiter.task=curr;
+    waiter.write=write;
+    list_node_init(&waiter.node);
+
+    task_set_block(curr);
+    list_insert_last(&sem->wait_list,&waiter.node);
+    task_dispatch();
+}
+
+/**
+ * @brief 信号量空闲时唤醒等待者：队首为写者时只唤醒它，否则唤醒队首连续的所有读者
+ * @param sem 读写信号量
+ * @note 调用者需要处于临界区中
+ */
+static void rwsem_wake(rwsem_t* sem){
+    list_node_t* node=list_first(&sem->wait_list);
+    if(node==(list_node_t*)0){
+        return;
+    }
+
+    rwsem_waiter_t* waiter=list_node_parent(node,rwsem_waiter_t,node);
+    if(waiter->write){
+        list_remove_first(&sem->wait_list);
+        sem->count=-1;
+        task_set_ready(waiter->task);
+    }
+    else{
+        while(node){
+            waiter=list_node_parent(node,rwsem_waiter_t,node);
+            if(waiter->write){
+                break;
+            }
+
+            list_node_t* next=list_node_next(node);
+            list_remove(&sem->wait_list,node);
+            sem->count++;
+            task_set_ready(waiter->task);
+            node=next;
+        }
+    }
+    task_dispatch();
+}
+
+/**
+ * @brief 以读者身份获取信号量，已有写者等待时也要排队，避免写者饿死
+ * @param sem 读写信号量
+ */
+void rwsem_read_lock(rwsem_t* sem){
+    irq_state_t state=irq_enter_protection();
+    if((sem->count>=0) && list_is_empty(&sem->wait_list)){
+        sem->count++;
+    }
+    else{
+        rwsem_wait(sem,0);
+    }
+    irq_leave_protection(state);
+}
+
+void rwsem_read_unlock(rwsem_t* sem){
+    irq_state_t state=irq_enter_protection();
+    if(--sem->count==0){
+        rwsem_wake(sem);
+    }
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief 以写者身份获取信号量
+ * @param sem 读写信号量
+ */
+void rwsem_write_lock(rwsem_t* sem){
+    irq_state_t state=irq_enter_protection();
+    if((sem->count==0) && list_is_empty(&sem->wait_list)){
+        sem->count=-1;
+    }
+    else{
+        rwsem_wait(sem,1);
+    }
+    irq_leave_protection(state);
+}
+
+void rwsem_write_unlock(rwsem_t* sem){
+    irq_state_t state=irq_enter_protection();
+    sem->count=0;
+    rwsem_wake(sem);
+    irq_leave_protection(state);
+}
\ No newline at end of file
@@ -2,13 +2,24 @@
 
 void sem_init(sem_t* sem,int init_count){
     sem->count=init_count;
+    sem->wakeups=0;
     list_init(&sem->wait_list);
 }
 
+/**
+ * @brief 等待信号量，计数大于0时只需一次xadd，不需要关中断
+ * @param sem 信号量
+ */
 void sem_wait(sem_t* sem){
+    if(atomic_xadd(&sem->count,-1)>0){
+        return;
+    }
+
     irq_state_t state=irq_enter_protection();
-    if(sem->count>0){
-        sem->count--;
+
+    // 减计数与进入临界区之间，sem_notify可能已经发出了唤醒
+    if(sem->wakeups){
+        sem->wakeups--;
     }
     else{
         task_t* curr=task_current();
@@ -19,7 +30,15 @@ void sem_wait(sem_t* sem){
     irq_leave_protection(state);
 }
 
+/**
+ * @brief 释放信号量，没有等待者时只需一次xadd，不需要关中断
+ * @param sem 信号量
+ */
 void sem_notify(sem_t* sem){
+    if(atomic_xadd(&sem->count,1)>=0){
+        return;
+    }
+
     irq_state_t state=irq_enter_protection();
     if(list_count(&sem->wait_list)){
         list_node_t* node=list_remove_first(&sem->wait_list);
@@ -28,14 +47,17 @@ void sem_notify(sem_t* sem){
         task_dispatch();
     }
     else{
-        sem->count++;
+        sem->wakeups++;
     }
     irq_leave_protection(state);
 }
 
+/**
+ * @brief 获取信号量当前可用的数量
+ * @param sem 信号量
+ * @return 可用的数量，有等待者时为0
+ */
 int sem_count(sem_t* sem){
-    irq_state_t state=irq_enter_protection();
     int count=sem->count;
-    irq_leave_protection(state);
-    return count;
+    return (count>0) ? count : 0;
 }
\ No newline at end of file
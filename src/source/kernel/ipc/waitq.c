@@ -0,0 +1,113 @@
+#include "ipc/waitq.h"
+
+void wait_queue_init(wait_queue_t* wq){
+    list_init(&wq->list);
+}
+
+/**
+ * @brief 唤醒等待队列中的全部poll等待者，可以在中断和软中断中调用
+ * @param wq 等待队列
+ */
+void wait_queue_wakeup(wait_queue_t* wq){
+    int woken=0;
+
+    irq_state_t state=irq_enter_protection();
+    list_node_t* node=list_first(&wq->list);
+    while(node){
+        poll_entry_t* entry=list_node_parent(node,poll_entry_t,node);
+        poll_table_t* table=entry->table;
+        table->triggered=1;
+
+        // 等待者仍在其它等待队列中，由它醒来后统一移除
+        if(table->sleeping){
+            table->sleeping=0;
+            task_t* task=table->task;
+            if(task->state==TASK_SLEEP){
+                task_set_wakeup(task);
+                task_set_ready(task);
+            }
+            else if(task->state!=TASK_READY){
+                task_set_ready(task);
+            }
+            woken++;
+        }
+        node=list_node_next(node);
+    }
+
+    if(woken){
+        task_dispatch();
+    }
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief 初始化poll表，等待者为当前任务
+ * @param table poll表
+ */
+void poll_table_init(poll_table_t* table){
+    table->task=task_current();
+    table->triggered=0;
+    table->sleeping=0;
+    table->count=0;
+}
+
+/**
+ * @brief 将poll表加入等待队列，由文件的poll回调调用
+ * @param wq 文件的等待队列
+ * @param table poll表，为0时不加入，用于只查询状态
+ */
+void poll_wait(wait_queue_t* wq,poll_table_t* table){
+    if((table==(poll_table_t*)0) || (table->count>=POLL_ENTRY_NR)){
+        return;
+    }
+
+    poll_entry_t* entry=table->entries+table->count++;
+    entry->wq=wq;
+    entry->table=table;
+    list_node_init(&entry->node);
+
+    irq_state_t state=irq_enter_protection();
+    list_insert_last(&wq->list,&entry->node);
+    irq_leave_protection(state);
+}
+
+/**
+ * @brief 等待任意一个已加入的等待队列被唤醒
+ * @param table poll表
+ * @param ticks 最多等待的tick数，小于0表示一直等待
+ * @return 1 被唤醒，0 超时
+ */
+int poll_table_sleep(poll_table_t* table,int ticks){
+    irq_state_t state=irq_enter_protection();
+
+    // 查询文件状态之后发生的唤醒已记录在triggered中，不需要等待
+    if(!table->triggered){
+        task_t* curr=table->task;
+        table->sleeping=1;
+        task_set_block(curr);
+        if(ticks>=0){
+            task_set_sleep(curr,ticks ? ticks : 1);
+        }
+        task_dispatch();
+        table->sleeping=0;
+    }
+
+    int triggered=table->triggered;
+    table->triggered=0;
+    irq_leave_protection(state);
+    return triggered;
+}
+
+/**
+ * @brief 将poll表从全部等待队列中移除
+ * @param table poll表
+ */
+void poll_table_free(poll_table_t* table){
+    irq_state_t state=irq_enter_protection();
+    for(int i=0;i<table->count;i++){
+        poll_entry_t* entry=table->entries+i;
+        list_remove(&entry->wq->list,&entry->node);
+    }
+    table->count=0;
+    irq_leave_protection(state);
+}
\ No newline at end of file
@@ -31,6 +31,29 @@ void list_insert_last(list_t*list,list_node_t*node){
     list->count++;
 }
 
+/**
+ * @brief 将节点插入到指定节点之前
+ * @param list 具体要操作的链表
+ * @param next 插入位置之后的节点，为0时插入到链表末尾
+ * @param node 要插入的节点
+ */
+void list_insert_before(list_t* list,list_node_t* next,list_node_t* node){
+    if(next==(list_node_t*)0){
+        list_insert_last(list,node);
+        return;
+    }
+    if(next==list->first){
+        list_insert_first(list,node);
+        return;
+    }
+
+    node->pre=next->pre;
+    node->next=next;
+    next->pre->next=node;
+    next->pre=node;
+    list->count++;
+}
+
 /**
  * @brief 删除链表的第一个节点
  * @param list 具体要操作的链表
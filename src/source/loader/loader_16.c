@@ -107,8 +107,10 @@ static void entry_protect_mode(void){
  * @note 如果远跳转失败该函数会死循环
  */
 void loader_entry(void) {
+	boot_info.tsc[BOOT_TSC_LOADER]=rdtsc();
     show_msg("....loading.....\r\n");
 	detect_memory();
+	boot_info.tsc[BOOT_TSC_MEMORY]=rdtsc();
 	entry_protect_mode();
     for(;;) {}
 }
@@ -75,13 +75,17 @@ static void die(int code){
 }
 
 void load_kernel(void){
+	boot_info.tsc[BOOT_TSC_PROTECT]=rdtsc();
+
 	// (uint8_t*)指针是32位的四字节不是一字节别弄晕了
 	// 读取kernel.elf把他放在1MB的位置 kernel大小为250kb
     read_disk(100,500,(uint8_t*)SYS_KERNEL_LOAD_ADDR);
+	boot_info.tsc[BOOT_TSC_DISK]=rdtsc();
 	uint32_t kernel_entry=reload_elf_file((uint8_t*)SYS_KERNEL_LOAD_ADDR);
 	if(kernel_entry==0){
 		die(-1);
 	}
+	boot_info.tsc[BOOT_TSC_ELF]=rdtsc();
 	// 这里boot_info传递到kernel/Start.S
     ((void (*)(boot_info_t*))kernel_entry)(&boot_info);
 }
\ No newline at end of file
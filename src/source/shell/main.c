@@ -1,12 +1,14 @@
 #include "lib_syscall.h"
 #include "main.h"
 #include "fs/file.h"
+#include "core/syscall.h"
 
 #include <stdio.h>
 #include <string.h>
 #include <getopt.h>
 #include <stdlib.h>
 #include <sys/file.h>
+#include <sys/wait.h>
 
 /// @brief shell的命令行结构体
 static cli_t cli;
@@ -145,7 +147,7 @@ static int do_less(int argc,char **argv){
         switch(ch){
             case 'h':
                 puts("show file content");
-                puts("Usage: less [-l] file");
+                puts("Usage: less [-l] [file], read stdin without file");
                 optind = 1;
                 return 0;
             case 'l':
@@ -162,127 +164,1376 @@ static int do_less(int argc,char **argv){
         }
     }
 
-    if(optind > argc - 1){
+    // 没有指定文件时读取标准输入，用于管道的末端
+    FILE* file=stdin;
+    if(optind <= argc - 1){
+        file=fopen(argv[optind],"r");
+    }
+    else if(line_mode){
+        fprintf(stderr,"no file\n");
+        optind = 1;
+        return -1;
+    }
+
+    if(file == NULL){
+        fprintf(stderr,"open file %s failed\n",argv[optind]);
+        optind =1;
+        return -1;
+    }
+
+    char* buf=(char*)malloc(256);
+    if(line_mode == 0){
+        while(fgets(buf,256,file) != NULL){
+            fputs(buf,stdout);
+        }
+    }
+    else{
+        // 设置stdin为无缓冲模式
+        // 这样可以实时读取用户输入的字符
+        setvbuf(stdin,NULL,_IONBF,0);
+
+         // 关闭回显,0x1表示关闭回显TTY_CMD_ECHO这里有些问题就用0x1代替
+        ioctl(0,0x1,0,0);
+        while(1){
+            char *b=fgets(buf,256,file);
+            if(b == NULL){
+                break;
+            }
+
+            fputs(buf,stdout);
+
+            int ch;
+            while((ch=fgetc(stdin))!='n'){
+                if(ch == 'q'){
+                    goto less_quit;
+                }
+            }
+        }
+less_quit:
+        setvbuf(stdin,NULL,_IOFBF,BUFSIZ); // 恢复stdin的缓冲模式
+        ioctl(0,0x1,1,0);
+    }
+
+    free(buf);
+
+    if(file != stdin){
+        fclose(file);
+    }
+    optind = 1;
+    return 0;
+
+}
+
+/**
+ * @brief 查找可执行文件的路径
+ * @param filename 文件名
+ * @return 返回文件的路径，如果没有找到则返回NULL
+ */
+static const char* find_exec_path(const char* filename){
+    int fd=open(filename,0);
+    if(fd<0){
+        return (const char*)0;
+    }
+
+    close(fd);
+    return filename;
+}
+
+/**
+ * @brief 复制文件的函数
+ * @param argc 参数数量
+ * @param argv 参数的字符串
+ */
+static int do_cp(int argc,char** argv){
+    if(argc < 3){
+        fprintf(stderr,"no [from] or [to] file\n");
+        return -1;
+    }
+
+    int err=0;
+    char* buf=(char*)0;
+    syscall_batch_t* batch=(syscall_batch_t*)0;
+
+    int from=open(argv[1],O_RDONLY);
+    int to=open(argv[2],O_WRONLY | O_CREAT | O_TRUNC);
+    if(from<0 || to<0){
+        fprintf(stderr,"open file failed\n");
+        err=-1;
+        goto cp_failed;
+    }
+
+    buf=(char*)malloc(CP_CHUNK_SIZE*CP_BATCH_NR);
+    batch=(syscall_batch_t*)malloc(sizeof(syscall_batch_t));
+    if(!buf || !batch){
+        fprintf(stderr,"no memory\n");
+        err=-1;
+        goto cp_failed;
+    }
+
+    // 每轮用一次批量调用读入多块，再用一次批量调用写出，读到不足一块说明已到文件末尾
+    int done=0;
+    while(!done){
+        batch_init(batch);
+        for(int i=0;i<CP_BATCH_NR;i++){
+            batch_read(batch,from,buf+i*CP_CHUNK_SIZE,CP_CHUNK_SIZE);
+        }
+        batch_submit(batch,BATCH_STOP_ON_ERROR);
+
+        int sizes[CP_BATCH_NR];
+        for(int i=0;i<CP_BATCH_NR;i++){
+            sizes[i]=batch->results[i];
+        }
+
+        // 记录每项写入请求的长度，写入的字节数不足也算作失败
+        int wsizes[CP_BATCH_NR];
+        batch_init(batch);
+        for(int i=0;i<CP_BATCH_NR;i++){
+            if(sizes[i]<0){
+                fprintf(stderr,"read %s failed\n",argv[1]);
+                err=-1;
+                done=1;
+                break;
+            }
+            if(sizes[i]>0){
+                int n=batch_write(batch,to,buf+i*CP_CHUNK_SIZE,sizes[i]);
+                if(n>=0){
+                    wsizes[n]=sizes[i];
+                }
+            }
+            if(sizes[i]<CP_CHUNK_SIZE){
+                done=1;
+                break;
+            }
+        }
+
+        int count=batch_submit(batch,BATCH_STOP_ON_ERROR);
+        int short_write=0;
+        for(int i=0;i<count;i++){
+            if(batch->results[i]!=wsizes[i]){
+                short_write=1;
+                break;
+            }
+        }
+        if(count<batch->count || short_write){
+            fprintf(stderr,"write %s failed\n",argv[2]);
+            err=-1;
+            break;
+        }
+    }
+
+cp_failed:
+    if(buf){
+        free(buf);
+    }
+    if(batch){
+        free(batch);
+    }
+
+    // 两个文件在同一次批量调用中关闭
+    syscall_batch_t close_batch;
+    batch_init(&close_batch);
+    if(from>=0){
+        batch_close(&close_batch,from);
+    }
+    if(to>=0){
+        batch_close(&close_batch,to);
+    }
+    batch_submit(&close_batch,0);
+
+    return err;
+}
+
+static int do_rm(int argc,char** argv){
+    if(argc < 2){
         fprintf(stderr,"no file\n");
+        return -1;
+    }
+
+    int err = unlink(argv[1]);
+    if(err < 0){
+        fprintf(stderr,"remove file %s failed\n",argv[1]);
+        return err;
+    }
+
+    return 0;
+}
+
+/// @brief 平均负载的整数部分和两位小数部分，定点数的低11位为小数
+#define LOAD_INT(x)     ((x) >> 11)
+#define LOAD_FRAC(x)    ((((x) & ((1 << 11)-1))*100) >> 11)
+
+/**
+ * @brief 打印系统运行时间、任务数量和平均负载
+ * @param sys 系统信息
+ */
+static void print_sys_info(sys_info_t* sys){
+    unsigned int secs=sys->ticks*sys->tick_ms/1000;
+    printf("up %d s, tasks: %d, running: %d, load average: %d.%02d %d.%02d %d.%02d\n",
+        secs,sys->task_count,sys->nr_running,
+        LOAD_INT(sys->loadavg[0]),LOAD_FRAC(sys->loadavg[0]),
+        LOAD_INT(sys->loadavg[1]),LOAD_FRAC(sys->loadavg[1]),
+        LOAD_INT(sys->loadavg[2]),LOAD_FRAC(sys->loadavg[2])
+    );
+}
+
+/**
+ * @brief ps命令，显示所有任务的cpu时间和切换次数
+ * @param argc 参数数量
+ * @param argv 参数的字符串
+ */
+static int do_ps(int argc,char** argv){
+    task_info_t* info=(task_info_t*)malloc(sizeof(task_info_t)*TASK_INFO_MAX);
+    if(info == NULL){
+        fprintf(stderr,"no memory\n");
+        return -1;
+    }
+
+    sys_info_t sys;
+    get_sys_info(&sys);
+    int count=get_task_info(info,TASK_INFO_MAX);
+
+    print_sys_info(&sys);
+    printf("  PID  PPID S PRI   UTIME(ms)   STIME(ms)    NVCSW   NIVCSW   WAIT(ms) NAME\n");
+    for(int i=0;i<count;i++){
+        task_info_t* task=info+i;
+        printf("%5d %5d %c %3d %11u %11u %8u %8u %10u %s\n",
+            task->pid,task->ppid,task->state,task->prio,
+            task->utime*sys.tick_ms,task->stime*sys.tick_ms,
+            task->nvcsw,task->nivcsw,task->wait_ticks*sys.tick_ms,
+            task->name
+        );
+    }
+
+    free(info);
+    return 0;
+}
+
+/**
+ * @brief 在上一次采样中查找同一个任务的cpu时间
+ * @param info 上一次采样的任务信息
+ * @param count 上一次采样的任务数量
+ * @param pid 任务的pid
+ * @return 上一次采样的cpu时间，没有找到返回0
+ */
+static unsigned int prev_cpu_ticks(task_info_t* info,int count,int pid){
+    for(int i=0;i<count;i++){
+        if(info[i].pid == pid){
+            return info[i].utime+info[i].stime;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief top命令，按采样间隔内的cpu占用率从高到低显示任务
+ * @param argc 参数数量
+ * @param argv 参数的字符串
+ */
+static int do_top(int argc,char** argv){
+    int iterations=1;
+    int delay=1000;
+
+    int ch;
+    while((ch=getopt(argc,argv,"n:d:h"))!=-1){
+        switch(ch){
+            case 'h':
+                puts("show tasks sorted by cpu usage");
+                puts("Usage: top [-n iterations] [-d delay_ms]");
+                optind = 1;
+                return 0;
+            case 'n':
+                iterations=atoi(optarg);
+                break;
+            case 'd':
+                delay=atoi(optarg);
+                break;
+            case '?':
+                optind = 1;
+                return -1;
+            default:
+                break;
+        }
+    }
+    optind = 1;
+
+    task_info_t* prev=(task_info_t*)malloc(sizeof(task_info_t)*TASK_INFO_MAX);
+    task_info_t* curr=(task_info_t*)malloc(sizeof(task_info_t)*TASK_INFO_MAX);
+    unsigned int* delta=(unsigned int*)malloc(sizeof(unsigned int)*TASK_INFO_MAX);
+    int* order=(int*)malloc(sizeof(int)*TASK_INFO_MAX);
+    if(!prev || !curr || !delta || !order){
+        fprintf(stderr,"no memory\n");
+        goto top_end;
+    }
+
+    sys_info_t sys;
+    get_sys_info(&sys);
+    unsigned int prev_ticks=sys.ticks;
+    int prev_count=get_task_info(prev,TASK_INFO_MAX);
+
+    for(int n=0;n<iterations;n++){
+        msleep(delay);
+
+        get_sys_info(&sys);
+        int count=get_task_info(curr,TASK_INFO_MAX);
+        unsigned int elapsed=sys.ticks-prev_ticks;
+        if(elapsed == 0){
+            elapsed=1;
+        }
+
+        // 按采样间隔内的cpu时间插入排序
+        for(int i=0;i<count;i++){
+            delta[i]=curr[i].utime+curr[i].stime-prev_cpu_ticks(prev,prev_count,curr[i].pid);
+
+            int j=i;
+            while((j>0) && (delta[order[j-1]]<delta[i])){
+                order[j]=order[j-1];
+                j--;
+            }
+            order[j]=i;
+        }
+
+        printf("%s%s",ESC_CLEAR_SCREEN,ESC_MOVE_CURSOR(0,0));
+        print_sys_info(&sys);
+        printf("  PID S  %%CPU    NVCSW   NIVCSW NAME\n");
+        for(int i=0;i<count;i++){
+            task_info_t* task=curr+order[i];
+            unsigned int usage=delta[order[i]]*1000/elapsed;
+            printf("%5d %c %3u.%u %8u %8u %s\n",
+                task->pid,task->state,usage/10,usage%10,
+                task->nvcsw,task->nivcsw,task->name
+            );
+        }
+
+        task_info_t* tmp=prev;
+        prev=curr;
+        curr=tmp;
+        prev_count=count;
+        prev_ticks=sys.ticks;
+    }
+
+top_end:
+    free(prev);
+    free(curr);
+    free(delta);
+    free(order);
+    return 0;
+}
+
+/**
+ * @brief 以直方图形式打印log2分桶的统计结果
+ * @param hist 各个桶的计数
+ * @param count 桶的数量
+ */
+static void print_log2_hist(unsigned int* hist,int count){
+    unsigned int max=0;
+    for(int i=0;i<count;i++){
+        if(hist[i]>max){
+            max=hist[i];
+        }
+    }
+    if(max == 0){
+        return;
+    }
+
+    for(int i=0;i<count;i++){
+        if(hist[i] == 0){
+            continue;
+        }
+
+        printf("  2^%-2d %8u |",i,hist[i]);
+        int bar=hist[i]*40/max;
+        for(int j=0;j<bar;j++){
+            putchar('#');
+        }
+        putchar('\n');
+    }
+}
+
+/**
+ * @brief schedlat命令，显示任务从就绪到运行的调度延迟直方图
+ * @param argc 参数数量
+ * @param argv 参数的字符串
+ */
+static int do_schedlat(int argc,char** argv){
+    int pid=0;
+    int reset=0;
+
+    int ch;
+    while((ch=getopt(argc,argv,"p:rh"))!=-1){
+        switch(ch){
+            case 'h':
+                puts("show scheduler wakeup latency in cpu cycles");
+                puts("Usage: schedlat [-p pid] [-r]");
+                optind = 1;
+                return 0;
+            case 'p':
+                pid=atoi(optarg);
+                break;
+            case 'r':
+                reset=1;
+                break;
+            case '?':
+                optind = 1;
+                return -1;
+            default:
+                break;
+        }
+    }
+    optind = 1;
+
+    sched_lat_t* lat=(sched_lat_t*)malloc(sizeof(sched_lat_t));
+    if(lat == NULL){
+        fprintf(stderr,"no memory\n");
+        return -1;
+    }
+
+    if(sched_lat(pid,lat,reset)<0){
+        fprintf(stderr,"no task %d\n",pid);
+        free(lat);
+        return -1;
+    }
+
+    printf("%s latency, samples: %u, max: %u Kcycles (pid %d %s)\n",
+        pid ? "task" : "global",lat->count,(unsigned int)(lat->max >> 10),
+        lat->max_pid,lat->max_name
+    );
+    print_log2_hist(lat->hist,SCHED_LAT_BUCKETS);
+
+    free(lat);
+    return 0;
+}
+
+/**
+ * @brief irqoff命令，显示关中断时间最长的调用位置
+ * @param argc 参数数量
+ * @param argv 参数的字符串
+ */
+static int do_irqoff(int argc,char** argv){
+    int flags=0;
+
+    int ch;
+    while((ch=getopt(argc,argv,"redh"))!=-1){
+        switch(ch){
+            case 'h':
+                puts("show the longest interrupts-off spans, addresses are in kernel_dis.txt");
+                puts("tracing is off by default, -e turns it on and -d turns it off");
+                puts("Usage: irqoff [-r] [-e|-d]");
+                optind = 1;
+                return 0;
+            case 'r':
+                flags|=IRQOFF_RESET;
+                break;
+            case 'e':
+                flags|=IRQOFF_ENABLE;
+                break;
+            case 'd':
+                flags|=IRQOFF_DISABLE;
+                break;
+            case '?':
+                optind = 1;
+                return -1;
+            default:
+                break;
+        }
+    }
+    optind = 1;
+
+    irqoff_info_t* info=(irqoff_info_t*)malloc(sizeof(irqoff_info_t));
+    if(info == NULL){
+        fprintf(stderr,"no memory\n");
+        return -1;
+    }
+
+    irqoff_trace(info,flags);
+
+    printf("irqs-off tracing: %s\n",info->enabled ? "on" : "off");
+    printf("irqs-off spans: %u, max: %u us, avg: %u ns\n",
+        info->count,info->max_ns/1000,info->avg_ns);
+    printf("    MAX(us)    COUNT      ENTER      LEAVE\n");
+    for(int i=0;i<info->nr;i++){
+        irqoff_span_t* span=info->spans+i;
+        printf("%11u %8u 0x%08x 0x%08x\n",
+            span->max_ns/1000,span->count,span->enter_ip,span->leave_ip);
+    }
+
+    free(info);
+    return 0;
+}
+
+/**
+ * @brief 连续执行count次获取pid，返回总耗时，单位微秒
+ * @param count 执行次数
+ * @param func 获取pid的方式
+ */
+static uint32_t sysbench_run(int count,int (*func)(void)){
+    struct timespec start,end;
+    clock_gettime(CLOCK_MONOTONIC,&start);
+    for(int i=0;i<count;i++){
+        func();
+    }
+    clock_gettime(CLOCK_MONOTONIC,&end);
+
+    return (uint32_t)(end.tv_sec-start.tv_sec)*1000000
+        +(end.tv_nsec-start.tv_nsec)/1000;
+}
+
+/**
+ * @brief 将总耗时换算为每次调用的纳秒数，避免用户态的64位除法
+ */
+static uint32_t sysbench_per_call_ns(uint32_t us,int count){
+    return us/count*1000+(us%count)*1000/count;
+}
+
+static int do_sysbench(int argc,char** argv){
+    int count=100000;
+
+    int ch;
+    while((ch=getopt(argc,argv,"n:h"))!=-1){
+        switch(ch){
+            case 'h':
+                puts("measure getpid latency via sysenter, call gate and the vdso page");
+                puts("Usage: sysbench [-n count]");
+                optind = 1;
+                return 0;
+            case 'n':
+                count=atoi(optarg);
+                break;
+            case '?':
+                optind = 1;
+                return -1;
+            default:
+                break;
+        }
+    }
+    optind = 1;
+
+    if(count<=0){
+        fprintf(stderr,"invalid count\n");
+        return -1;
+    }
+
+    int old=syscall_use_sysenter(1);
+    if(syscall_use_sysenter(1)){
+        uint32_t us=sysbench_run(count,getpid_syscall);
+        printf("sysenter:  %u calls, %u us, %u ns/call\n",count,us,sysbench_per_call_ns(us,count));
+    }
+    else{
+        printf("sysenter:  not supported\n");
+    }
+
+    syscall_use_sysenter(0);
+    uint32_t us=sysbench_run(count,getpid_syscall);
+    printf("call gate: %u calls, %u us, %u ns/call\n",count,us,sysbench_per_call_ns(us,count));
+
+    us=sysbench_run(count,getpid);
+    printf("vdso:      %u calls, %u us, %u ns/call\n",count,us,sysbench_per_call_ns(us,count));
+
+    syscall_use_sysenter(old);
+    return 0;
+}
+
+/**
+ * @brief 计算从start到现在经过的微秒数
+ */
+static uint32_t elapsed_us(struct timespec* start){
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC,&end);
+    return (uint32_t)(end.tv_sec-start->tv_sec)*1000000
+        +(end.tv_nsec-start->tv_nsec)/1000;
+}
+
+/**
+ * @brief 用异步I/O环读取整个文件，保持depth个请求同时进行
+ * @param fd 文件
+ * @param buf depth个AIO_CHUNK_SIZE大小的缓冲区
+ * @param depth 同时进行的请求数
+ * @return 读取的字节数，失败返回-1
+ */
+static int aiobench_read(int fd,char* buf,int depth){
+    aio_ring_t* ring=aio_setup();
+    if(ring==(aio_ring_t*)0){
+        return -1;
+    }
+
+    // 每个请求独占一个缓冲区槽位，user_data保存槽位号，完成后归还
+    char busy[AIO_SQ_ENTRIES];
+    memset(busy,0,sizeof(busy));
+
+    int total=0;
+    uint32_t offset=0;
+    int inflight=0;
+    int eof=0;
+    for(;;){
+        for(int slot=0;!eof && slot<depth;slot++){
+            if(busy[slot]){
+                continue;
+            }
+            aio_sqe_t* sqe=aio_get_sqe(ring);
+            if(sqe==(aio_sqe_t*)0){
+                break;
+            }
+            aio_prep_rw(sqe,AIO_OP_READ,fd,buf+slot*AIO_CHUNK_SIZE,AIO_CHUNK_SIZE,offset,slot);
+            busy[slot]=1;
+            offset+=AIO_CHUNK_SIZE;
+            inflight++;
+        }
+        if(inflight==0){
+            break;
+        }
+
+        aio_enter(1);
+
+        aio_cqe_t cqe;
+        while(aio_peek_cqe(ring,&cqe)){
+            busy[cqe.user_data]=0;
+            inflight--;
+            if(cqe.res<=0){
+                eof=1;
+                if(cqe.res<0){
+                    total=-1;
+                }
+                continue;
+            }
+            if(total>=0){
+                total+=cqe.res;
+            }
+            if(cqe.res<AIO_CHUNK_SIZE){
+                eof=1;
+            }
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief 提交一个读请求并等待其完成
+ * @param ring 异步I/O环
+ * @param fd 文件
+ * @param buf 读入的用户地址
+ * @return 完成项的结果
+ */
+static int aiobench_read_one(aio_ring_t* ring,int fd,void* buf){
+    aio_sqe_t* sqe=aio_get_sqe(ring);
+    if(sqe==(aio_sqe_t*)0){
+        return -1;
+    }
+    aio_prep_rw(sqe,AIO_OP_READ,fd,buf,AIO_CHECK_SIZE,0,0);
+    aio_enter(1);
+
+    aio_cqe_t cqe;
+    if(!aio_peek_cqe(ring,&cqe)){
+        return -1;
+    }
+    return cqe.res;
+}
+
+/**
+ * @brief 检查内核拒绝非法的异步I/O请求：负数的min_complete、读入只读的vdso页、读入未映射的页
+ * @param fd 文件
+ * @return 全部被拒绝返回0，否则返回-1
+ * @note AIO_RING_ADDR之后的一页与vdso页共用页表，但本身没有映射
+ */
+static int aiobench_check(int fd){
+    aio_ring_t* ring=aio_setup();
+    if(ring==(aio_ring_t*)0){
+        fprintf(stderr,"aio setup failed\n");
+        return -1;
+    }
+
+    int err=0;
+    if(aio_enter(-1)>=0){
+        fprintf(stderr,"aio_enter(-1) accepted\n");
+        err=-1;
+    }
+    if(aiobench_read_one(ring,fd,(void*)VDSO_ADDR)>=0){
+        fprintf(stderr,"read into vdso page accepted\n");
+        err=-1;
+    }
+    if(aiobench_read_one(ring,fd,(void*)(AIO_RING_ADDR+0x1000))>=0){
+        fprintf(stderr,"read into unmapped page accepted\n");
+        err=-1;
+    }
+
+    puts(err ? "aio check failed" : "aio check passed");
+    return err;
+}
+
+/**
+ * @brief aiobench命令，比较同步读和异步I/O环读取同一个文件的耗时
+ * @param argc 参数数量
+ * @param argv 参数的字符串
+ */
+static int do_aiobench(int argc,char** argv){
+    int depth=AIO_DEPTH;
+    int check=0;
+
+    int ch;
+    while((ch=getopt(argc,argv,"d:th"))!=-1){
+        switch(ch){
+            case 'h':
+                puts("read a file with read() and with the async I/O ring");
+                puts("Usage: aiobench [-d depth] [-t] file");
+                puts("  -t  check that invalid requests are rejected instead of measuring");
+                optind = 1;
+                return 0;
+            case 'd':
+                depth=atoi(optarg);
+                break;
+            case 't':
+                check=1;
+                break;
+            case '?':
+                optind = 1;
+                return -1;
+            default:
+                break;
+        }
+    }
+
+    if((optind > argc - 1) || (depth<=0) || (depth>AIO_SQ_ENTRIES)){
+        fprintf(stderr,"Usage: aiobench [-d depth] [-t] file\n");
+        optind = 1;
+        return -1;
+    }
+    const char* path=argv[optind];
+    optind = 1;
+
+    if(check){
+        int fd=open(path,0);
+        if(fd<0){
+            fprintf(stderr,"open file %s failed\n",path);
+            return -1;
+        }
+        int err=aiobench_check(fd);
+        close(fd);
+        return err;
+    }
+
+    char* buf=(char*)malloc(AIO_CHUNK_SIZE*depth);
+    if(buf == NULL){
+        fprintf(stderr,"no memory\n");
+        return -1;
+    }
+
+    int fd=open(path,0);
+    if(fd<0){
+        fprintf(stderr,"open file %s failed\n",path);
+        free(buf);
+        return -1;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC,&start);
+    int total=0,cnt;
+    while((cnt=read(fd,buf,AIO_CHUNK_SIZE))>0){
+        total+=cnt;
+    }
+    uint32_t us=elapsed_us(&start);
+    printf("read():   %d bytes, %u us\n",total,us);
+
+    clock_gettime(CLOCK_MONOTONIC,&start);
+    total=aiobench_read(fd,buf,depth);
+    us=elapsed_us(&start);
+    if(total<0){
+        fprintf(stderr,"async read failed\n");
+    }
+    else{
+        printf("aio x%-3d: %d bytes, %u us\n",depth,total,us);
+    }
+
+    close(fd);
+    free(buf);
+    return total<0 ? -1 : 0;
+}
+
+/**
+ * @brief sockbench的客户端，每次请求新建一个连接，发送消息并等待回复
+ * @param count 请求次数
+ * @return 成功的请求次数
+ */
+static int sockbench_client(int count){
+    struct sockaddr_un addr;
+    memset(&addr,0,sizeof(addr));
+    addr.sun_family=AF_LOCAL;
+    strcpy(addr.sun_path,SOCKBENCH_NAME);
+
+    char msg[SOCKBENCH_MSG];
+    int done=0;
+    for(int i=0;i<count;i++){
+        int fd=socket(AF_LOCAL,SOCK_STREAM,0);
+        if(fd<0){
+            break;
+        }
+
+        // 监听队列满时等服务端accept后重试
+        while(connect(fd,&addr,sizeof(addr))<0){
+            yield();
+        }
+
+        memset(msg,i,sizeof(msg));
+        if((write(fd,msg,sizeof(msg))==sizeof(msg)) && (read(fd,msg,sizeof(msg))==sizeof(msg))){
+            done++;
+        }
+        close(fd);
+    }
+    return done;
+}
+
+/**
+ * @brief sockbench命令，测量短连接客户端通过本地套接字请求一次的耗时
+ * @param argc 参数数量
+ * @param argv 参数的字符串
+ */
+static int do_sockbench(int argc,char** argv){
+    int count=1000;
+
+    int ch;
+    while((ch=getopt(argc,argv,"n:h"))!=-1){
+        switch(ch){
+            case 'h':
+                puts("measure connect + request + reply latency over local sockets");
+                puts("Usage: sockbench [-n count]");
+                optind = 1;
+                return 0;
+            case 'n':
+                count=atoi(optarg);
+                break;
+            case '?':
+                optind = 1;
+                return -1;
+            default:
+                break;
+        }
+    }
+    optind = 1;
+
+    if(count<=0){
+        fprintf(stderr,"invalid count\n");
+        return -1;
+    }
+
+    // 先开始监听再创建客户端，客户端不需要等待服务端就绪
+    struct sockaddr_un addr;
+    memset(&addr,0,sizeof(addr));
+    addr.sun_family=AF_LOCAL;
+    strcpy(addr.sun_path,SOCKBENCH_NAME);
+
+    int server=socket(AF_LOCAL,SOCK_STREAM,0);
+    if((server<0) || (bind(server,&addr,sizeof(addr))<0) || (listen(server,0)<0)){
+        fprintf(stderr,"listen on %s failed\n",SOCKBENCH_NAME);
+        if(server>=0){
+            close(server);
+        }
+        return -1;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC,&start);
+
+    int pid=fork();
+    if(pid<0){
+        fprintf(stderr,"fork failed\n");
+        close(server);
+        return -1;
+    }
+    else if(pid==0){
+        close(server);
+        exit(sockbench_client(count));
+    }
+
+    char msg[SOCKBENCH_MSG];
+    for(int i=0;i<count;i++){
+        int fd=accept(server,(struct sockaddr_un*)0,(int*)0);
+        if(fd<0){
+            break;
+        }
+
+        int cnt=read(fd,msg,sizeof(msg));
+        if(cnt>0){
+            write(fd,msg,cnt);
+        }
+        close(fd);
+    }
+    close(server);
+
+    int status=0;
+    waitpid(pid,&status,0);
+    uint32_t us=elapsed_us(&start);
+    printf("%d/%d requests, %u us, %u us/request\n",status,count,us,us/count);
+    return 0;
+}
+
+/// @brief 系统调用号对应的名称，用于sysstat和strace的显示
+static const char* const syscall_names[SYSCALL_STAT_NR]={
+    [SYS_SLEEP]="msleep",
+    [SYS_GETPID]="getpid",
+    [SYS_FORK]="fork",
+    [SYS_EXECVE]="execve",
+    [SYS_YIELD]="yield",
+    [SYS_EXIT]="exit",
+    [SYS_WAIT]="wait",
+    [SYS_WAITPID]="waitpid",
+    [SYS_TASK_INFO]="task_info",
+    [SYS_SYS_INFO]="sys_info",
+    [SYS_SCHED_LAT]="sched_lat",
+    [SYS_CLOCK_GETTIME]="clock_gettime",
+    [SYS_GETTIMEOFDAY]="gettimeofday",
+    [SYS_THREAD_CREATE]="thread_create",
+    [SYS_THREAD_JOIN]="thread_join",
+    [SYS_FUTEX]="futex",
+    [SYS_SETPRIO]="setprio",
+    [SYS_IRQOFF_TRACE]="irqoff_trace",
+    [SYS_BATCH]="batch",
+    [SYS_SYSCALL_CTL]="syscall_ctl",
+    [SYS_SYSCALL_STAT]="syscall_stat",
+    [SYS_SYSCALL_TRACE]="syscall_trace",
+    [SYS_PROF_CTL]="prof_ctl",
+    [SYS_PROF_READ]="prof_read",
+    [SYS_KSYM_LOOKUP]="ksym_lookup",
+    [SYS_BOOT_TIME]="boot_time",
+    [SYS_OPEN]="open",
+    [SYS_READ]="read",
+    [SYS_WRITE]="write",
+    [SYS_CLOSE]="close",
+    [SYS_LSEEK]="lseek",
+    [SYS_ISATTY]="isatty",
+    [SYS_SBRK]="sbrk",
+    [SYS_FSTAT]="fstat",
+    [SYS_DUP]="dup",
+    [SYS_IOCTL]="ioctl",
+    [SYS_OPENDIR]="opendir",
+    [SYS_READDIR]="readdir",
+    [SYS_CLOSEDIR]="closedir",
+    [SYS_UNLINK]="unlink",
+    [SYS_PIPE]="pipe",
+    [SYS_POLL]="poll",
+    [SYS_AIO_SETUP]="aio_setup",
+    [SYS_AIO_ENTER]="aio_enter",
+    [SYS_SOCKET]="socket",
+    [SYS_BIND]="bind",
+    [SYS_LISTEN]="listen",
+    [SYS_ACCEPT]="accept",
+    [SYS_CONNECT]="connect",
+    [SYS_PRINT_MSG]="print_msg"
+};
+
+/**
+ * @brief 获取系统调用的名称
+ * @param id 系统调用号
+ * @return 名称，未知的调用号返回"?"
+ */
+static const char* syscall_name(uint32_t id){
+    if(id<SYSCALL_STAT_NR && syscall_names[id]){
+        return syscall_names[id];
+    }
+    return "?";
+}
+
+/**
+ * @brief 打印按调用号的统计表，只显示调用过的系统调用
+ * @param stat 统计，共SYSCALL_STAT_NR项
+ * @param show_hist 为1时显示每个系统调用的耗时分布
+ */
+static void print_syscall_stat(syscall_stat_t* stat,int show_hist){
+    printf("%-14s %8s %6s %10s %8s %8s\n","NAME","COUNT","ERR","TOTAL(us)","AVG(ns)","MAX(ns)");
+    for(int i=0;i<SYSCALL_STAT_NR;i++){
+        syscall_stat_t* s=stat+i;
+        if(s->count==0){
+            continue;
+        }
+
+        // 用户态没有64位除法，总耗时超过32位时用乘法和移位近似除以1000，再以微秒计算平均值
+        uint32_t total_us,avg_ns;
+        if(s->total_ns >> 32){
+            total_us=(uint32_t)(((s->total_ns >> 10)*1049) >> 10);
+            avg_ns=total_us/s->count*1000;
+        }
+        else{
+            total_us=(uint32_t)s->total_ns/1000;
+            avg_ns=(uint32_t)s->total_ns/s->count;
+        }
+        printf("%-14s %8u %6u %10u %8u %8u\n",syscall_name(i),s->count,s->errors,total_us,avg_ns,s->max_ns);
+
+        if(!show_hist){
+            continue;
+        }
+        for(int j=0;j<SYSCALL_HIST_NR;j++){
+            if(s->hist[j]==0){
+                continue;
+            }
+            if(j==SYSCALL_HIST_NR-1){
+                printf("    >= %8u ns %8u\n",1u << (j+SYSCALL_HIST_SHIFT-1),s->hist[j]);
+            }
+            else{
+                printf("    <  %8u ns %8u\n",1u << (j+SYSCALL_HIST_SHIFT),s->hist[j]);
+            }
+        }
     }
+}
 
-    FILE* file=fopen(argv[optind],"r");
+/**
+ * @brief sysstat命令，显示按调用号的系统调用次数、错误数和耗时
+ * @param argc 参数数量
+ * @param argv 参数的字符串
+ */
+static int do_sysstat(int argc,char** argv){
+    int pid=SYSCALL_STAT_ALL;
+    int reset=0;
+    int show_hist=0;
 
-    if(file == NULL){
-        fprintf(stderr,"open file %s failed\n",argv[optind]);
-        optind =1;
+    int ch;
+    while((ch=getopt(argc,argv,"p:rHh"))!=-1){
+        switch(ch){
+            case 'h':
+                puts("show per-syscall count, errors and latency, -p needs syscall_ctl on the task");
+                puts("Usage: sysstat [-p pid] [-r] [-H]");
+                optind = 1;
+                return 0;
+            case 'p':
+                pid=atoi(optarg);
+                break;
+            case 'r':
+                reset=1;
+                break;
+            case 'H':
+                show_hist=1;
+                break;
+            case '?':
+                optind = 1;
+                return -1;
+            default:
+                break;
+        }
+    }
+    optind = 1;
+
+    syscall_stat_t* stat=(syscall_stat_t*)malloc(sizeof(syscall_stat_t)*SYSCALL_STAT_NR);
+    if(stat == NULL){
+        fprintf(stderr,"no memory\n");
         return -1;
     }
 
-    char* buf=(char*)malloc(256);
-    if(line_mode == 0){
-        while(fgets(buf,256,file) != NULL){
-            fputs(buf,stdout);
-        }
+    if(syscall_stat(pid,stat,reset)<0){
+        fprintf(stderr,"no syscall stat for task %d\n",pid);
+        free(stat);
+        return -1;
     }
-    else{
-        // 设置stdin为无缓冲模式
-        // 这样可以实时读取用户输入的字符
-        setvbuf(stdin,NULL,_IONBF,0);
 
-         // 关闭回显,0x1表示关闭回显TTY_CMD_ECHO这里有些问题就用0x1代替
-        ioctl(0,0x1,0,0);
-        while(1){
-            char *b=fgets(buf,256,file);
-            if(b == NULL){
-                break;
+    print_syscall_stat(stat,show_hist);
+    free(stat);
+    return 0;
+}
+
+/**
+ * @brief 取出并打印任务的跟踪记录
+ * @param pid 被跟踪的任务
+ * @param buf 临时缓冲区
+ * @param count buf的容量
+ * @param next 期望的下一条记录的序号，用于发现被覆盖的记录
+ * @return 打印的记录数
+ */
+static int strace_drain(int pid,syscall_trace_t* buf,int count,uint32_t* next){
+    int total=0;
+    int n;
+    while((n=syscall_trace(pid,buf,count))>0){
+        for(int i=0;i<n;i++){
+            syscall_trace_t* t=buf+i;
+            if(t->seq!=*next){
+                printf("... %u records lost\n",t->seq-*next);
             }
+            *next=t->seq+1;
+            printf("%s(0x%x, 0x%x, 0x%x, 0x%x) = %d <%u ns>\n",syscall_name(t->id),
+                t->args[0],t->args[1],t->args[2],t->args[3],t->ret,t->ns);
+        }
+        total+=n;
+    }
+    return total;
+}
 
-            fputs(buf,stdout);
+/**
+ * @brief strace命令，运行程序并打印它的每一次系统调用，结束后显示统计
+ * @param argc 参数数量
+ * @param argv 参数的字符串
+ */
+static int do_strace(int argc,char** argv){
+    if(argc<2 || !strcmp(argv[1],"-h")){
+        puts("run a program and print its system calls");
+        puts("Usage: strace cmd [args]");
+        return argc<2 ? -1 : 0;
+    }
 
-            int ch;
-            while((ch=fgetc(stdin))!='n'){
-                if(ch == 'q'){
-                    goto less_quit;
-                }
-            }
+    const char* path=find_exec_path(argv[1]);
+    if(path==(const char*)0){
+        fprintf(stderr,"no such file %s\n",argv[1]);
+        return -1;
+    }
+
+    syscall_trace_t* buf=(syscall_trace_t*)malloc(sizeof(syscall_trace_t)*SYSCALL_TRACE_NR);
+    syscall_stat_t* stat=(syscall_stat_t*)malloc(sizeof(syscall_stat_t)*SYSCALL_STAT_NR);
+    if(buf==NULL || stat==NULL){
+        fprintf(stderr,"no memory\n");
+        free(buf);
+        free(stat);
+        return -1;
+    }
+
+    int pid=fork();
+    if(pid<0){
+        fprintf(stderr,"fork failed\n");
+        free(buf);
+        free(stat);
+        return -1;
+    }
+    else if(pid==0){
+        // 跟踪选项在execve后保留，从新程序的第一条调用开始记录
+        syscall_ctl(0,SYSCALL_TRACK_STAT | SYSCALL_TRACK_TRACE);
+        execve(path,argv+1,(char * const *)0);
+        fprintf(stderr,"exec failed %s\n",path);
+        exit(-1);
+    }
+
+    // 子进程结束后先不回收，取完剩余的记录和统计后再回收
+    uint32_t next=0;
+    int status=0;
+    for(;;){
+        int done=waitpid(pid,&status,WNOHANG | WNOWAIT);
+        if(strace_drain(pid,buf,SYSCALL_TRACE_NR,&next)==0 && done==0){
+            msleep(10);
+        }
+        if(done!=0){
+            strace_drain(pid,buf,SYSCALL_TRACE_NR,&next);
+            break;
         }
-less_quit:
-        setvbuf(stdin,NULL,_IOFBF,BUFSIZ); // 恢复stdin的缓冲模式
-        ioctl(0,0x1,1,0);
     }
 
+    if(syscall_stat(pid,stat,0)==0){
+        print_syscall_stat(stat,0);
+    }
+    waitpid(pid,&status,0);
+    printf("+++ exited with %d +++\n",status);
+
     free(buf);
+    free(stat);
+    return 0;
+}
 
-    fclose(file);
-    optind = 1;
+/**
+ * @brief 采样的排序规则：内核态在前，用户态按pid分组，组内按地址排序
+ */
+static int prof_sample_cmp(const void* a,const void* b){
+    const prof_sample_t* x=(const prof_sample_t*)a;
+    const prof_sample_t* y=(const prof_sample_t*)b;
+    if(x->cpl!=y->cpl){
+        return x->cpl-y->cpl;
+    }
+    if(x->cpl && (x->pid!=y->pid)){
+        return x->pid-y->pid;
+    }
+    if(x->eip!=y->eip){
+        return x->eip<y->eip ? -1 : 1;
+    }
     return 0;
+}
 
+/**
+ * @brief 热点按采样次数从多到少排序
+ */
+static int prof_entry_cmp(const void* a,const void* b){
+    return ((const prof_entry_t*)b)->count-((const prof_entry_t*)a)->count;
 }
 
 /**
- * @brief 查找可执行文件的路径
- * @param filename 文件名
- * @return 返回文件的路径，如果没有找到则返回NULL
+ * @brief 读取全部采样，打印平坦的热点分布
+ * @param top 最多显示的项数
+ * @return 成功返回0，失败返回-1
+ * @note 内核态的采样按函数合并，用户态的采样按pid和地址合并
  */
-static const char* find_exec_path(const char* filename){
-    int fd=open(filename,0);
-    if(fd<0){
-        return (const char*)0;
+static int prof_report(int top){
+    prof_sample_t* samples=(prof_sample_t*)malloc(sizeof(prof_sample_t)*PROF_SAMPLE_NR);
+    prof_entry_t* entries=(prof_entry_t*)malloc(sizeof(prof_entry_t)*PROF_SAMPLE_NR);
+    if(samples==NULL || entries==NULL){
+        fprintf(stderr,"no memory\n");
+        free(samples);
+        free(entries);
+        return -1;
     }
 
-    close(fd);
-    return filename;
+    prof_info_t info;
+    int nr=prof_read(samples,0,PROF_SAMPLE_NR,&info);
+    if(nr<0){
+        free(samples);
+        free(entries);
+        return -1;
+    }
+    printf("%d samples, %u lost, one per %d ms\n",nr,info.lost,info.period_ms);
+
+    // 内核地址先换成所在函数的起始地址，找不到符号时保留原地址
+    for(int i=0;i<nr;i++){
+        if(samples[i].cpl==0){
+            uint32_t start=(uint32_t)ksym_lookup(samples[i].eip,(char*)0,0);
+            if(start){
+                samples[i].eip=start;
+            }
+        }
+    }
+    qsort(samples,nr,sizeof(prof_sample_t),prof_sample_cmp);
+
+    int count=0;
+    for(int i=0;i<nr;i++){
+        if(count && (prof_sample_cmp(samples+i-1,samples+i)==0)){
+            entries[count-1].count++;
+            continue;
+        }
+
+        prof_entry_t* entry=entries+count++;
+        entry->eip=samples[i].eip;
+        entry->pid=samples[i].pid;
+        entry->cpl=samples[i].cpl;
+        entry->count=1;
+    }
+    qsort(entries,count,sizeof(prof_entry_t),prof_entry_cmp);
+
+    char name[KSYM_NAME_SIZE];
+    puts(" samples      %  location");
+    for(int i=0;(i<count) && (i<top);i++){
+        prof_entry_t* entry=entries+i;
+        int permille=entry->count*1000/nr;
+        printf("%8d %3d.%d%%  ",entry->count,permille/10,permille%10);
+        if(entry->cpl){
+            printf("[u] pid %d 0x%08x\n",entry->pid,entry->eip);
+        }
+        else if(ksym_lookup(entry->eip,name,sizeof(name))){
+            printf("[k] %s\n",name);
+        }
+        else{
+            printf("[k] 0x%08x\n",entry->eip);
+        }
+    }
+
+    free(samples);
+    free(entries);
+    return 0;
 }
 
 /**
- * @brief 复制文件的函数
+ * @brief prof命令，以定时器中断采样，统计内核和用户程序的热点
  * @param argc 参数数量
  * @param argv 参数的字符串
+ * @note 指定命令时在命令运行期间采样；-s和-e分别单独开始、结束采样，便于对多个命令采样
  */
-static int do_cp(int argc,char** argv){
-    if(argc < 3){
-        fprintf(stderr,"no [from] or [to] file\n");
-        return -1;
-    }
-
-    FILE *from,*to;
+static int do_prof(int argc,char** argv){
+    int period=PROF_PERIOD_MS;
+    int top=PROF_TOP;
+    int start=0,end=0;
 
-    from=fopen(argv[1],"rb");
-    to=fopen(argv[2],"wb");
+    // 遇到第一个非选项参数即停止解析，其后是要运行的命令和它的参数
+    int ch;
+    while((ch=getopt(argc,argv,"+p:n:seh"))!=-1){
+        switch(ch){
+            case 'h':
+                puts("sample the interrupted address on every timer tick and print hot spots");
+                puts("Usage: prof [-p ms] [-n top] cmd [args]");
+                puts("       prof [-p ms] -s");
+                puts("       prof [-n top] -e");
+                optind = 1;
+                return 0;
+            case 'p':
+                period=atoi(optarg);
+                break;
+            case 'n':
+                top=atoi(optarg);
+                break;
+            case 's':
+                start=1;
+                break;
+            case 'e':
+                end=1;
+                break;
+            case '?':
+                optind = 1;
+                return -1;
+            default:
+                break;
+        }
+    }
+    int cmd=optind;
+    optind = 1;
 
-    if(!from || !to){
-        fprintf(stderr,"open file failed\n");
-        goto cp_failed;
+    if(period<=0 || top<=0){
+        fprintf(stderr,"invalid argument\n");
+        return -1;
     }
 
-    char *buf=(char*)malloc(256);
-    int size=0;
-    while((size=fread(buf,1,256,from))>0){
-        fwrite(buf,1,size,to);
+    if(start){
+        return prof_ctl(PROF_CMD_START,period);
+    }
+    if(end){
+        prof_ctl(PROF_CMD_STOP,0);
+        return prof_report(top);
+    }
+    if(cmd>=argc){
+        fprintf(stderr,"no command\n");
+        return -1;
     }
 
-    free(buf);
+    const char* path=find_exec_path(argv[cmd]);
+    if(path==(const char*)0){
+        fprintf(stderr,"no such file %s\n",argv[cmd]);
+        return -1;
+    }
 
-cp_failed:
-    if(from){
-        fclose(from);
+    if(prof_ctl(PROF_CMD_START,period)<0){
+        fprintf(stderr,"start profiling failed\n");
+        return -1;
     }
 
-    if(to){
-        fclose(to);
+    int pid=fork();
+    if(pid<0){
+        fprintf(stderr,"fork failed\n");
+        prof_ctl(PROF_CMD_STOP,0);
+        return -1;
+    }
+    else if(pid==0){
+        execve(path,argv+cmd,(char * const *)0);
+        fprintf(stderr,"exec failed %s\n",path);
+        exit(-1);
     }
 
-    return 0;
+    int status=0;
+    waitpid(pid,&status,0);
+    prof_ctl(PROF_CMD_STOP,0);
+    printf("pid %d exited with %d\n",pid,status);
+    return prof_report(top);
 }
 
-static int do_rm(int argc,char** argv){
-    if(argc < 2){
-        fprintf(stderr,"no file\n");
-        return -1;
+/**
+ * @brief boottime命令，显示启动过程各阶段的耗时
+ * @param argc 参数数量
+ * @param argv 参数的字符串
+ * @note 时间从CPU复位时算起，第一个阶段包含BIOS的执行时间
+ */
+static int do_boottime(int argc,char** argv){
+    if(argc>1){
+        puts("show how long each boot phase took, from cpu reset to the first program");
+        puts("Usage: boottime");
+        return strcmp(argv[1],"-h") ? -1 : 0;
     }
 
-    int err = unlink(argv[1]);
-    if(err < 0){
-        fprintf(stderr,"remove file %s failed\n",argv[1]);
-        return err;
+    boot_phase_t phases[BOOT_PHASE_NR];
+    int count=boot_time(phases,BOOT_PHASE_NR);
+    if(count<=0){
+        fprintf(stderr,"boot time not available\n");
+        return -1;
     }
 
+    // 按千分比显示占比，避免32位乘法溢出
+    uint32_t unit=phases[count-1].end_us/1000;
+    printf("%-20s %10s %10s      %%\n","phase","us","done at");
+    for(int i=0;i<count;i++){
+        uint32_t permille=unit ? phases[i].us/unit : 0;
+        printf("%-20s %10u %10u %4u.%u%%\n",phases[i].name,phases[i].us,phases[i].end_us,
+                permille/10,permille%10);
+    }
     return 0;
 }
 
@@ -327,6 +1578,61 @@ static const cli_cmd_t cmd_list[]={
         .name="rm",
         .usage="rm file - remove file",
         .do_func=do_rm,
+    },
+    {
+        .name="ps",
+        .usage="ps -- list tasks with cpu time and context switches",
+        .do_func=do_ps,
+    },
+    {
+        .name="top",
+        .usage="top [-n iterations] [-d delay_ms] -- show tasks sorted by cpu usage",
+        .do_func=do_top,
+    },
+    {
+        .name="schedlat",
+        .usage="schedlat [-p pid] [-r] -- show or reset scheduler wakeup latency",
+        .do_func=do_schedlat,
+    },
+    {
+        .name="irqoff",
+        .usage="irqoff [-r] [-e|-d] -- show or reset the longest interrupts-off spans, -e/-d turn tracing on/off",
+        .do_func=do_irqoff,
+    },
+    {
+        .name="sysbench",
+        .usage="sysbench [-n count] -- compare null syscall latency of sysenter and call gate",
+        .do_func=do_sysbench,
+    },
+    {
+        .name="sysstat",
+        .usage="sysstat [-p pid] [-r] [-H] -- show or reset per-syscall count and latency",
+        .do_func=do_sysstat,
+    },
+    {
+        .name="strace",
+        .usage="strace cmd [args] -- run a program and trace its system calls",
+        .do_func=do_strace,
+    },
+    {
+        .name="aiobench",
+        .usage="aiobench [-d depth] [-t] file -- compare read() with the async I/O ring",
+        .do_func=do_aiobench,
+    },
+    {
+        .name="sockbench",
+        .usage="sockbench [-n count] -- measure short-lived local socket request latency",
+        .do_func=do_sockbench,
+    },
+    {
+        .name="prof",
+        .usage="prof [-p ms] [-n top] [-s | -e | cmd [args]] -- sample kernel and user hot spots",
+        .do_func=do_prof,
+    },
+    {
+        .name="boottime",
+        .usage="boottime -- show how long each boot phase took",
+        .do_func=do_boottime,
     }
 };
 
@@ -396,11 +1702,142 @@ static void run_exec_file(const char* path,int argc,char** argv){
     }
     else{
         int status=0;
-        int pid=wait(&status);
+        pid=waitpid(pid,&status,0);
         fprintf(stderr,"cmd %s result: %d, pid=%d\n",path,pid,status);
     }
 }   
 
+/**
+ * @brief 将命令行按空格分割为参数
+ * @param line 命令行，分割时会被修改
+ * @param argv 保存参数，最多CLI_MAX_ARG_COUNT个
+ * @return 参数数量
+ */
+static int parse_args(char* line,char** argv){
+    int argc=0;
+    memset(argv,0,sizeof(char*)*CLI_MAX_ARG_COUNT);
+
+    const char* space=" ";
+    char* token=strtok(line,space);
+    while(token && argc<CLI_MAX_ARG_COUNT-1){
+        argv[argc++]=token;
+        token=strtok(NULL,space);
+    }
+    return argc;
+}
+
+/**
+ * @brief 将文件描述符fd重定向到文件描述符file上，并关闭file
+ * @param fd 标准输入或标准输出
+ * @param file 管道的一端
+ */
+static void redirect_fd(int fd,int file){
+    // 分配文件描述符时取最小的空闲项，关闭后dup即可得到fd
+    close(fd);
+    dup(file);
+    close(file);
+}
+
+/**
+ * @brief 执行用|连接的一组命令，前一个命令的标准输出通过管道连接到后一个命令的标准输入
+ * @param line 命令行
+ */
+static void run_pipeline(char* line){
+    char* cmds[CLI_MAX_PIPE_COUNT];
+    int count=0;
+
+    // 先按|切分，strtok不可重入，切分完成后再逐个解析参数
+    char* start=line;
+    for(;;){
+        if(count>=CLI_MAX_PIPE_COUNT){
+            fprintf(stderr,ESC_COLOR_ERROR"too many pipes\n"ESC_COLOR_DEFAULT);
+            return;
+        }
+
+        cmds[count++]=start;
+        char* bar=strchr(start,'|');
+        if(!bar){
+            break;
+        }
+        *bar='\0';
+        start=bar+1;
+    }
+
+    int pids[CLI_MAX_PIPE_COUNT];
+    int prev_read=-1;
+    int started=0;
+    for(int i=0;i<count;i++){
+        char* argv[CLI_MAX_ARG_COUNT];
+        int argc=parse_args(cmds[i],argv);
+        if(argc==0){
+            fprintf(stderr,ESC_COLOR_ERROR"empty command in pipe\n"ESC_COLOR_DEFAULT);
+            break;
+        }
+
+        const cli_cmd_t* cmd=find_builtin(argv[0]);
+        const char* path=cmd ? (const char*)0 : find_exec_path(argv[0]);
+        if(!cmd && !path){
+            fprintf(stderr,ESC_COLOR_ERROR"Unknown command: %s\n"ESC_COLOR_DEFAULT,argv[0]);
+            break;
+        }
+
+        int fds[2]={-1,-1};
+        if((i<count-1) && (pipe(fds)<0)){
+            fprintf(stderr,ESC_COLOR_ERROR"pipe failed\n"ESC_COLOR_DEFAULT);
+            break;
+        }
+
+        int pid=fork();
+        if(pid<0){
+            fprintf(stderr,ESC_COLOR_ERROR"fork failed %s\n"ESC_COLOR_DEFAULT,argv[0]);
+            if(fds[0]>=0){
+                close(fds[0]);
+                close(fds[1]);
+            }
+            break;
+        }
+        else if(pid==0){
+            if(prev_read>=0){
+                redirect_fd(0,prev_read);
+            }
+            if(fds[1]>=0){
+                close(fds[0]);
+                redirect_fd(1,fds[1]);
+            }
+
+            // 内置命令在子进程中执行，退出时刷新标准输出并关闭管道
+            if(cmd){
+                exit(cmd->do_func(argc,argv));
+            }
+            execve(path,argv,(char * const *)0);
+            fprintf(stderr,"exec failed %s\n",path);
+            exit(-1);
+        }
+
+        // 父进程不使用管道，必须关闭，否则读端等不到文件结束
+        if(prev_read>=0){
+            close(prev_read);
+        }
+        if(fds[1]>=0){
+            close(fds[1]);
+        }
+        prev_read=fds[0];
+        pids[started++]=pid;
+    }
+
+    if(prev_read>=0){
+        close(prev_read);
+    }
+
+    for(int i=0;i<started;i++){
+        int status=0;
+        waitpid(pids[i],&status,0);
+        if(status){
+            fprintf(stderr,"cmd %d result: %d, pid=%d\n",i,status,pids[i]);
+        }
+    }
+}
+
 /**
  * @brief 显示命令行提示词
  */
@@ -441,17 +1878,14 @@ int main(int argc,char** argv){
         }
 
 
-        int argc=0;
-        char* argv[CLI_MAX_ARG_COUNT];
-        memset(argv,0,sizeof(argv));
+        if(strchr(cli.curr_input,'|')){
+            run_pipeline(cli.curr_input);
+            continue;
+        }
 
         // 分割命令行输入的字符串,解析出命令和参数
-        const char* space=" ";
-        char* token=strtok(cli.curr_input,space);
-        while(token){
-            argv[argc++]=token;
-            token=strtok(NULL,space);
-        }
+        char* argv[CLI_MAX_ARG_COUNT];
+        int argc=parse_args(cli.curr_input,argv);
 
         if(argc==0){
             continue;
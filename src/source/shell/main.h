@@ -7,6 +7,31 @@
 /// @brief  一条命令的最大参数个数
 #define CLI_MAX_ARG_COUNT  10
 
+/// @brief 管道连接的最大命令个数
+#define CLI_MAX_PIPE_COUNT  4
+
+/// @brief ps/top命令最多显示的任务数量
+#define TASK_INFO_MAX  128
+
+/// @brief cp命令每次读写的块大小，以及一次批量系统调用处理的块数
+#define CP_CHUNK_SIZE  512
+#define CP_BATCH_NR    8
+
+/// @brief aiobench命令每个请求读取的块大小，以及默认同时进行的请求数
+#define AIO_CHUNK_SIZE  4096
+#define AIO_DEPTH       8
+
+/// @brief aiobench -t检查非法请求时每次读取的字节数
+#define AIO_CHECK_SIZE  64
+
+/// @brief sockbench命令使用的套接字名字和每次请求的消息大小
+#define SOCKBENCH_NAME  "/sock/bench"
+#define SOCKBENCH_MSG   64
+
+/// @brief prof命令默认的采样间隔毫秒数，以及默认显示的热点数
+#define PROF_PERIOD_MS  10
+#define PROF_TOP        20
+
 /**
  * @brief 根据Pn和cmd生成指定的ANSI终端转义序列命令
  * @param Pn  参数
@@ -57,5 +82,19 @@ typedef struct _cli_t{
     const char* prompt;
 }cli_t;
 
+/**
+ * @brief prof命令合并后的一项热点
+ * @param eip 内核态为函数的起始地址，用户态为采样的地址
+ * @param pid 用户态采样所属的pid
+ * @param cpl 特权级
+ * @param count 采样次数
+ */
+typedef struct _prof_entry_t{
+    uint32_t eip;
+    int pid;
+    int cpl;
+    int count;
+}prof_entry_t;
+
 
 #endif
\ No newline at end of file